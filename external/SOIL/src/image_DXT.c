@@ -19,6 +19,18 @@
 	method fails for finding the largest eigenvector	*/
 #define USE_COV_MAT	1
 
+/*	SSE2 versions of the per pixel loops, they are part of every x86-64
+	target.  They do the same float operations in the same order as the
+	scalar code, so both give bit identical output.	*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DXT_SSE2	1
+#include <emmintrin.h>
+#else
+#define DXT_SSE2	0
+#endif
+
+static int use_simd = DXT_SSE2;
+
 /********* Function Prototypes *********/
 /*
 	Takes a 4x4 block of pixels and compresses it into 8 bytes
@@ -29,6 +41,15 @@ void compress_DDS_color_block(
 				int channels,
 				const unsigned char *const uncompressed,
 				unsigned char compressed[8] );
+/*
+	Same as compress_DDS_color_block with a choice of the
+	endpoint search, quality is one of DXT_QUALITY_*.
+*/
+void compress_DDS_color_block_quality(
+				int channels,
+				const unsigned char *const uncompressed,
+				unsigned char compressed[8],
+				int quality );
 /*
 	Takes a 4x4 block of pixels and compresses the alpha
 	component it into 8 bytes for use in DXT5 DDS files.
@@ -104,11 +125,6 @@ unsigned char* convert_image_to_DXT1(
 		int *out_size )
 {
 	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*3];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0;
 	/*	error check	*/
 	*out_size = 0;
 	if( (width < 1) || (height < 1) ||
@@ -117,65 +133,13 @@ unsigned char* convert_image_to_DXT1(
 	{
 		return NULL;
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
-	if( channels < 3 )
-	{
-		chan_step = 0;
-	}
 	/*	get the RAM for the compressed image
 		(8 bytes per 4x4 pixel block)	*/
 	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 8;
 	compressed = (unsigned char*)malloc( *out_size );
 	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
-	{
-		for( i = 0; i < width; i += 4 )
-		{
-			/*	copy this block into a new one	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
-			{
-				my = height - j;
-			}
-			if( i+4 >= width )
-			{
-				mx = width - i;
-			}
-			for( y = 0; y < my; ++y )
-			{
-				for( x = 0; x < mx; ++x )
-				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-				}
-				for( x = mx; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-				}
-			}
-			for( y = my; y < 4; ++y )
-			{
-				for( x = 0; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-				}
-			}
-			/*	compress the block	*/
-			++block_count;
-			compress_DDS_color_block( 3, ublock, cblock );
-			/*	copy the data from the block into the main block	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-		}
-	}
+	compress_image_rows_to_DXT( uncompressed, width, height, channels,
+			0, DXT_QUALITY_NORMAL, 0, (height+3) >> 2, compressed );
 	return compressed;
 }
 
@@ -185,11 +149,6 @@ unsigned char* convert_image_to_DXT5(
 		int *out_size )
 {
 	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*4];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0, has_alpha;
 	/*	error check	*/
 	*out_size = 0;
 	if( (width < 1) || (height < 1) ||
@@ -198,23 +157,55 @@ unsigned char* convert_image_to_DXT5(
 	{
 		return NULL;
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B vales	*/
+	/*	get the RAM for the compressed image
+		(16 bytes per 4x4 pixel block)	*/
+	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
+	compressed = (unsigned char*)malloc( *out_size );
+	/*	go through each block	*/
+	compress_image_rows_to_DXT( uncompressed, width, height, channels,
+			1, DXT_QUALITY_NORMAL, 0, (height+3) >> 2, compressed );
+	return compressed;
+}
+
+void
+	compress_image_rows_to_DXT
+	(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int dxt5, int quality,
+		int first_block_row, int block_row_count,
+		unsigned char *compressed
+	)
+{
+	int i, j, x, y;
+	unsigned char ublock[16*4];
+	int chan_step = 1, has_alpha, block_channels;
+	int block_bytes = dxt5 ? 16 : 8;
+	int index;
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(NULL == uncompressed) || (NULL == compressed) ||
+		(channels < 1) || (channels > 4) )
+	{
+		return;
+	}
+	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
 	if( channels < 3 )
 	{
 		chan_step = 0;
 	}
 	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
 	has_alpha = 1 - (channels & 1);
-	/*	get the RAM for the compressed image
-		(16 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
-	compressed = (unsigned char*)malloc( *out_size );
+	/*	DXT1 only needs the colors, DXT5 gets RGBA blocks	*/
+	block_channels = dxt5 ? 4 : 3;
+	/*	this block row's first block in the output	*/
+	index = first_block_row * ((width+3) >> 2) * block_bytes;
 	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	for( j = first_block_row * 4; (j < height) && (j < (first_block_row + block_row_count) * 4); j += 4 )
 	{
 		for( i = 0; i < width; i += 4 )
 		{
-			/*	local variables, and my block counter	*/
+			/*	copy this block into a new one	*/
 			int idx = 0;
 			int mx = 4, my = 4;
 			if( j+4 >= height )
@@ -229,49 +220,50 @@ unsigned char* convert_image_to_DXT5(
 			{
 				for( x = 0; x < mx; ++x )
 				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-					ublock[idx++] =
-						has_alpha * uncompressed[(j+y)*width*channels+(i+x)*channels+channels-1]
-						+ (1-has_alpha)*255;
+					const unsigned char *pixel = uncompressed + (j+y)*width*channels+(i+x)*channels;
+					ublock[idx++] = pixel[0];
+					ublock[idx++] = pixel[chan_step];
+					ublock[idx++] = pixel[chan_step+chan_step];
+					if( dxt5 )
+					{
+						ublock[idx++] = has_alpha * pixel[channels-1] + (1-has_alpha)*255;
+					}
 				}
 				for( x = mx; x < 4; ++x )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
+					memcpy( ublock + idx, ublock, block_channels );
+					idx += block_channels;
 				}
 			}
 			for( y = my; y < 4; ++y )
 			{
 				for( x = 0; x < 4; ++x )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
+					memcpy( ublock + idx, ublock, block_channels );
+					idx += block_channels;
 				}
 			}
-			/*	now compress the alpha block	*/
-			compress_DDS_alpha_block( ublock, cblock );
-			/*	copy the data from the compressed alpha block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-			/*	then compress the color block	*/
-			++block_count;
-			compress_DDS_color_block( 4, ublock, cblock );
-			/*	copy the data from the compressed color block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
+			/*	DXT5 starts with the alpha block	*/
+			if( dxt5 )
 			{
-				compressed[index++] = cblock[x];
+				compress_DDS_alpha_block( ublock, compressed + index );
+				index += 8;
 			}
+			/*	compress the color block straight into the main block	*/
+			compress_DDS_color_block_quality( block_channels, ublock, compressed + index, quality );
+			index += 8;
 		}
 	}
-	return compressed;
+}
+
+int
+	enable_DXT_SIMD
+	(
+		int enable
+	)
+{
+	use_simd = enable && DXT_SSE2;
+	return DXT_SSE2;
 }
 
 /********* Helper Functions *********/
@@ -296,6 +288,94 @@ void rgb_888_from_565( unsigned int c, int *r, int *g, int *b )
 	*b = convert_bit_range( (c >> 00) & 31, 5, 8 );
 }
 
+#if DXT_SSE2
+/*	splits the 16 pixels of a block into R, G and B planes	*/
+static void block_planes_SSE2(
+		const unsigned char *const uncompressed,
+		int channels,
+		__m128i planes[3] )
+{
+	unsigned char r[16], g[16], b[16];
+	int i;
+	for( i = 0; i < 16; ++i )
+	{
+		r[i] = uncompressed[i*channels+0];
+		g[i] = uncompressed[i*channels+1];
+		b[i] = uncompressed[i*channels+2];
+	}
+	planes[0] = _mm_loadu_si128( (const __m128i*)r );
+	planes[1] = _mm_loadu_si128( (const __m128i*)g );
+	planes[2] = _mm_loadu_si128( (const __m128i*)b );
+}
+
+static int horizontal_sum_SSE2( __m128i v )
+{
+	v = _mm_add_epi32( v, _mm_shuffle_epi32( v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	v = _mm_add_epi32( v, _mm_shuffle_epi32( v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_cvtsi128_si32( v );
+}
+
+/*	sum of products of two planes of 8 bit values	*/
+static int dot_planes_SSE2( __m128i a, __m128i b )
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_madd_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+	__m128i hi = _mm_madd_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+	return horizontal_sum_SSE2( _mm_add_epi32( lo, hi ) );
+}
+
+/*	R, G, B, RR, GG, BB, RG, RB, GB sums of a block	*/
+static void color_sums_SSE2(
+		const unsigned char *const uncompressed,
+		int channels,
+		int sums[9] )
+{
+	__m128i planes[3];
+	__m128i zero = _mm_setzero_si128();
+	int i;
+	block_planes_SSE2( uncompressed, channels, planes );
+	for( i = 0; i < 3; ++i )
+	{
+		__m128i sad = _mm_sad_epu8( planes[i], zero );
+		sums[i] = _mm_cvtsi128_si32( sad ) + _mm_cvtsi128_si32( _mm_srli_si128( sad, 8 ) );
+		sums[3+i] = dot_planes_SSE2( planes[i], planes[i] );
+	}
+	sums[6] = dot_planes_SSE2( planes[0], planes[1] );
+	sums[7] = dot_planes_SSE2( planes[0], planes[2] );
+	sums[8] = dot_planes_SSE2( planes[1], planes[2] );
+}
+
+/*	widens 4 bytes of a plane (starting at quarter*4) to floats	*/
+static __m128 plane_quarter_SSE2( __m128i plane, int quarter )
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i words = (quarter < 2) ? _mm_unpacklo_epi8( plane, zero ) : _mm_unpackhi_epi8( plane, zero );
+	__m128i dwords = (quarter & 1) ? _mm_unpackhi_epi16( words, zero ) : _mm_unpacklo_epi16( words, zero );
+	return _mm_cvtepi32_ps( dwords );
+}
+
+/*	dot products of the 16 pixels with a direction, as
+	d[0]*R + d[1]*G + d[2]*B	*/
+static void block_dots_SSE2(
+		const __m128i planes[3],
+		const float direction[3],
+		__m128 dots[4] )
+{
+	__m128 dr = _mm_set1_ps( direction[0] );
+	__m128 dg = _mm_set1_ps( direction[1] );
+	__m128 db = _mm_set1_ps( direction[2] );
+	int q;
+	for( q = 0; q < 4; ++q )
+	{
+		dots[q] = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps( dr, plane_quarter_SSE2( planes[0], q ) ),
+					_mm_mul_ps( dg, plane_quarter_SSE2( planes[1], q ) ) ),
+				_mm_mul_ps( db, plane_quarter_SSE2( planes[2], q ) ) );
+	}
+}
+#endif
+
 void compute_color_line_STDEV(
 		const unsigned char *const uncompressed,
 		int channels,
@@ -308,6 +388,18 @@ void compute_color_line_STDEV(
 	float sum_rg = 0.0f, sum_rb = 0.0f, sum_gb = 0.0f;
 	/*	calculate all data needed for the covariance matrix
 		( to compare with _rygdxt code)	*/
+	#if DXT_SSE2
+	if( use_simd )
+	{
+		/*	the sums are integers below 2^24, so summing them as
+			integers and converting once is exact	*/
+		int sums[9];
+		color_sums_SSE2( uncompressed, channels, sums );
+		sum_r = (float)sums[0];	sum_g = (float)sums[1];	sum_b = (float)sums[2];
+		sum_rr = (float)sums[3];	sum_gg = (float)sums[4];	sum_bb = (float)sums[5];
+		sum_rg = (float)sums[6];	sum_rb = (float)sums[7];	sum_gb = (float)sums[8];
+	} else
+	#endif
 	for( i = 0; i < 16*channels; i += channels )
 	{
 		sum_r += uncompressed[i+0];
@@ -438,6 +530,23 @@ void LSE_master_colors_max_min(
 				sum_x2[2] * uncompressed[2]
 			);
 	dot_min = dot_max;
+	#if DXT_SSE2
+	if( use_simd )
+	{
+		__m128i planes[3];
+		__m128 dots[4], lo, hi;
+		block_planes_SSE2( uncompressed, channels, planes );
+		block_dots_SSE2( planes, sum_x2, dots );
+		lo = _mm_min_ps( _mm_min_ps( dots[0], dots[1] ), _mm_min_ps( dots[2], dots[3] ) );
+		hi = _mm_max_ps( _mm_max_ps( dots[0], dots[1] ), _mm_max_ps( dots[2], dots[3] ) );
+		lo = _mm_min_ps( lo, _mm_shuffle_ps( lo, lo, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		hi = _mm_max_ps( hi, _mm_shuffle_ps( hi, hi, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		lo = _mm_min_ps( lo, _mm_shuffle_ps( lo, lo, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		hi = _mm_max_ps( hi, _mm_shuffle_ps( hi, hi, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		dot_min = _mm_cvtss_f32( lo );
+		dot_max = _mm_cvtss_f32( hi );
+	} else
+	#endif
 	for( i = 1; i < 16; ++i )
 	{
 		dot =
@@ -498,8 +607,79 @@ void LSE_master_colors_max_min(
 }
 
 void
-	compress_DDS_color_block
+	box_master_colors_max_min
+	(
+		int *cmax, int *cmin,
+		int channels,
+		const unsigned char *const uncompressed
+	)
+{
+	/*	the corners of the color bounding box, pulled in by 1/16th
+		of its size so outliers don't waste the endpoint precision
+		(van Waveren, "Real-Time DXT Compression")	*/
+	int i, j, inset;
+	int lo[3], hi[3];
+	#if DXT_SSE2
+	if( use_simd )
+	{
+		__m128i planes[3];
+		block_planes_SSE2( uncompressed, channels, planes );
+		for( j = 0; j < 3; ++j )
+		{
+			__m128i mn = planes[j], mx = planes[j];
+			mn = _mm_min_epu8( mn, _mm_srli_si128( mn, 8 ) );
+			mx = _mm_max_epu8( mx, _mm_srli_si128( mx, 8 ) );
+			mn = _mm_min_epu8( mn, _mm_srli_si128( mn, 4 ) );
+			mx = _mm_max_epu8( mx, _mm_srli_si128( mx, 4 ) );
+			mn = _mm_min_epu8( mn, _mm_srli_si128( mn, 2 ) );
+			mx = _mm_max_epu8( mx, _mm_srli_si128( mx, 2 ) );
+			mn = _mm_min_epu8( mn, _mm_srli_si128( mn, 1 ) );
+			mx = _mm_max_epu8( mx, _mm_srli_si128( mx, 1 ) );
+			lo[j] = _mm_cvtsi128_si32( mn ) & 255;
+			hi[j] = _mm_cvtsi128_si32( mx ) & 255;
+		}
+	} else
+	#endif
+	for( i = 0; i < 16; ++i )
+	{
+		for( j = 0; j < 3; ++j )
+		{
+			int c = uncompressed[i*channels+j];
+			if( i == 0 )
+			{
+				lo[j] = hi[j] = c;
+			} else if( c < lo[j] )
+			{
+				lo[j] = c;
+			} else if( c > hi[j] )
+			{
+				hi[j] = c;
+			}
+		}
+	}
+	for( j = 0; j < 3; ++j )
+	{
+		inset = (hi[j] - lo[j]) >> 4;
+		lo[j] += inset;
+		hi[j] -= inset;
+	}
+	i = rgb_to_565( hi[0], hi[1], hi[2] );
+	j = rgb_to_565( lo[0], lo[1], lo[2] );
+	if( i > j )
+	{
+		*cmax = i;
+		*cmin = j;
+	} else
+	{
+		*cmax = j;
+		*cmin = i;
+	}
+}
+
+void
+	encode_DDS_color_block
 	(
+		int enc_c0, int enc_c1,
 		int channels,
 		const unsigned char *const uncompressed,
 		unsigned char compressed[8]
@@ -508,14 +688,12 @@ void
 	/*	variables	*/
 	int i;
 	int next_bit;
-	int enc_c0, enc_c1;
 	int c0[4], c1[4];
+	int values[16];
 	float color_line[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	float vec_len2 = 0.0f, dot_offset = 0.0f;
 	/*	stupid order	*/
 	int swizzle4[] = { 0, 2, 3, 1 };
-	/*	get the master colors	*/
-	LSE_master_colors_max_min( &enc_c0, &enc_c1, channels, uncompressed );
 	/*	store the 565 color 0 and color 1	*/
 	compressed[0] = (enc_c0 >> 0) & 255;
 	compressed[1] = (enc_c0 >> 8) & 255;
@@ -546,8 +724,37 @@ void
 	color_line[2] *= vec_len2;
 	/*	compute the offset (constant) portion of the dot product	*/
 	dot_offset = color_line[0]*c0[0] + color_line[1]*c0[1] + color_line[2]*c0[2];
-	/*	store the rest of the bits	*/
-	next_bit = 8*4;
+	/*	place every color on the line and map it to [0,3]	*/
+	#if DXT_SSE2
+	if( use_simd )
+	{
+		__m128i planes[3];
+		__m128 dots[4];
+		__m128 offset = _mm_set1_ps( dot_offset );
+		__m128i indices[2];
+		block_planes_SSE2( uncompressed, channels, planes );
+		block_dots_SSE2( planes, color_line, dots );
+		for( i = 0; i < 2; ++i )
+		{
+			/*	truncate like the (int) cast, then clamp in 16 bits	*/
+			__m128i a = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps(
+					_mm_sub_ps( dots[i*2+0], offset ), _mm_set1_ps( 3.0f ) ), _mm_set1_ps( 0.5f ) ) );
+			__m128i b = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps(
+					_mm_sub_ps( dots[i*2+1], offset ), _mm_set1_ps( 3.0f ) ), _mm_set1_ps( 0.5f ) ) );
+			indices[i] = _mm_min_epi16( _mm_max_epi16( _mm_packs_epi32( a, b ),
+					_mm_setzero_si128() ), _mm_set1_epi16( 3 ) );
+		}
+		{
+			short lanes[16];
+			_mm_storeu_si128( (__m128i*)lanes, indices[0] );
+			_mm_storeu_si128( (__m128i*)(lanes + 8), indices[1] );
+			for( i = 0; i < 16; ++i )
+			{
+				values[i] = lanes[i];
+			}
+		}
+	} else
+	#endif
 	for( i = 0; i < 16; ++i )
 	{
 		/*	find the dot product of this color, to place it on the line
@@ -567,13 +774,145 @@ void
 		{
 			next_value = 0;
 		}
+		values[i] = next_value;
+	}
+	/*	store the rest of the bits	*/
+	next_bit = 8*4;
+	for( i = 0; i < 16; ++i )
+	{
 		/*	OK, store this value	*/
-		compressed[next_bit >> 3] |= swizzle4[ next_value ] << (next_bit & 7);
+		compressed[next_bit >> 3] |= swizzle4[ values[i] ] << (next_bit & 7);
 		next_bit += 2;
 	}
 	/*	done compressing to DXT1	*/
 }
 
+int
+	DDS_color_block_error
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		const unsigned char compressed[8]
+	)
+{
+	/*	squared RGB error of the decoded block	*/
+	int palette[4][3];
+	int i, j, error = 0;
+	rgb_888_from_565( compressed[0] | (compressed[1] << 8), &palette[0][0], &palette[0][1], &palette[0][2] );
+	rgb_888_from_565( compressed[2] | (compressed[3] << 8), &palette[1][0], &palette[1][1], &palette[1][2] );
+	for( j = 0; j < 3; ++j )
+	{
+		palette[2][j] = (2*palette[0][j] + palette[1][j]) / 3;
+		palette[3][j] = (palette[0][j] + 2*palette[1][j]) / 3;
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		int code = (compressed[4 + (i >> 2)] >> ((i & 3) * 2)) & 3;
+		for( j = 0; j < 3; ++j )
+		{
+			int d = palette[code][j] - uncompressed[i*channels+j];
+			error += d * d;
+		}
+	}
+	return error;
+}
+
+int
+	refine_master_colors
+	(
+		int *cmax, int *cmin,
+		int channels,
+		const unsigned char *const uncompressed,
+		const unsigned char compressed[8]
+	)
+{
+	/*	least squares fit of the two endpoints to the colors, with the
+		position of every color on the line taken from its index:
+		minimize sum |(1-t)*c0 + t*c1 - color|^2	*/
+	const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f, det;
+	float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+	int c0[3], c1[3];
+	int i, j;
+	for( i = 0; i < 16; ++i )
+	{
+		int code = (compressed[4 + (i >> 2)] >> ((i & 3) * 2)) & 3;
+		float t = weights[code], s = 1.0f - t;
+		aa += s * s;
+		ab += s * t;
+		bb += t * t;
+		for( j = 0; j < 3; ++j )
+		{
+			ax[j] += s * uncompressed[i*channels+j];
+			bx[j] += t * uncompressed[i*channels+j];
+		}
+	}
+	det = aa * bb - ab * ab;
+	if( fabs( det ) < 1e-6f )
+	{
+		/*	every color got the same index, nothing to fit	*/
+		return 0;
+	}
+	det = 1.0f / det;
+	for( j = 0; j < 3; ++j )
+	{
+		c0[j] = (int)(0.5f + (ax[j] * bb - bx[j] * ab) * det);
+		c1[j] = (int)(0.5f + (bx[j] * aa - ax[j] * ab) * det);
+		c0[j] = c0[j] < 0 ? 0 : (c0[j] > 255 ? 255 : c0[j]);
+		c1[j] = c1[j] < 0 ? 0 : (c1[j] > 255 ? 255 : c1[j]);
+	}
+	i = rgb_to_565( c0[0], c0[1], c0[2] );
+	j = rgb_to_565( c1[0], c1[1], c1[2] );
+	/*	4 color mode needs color 0 > color 1, encoding redoes the indices	*/
+	*cmax = i > j ? i : j;
+	*cmin = i > j ? j : i;
+	return 1;
+}
+
+void
+	compress_DDS_color_block
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		unsigned char compressed[8]
+	)
+{
+	compress_DDS_color_block_quality( channels, uncompressed, compressed, DXT_QUALITY_NORMAL );
+}
+
+void
+	compress_DDS_color_block_quality
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		unsigned char compressed[8],
+		int quality
+	)
+{
+	int enc_c0, enc_c1;
+	/*	get the master colors	*/
+	if( quality <= DXT_QUALITY_FAST )
+	{
+		box_master_colors_max_min( &enc_c0, &enc_c1, channels, uncompressed );
+	} else
+	{
+		LSE_master_colors_max_min( &enc_c0, &enc_c1, channels, uncompressed );
+	}
+	encode_DDS_color_block( enc_c0, enc_c1, channels, uncompressed, compressed );
+	/*	refit the endpoints to the chosen indices, keep it if that helps	*/
+	if( (quality >= DXT_QUALITY_HIGH) &&
+		refine_master_colors( &enc_c0, &enc_c1, channels, uncompressed, compressed ) )
+	{
+		unsigned char refined[8];
+		encode_DDS_color_block( enc_c0, enc_c1, channels, uncompressed, refined );
+		if( DDS_color_block_error( channels, uncompressed, refined ) <
+			DDS_color_block_error( channels, uncompressed, compressed ) )
+		{
+			memcpy( compressed, refined, 8 );
+		}
+	}
+}
+
 void
 	compress_DDS_alpha_block
 	(
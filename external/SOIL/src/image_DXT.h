@@ -10,6 +10,10 @@
 #ifndef HEADER_IMAGE_DXT
 #define HEADER_IMAGE_DXT
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
 	Converts an image from an array of unsigned chars (RGB or RGBA) to
 	DXT1 or DXT5, then saves the converted image to disk.
@@ -45,6 +49,40 @@ convert_image_to_DXT5
     int *out_size
 );
 
+/**	Quality / speed trade off of the color block encoder	**/
+#define DXT_QUALITY_FAST	0	/* endpoints from the bounding box of the block's colors */
+#define DXT_QUALITY_NORMAL	1	/* endpoints along the principal axis of the colors (convert_image_to_DXT1/5) */
+#define DXT_QUALITY_HIGH	2	/* principal axis, refined by a least squares fit to the chosen indices */
+
+/**
+	Compresses the 4x4 block rows [first_block_row, first_block_row + block_row_count)
+	of an image to DXT1 (8 bytes per block) or, if dxt5 is not 0, DXT5 (16 bytes per block).
+	compressed has to hold the whole image: every block goes to the same place
+	convert_image_to_DXT1/5 put it, so different threads can compress different
+	block rows into one buffer.  With DXT_QUALITY_NORMAL the output is exactly
+	that of convert_image_to_DXT1/5.
+**/
+void
+compress_image_rows_to_DXT
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int dxt5, int quality,
+    int first_block_row, int block_row_count,
+    unsigned char *compressed
+);
+
+/**
+	Turns the SSE2 versions of the encoder loops on or off (on by default).
+	Both give the same output, this is for testing and benchmarking.
+	\return 1 if the SSE2 versions were compiled in
+**/
+int
+enable_DXT_SIMD
+(
+    int enable
+);
+
 /**	A bunch of DirectDraw Surface structures and flags **/
 typedef struct
 {
@@ -120,4 +158,8 @@ DDS_header ;
 #define DDSCAPS2_CUBEMAP_NEGATIVEZ	0x00008000
 #define DDSCAPS2_VOLUME	0x00200000
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* HEADER_IMAGE_DXT	*/
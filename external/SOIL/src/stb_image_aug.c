@@ -14,6 +14,7 @@
       writes BMP,TGA (define STBI_NO_WRITE to remove code)
       decoded from memory or through stdio FILE (define STBI_NO_STDIO to remove code)
       supports installable dequantizing-IDCT, YCbCr-to-RGB conversion (define STBI_SIMD)
+      SSE2 IDCT, YCbCr-to-RGB conversion and PNG unfiltering built in (see stbi_enable_SIMD)
 
    TODO:
       stbi_info_*
@@ -98,6 +99,24 @@ typedef unsigned int   uint;
 // should produce compiler error if size is wrong
 typedef unsigned char validate_uint32[sizeof(uint32)==4];
 
+// SSE2 versions of the JPEG IDCT and YCbCr->RGB conversion and of the PNG
+// unfiltering, part of every x86-64 target. They produce the same bytes as
+// the scalar code; stbi_enable_SIMD switches between them at runtime.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STBI_SSE2 1
+#include <emmintrin.h>
+#else
+#define STBI_SSE2 0
+#endif
+
+static int stbi_simd = STBI_SSE2;
+
+int stbi_enable_SIMD(int enable)
+{
+   stbi_simd = enable && STBI_SSE2;
+   return STBI_SSE2;
+}
+
 #if defined(STBI_NO_STDIO) && !defined(STBI_NO_WRITE)
 #define STBI_NO_WRITE
 #endif
@@ -870,6 +889,121 @@ __forceinline static uint8 clamp(int x)
    t1 += p2+p4;                                \
    t0 += p1+p3;
 
+#if STBI_SSE2
+// IDCT_1D on 8 lanes at once. Every product is expanded into _mm_madd_epi16
+// pairs of the 16 bit inputs with the constants summed up, e.g. t2 = p1 + p3*c
+// becomes s2*c1 + s6*(c1+c). Integer math gives the same 32 bit results as the
+// scalar macro as long as the inputs fit 16 bits.
+#define PAIR(a,b)  _mm_setr_epi16((short) (a),(short) (b),(short) (a),(short) (b),(short) (a),(short) (b),(short) (a),(short) (b))
+
+// one half (4 lanes): 'sXY' are the inputs X and Y interleaved; writes the 8
+// outputs (x + bias) >> shift in 32 bit lanes, in the scalar code's order
+static void idct_1d_half_sse2(__m128i out[8], __m128i s04, __m128i s26, __m128i s71, __m128i s53, __m128i bias, __m128i shift)
+{
+   __m128i t0,t1,t2,t3,x0,x1,x2,x3,o0,o1,o2,o3;
+   // even part
+   t2 = _mm_madd_epi16(s26, PAIR(f2f(0.5411961f), f2f(0.5411961f) + f2f(-1.847759065f)));
+   t3 = _mm_madd_epi16(s26, PAIR(f2f(0.5411961f) + f2f(0.765366865f), f2f(0.5411961f)));
+   t0 = _mm_madd_epi16(s04, PAIR(fsh(1), fsh(1)));
+   t1 = _mm_madd_epi16(s04, PAIR(fsh(1), -fsh(1)));
+   x0 = _mm_add_epi32(_mm_add_epi32(t0, t3), bias);
+   x3 = _mm_add_epi32(_mm_sub_epi32(t0, t3), bias);
+   x1 = _mm_add_epi32(_mm_add_epi32(t1, t2), bias);
+   x2 = _mm_add_epi32(_mm_sub_epi32(t1, t2), bias);
+   // odd part, p5 and the p1..p4 terms folded into each output's constants
+   #define P5  f2f( 1.175875602f)
+   #define P1  f2f(-0.899976223f)
+   #define P2  f2f(-2.562915447f)
+   #define P3  f2f(-1.961570560f)
+   #define P4  f2f(-0.390180644f)
+   o0 = _mm_add_epi32(_mm_madd_epi16(s71, PAIR(f2f(0.298631336f) + P5 + P1 + P3, P5 + P1)), _mm_madd_epi16(s53, PAIR(P5, P5 + P3)));
+   o1 = _mm_add_epi32(_mm_madd_epi16(s71, PAIR(P5, P5 + P4)), _mm_madd_epi16(s53, PAIR(f2f(2.053119869f) + P5 + P2 + P4, P5 + P2)));
+   o2 = _mm_add_epi32(_mm_madd_epi16(s71, PAIR(P5 + P3, P5)), _mm_madd_epi16(s53, PAIR(P5 + P2, f2f(3.072711026f) + P5 + P2 + P3)));
+   o3 = _mm_add_epi32(_mm_madd_epi16(s71, PAIR(P5 + P1, f2f(1.501321110f) + P5 + P1 + P4)), _mm_madd_epi16(s53, PAIR(P5 + P4, P5)));
+   #undef P5
+   #undef P1
+   #undef P2
+   #undef P3
+   #undef P4
+   out[0] = _mm_sra_epi32(_mm_add_epi32(x0, o3), shift);
+   out[7] = _mm_sra_epi32(_mm_sub_epi32(x0, o3), shift);
+   out[1] = _mm_sra_epi32(_mm_add_epi32(x1, o2), shift);
+   out[6] = _mm_sra_epi32(_mm_sub_epi32(x1, o2), shift);
+   out[2] = _mm_sra_epi32(_mm_add_epi32(x2, o1), shift);
+   out[5] = _mm_sra_epi32(_mm_sub_epi32(x2, o1), shift);
+   out[3] = _mm_sra_epi32(_mm_add_epi32(x3, o0), shift);
+   out[4] = _mm_sra_epi32(_mm_sub_epi32(x3, o0), shift);
+}
+#undef PAIR
+
+// IDCT_1D on the 8 lanes of in[0..7]; out[k] is output k packed back to 16
+// bits. Returns 0 if that doesn't fit.
+static int idct_1d_sse2(__m128i out[8], __m128i in[8], int bias, int shift)
+{
+   __m128i lo[8], hi[8], b = _mm_set1_epi32(bias), sh = _mm_cvtsi32_si128(shift), fits = _mm_set1_epi32(-1);
+   int k;
+   idct_1d_half_sse2(lo, _mm_unpacklo_epi16(in[0], in[4]), _mm_unpacklo_epi16(in[2], in[6]),
+                         _mm_unpacklo_epi16(in[7], in[1]), _mm_unpacklo_epi16(in[5], in[3]), b, sh);
+   idct_1d_half_sse2(hi, _mm_unpackhi_epi16(in[0], in[4]), _mm_unpackhi_epi16(in[2], in[6]),
+                         _mm_unpackhi_epi16(in[7], in[1]), _mm_unpackhi_epi16(in[5], in[3]), b, sh);
+   for (k=0; k < 8; ++k) {
+      out[k] = _mm_packs_epi32(lo[k], hi[k]);
+      // unpacking with sign extension has to give the 32 bit values back
+      fits = _mm_and_si128(fits, _mm_cmpeq_epi32(lo[k], _mm_srai_epi32(_mm_unpacklo_epi16(out[k], out[k]), 16)));
+      fits = _mm_and_si128(fits, _mm_cmpeq_epi32(hi[k], _mm_srai_epi32(_mm_unpackhi_epi16(out[k], out[k]), 16)));
+   }
+   return _mm_movemask_epi8(fits) == 0xffff;
+}
+
+static void transpose_8x16_sse2(__m128i m[8])
+{
+   __m128i a0,a1,a2,a3,a4,a5,a6,a7,b0,b1,b2,b3,b4,b5,b6,b7;
+   a0 = _mm_unpacklo_epi16(m[0], m[1]); a1 = _mm_unpackhi_epi16(m[0], m[1]);
+   a2 = _mm_unpacklo_epi16(m[2], m[3]); a3 = _mm_unpackhi_epi16(m[2], m[3]);
+   a4 = _mm_unpacklo_epi16(m[4], m[5]); a5 = _mm_unpackhi_epi16(m[4], m[5]);
+   a6 = _mm_unpacklo_epi16(m[6], m[7]); a7 = _mm_unpackhi_epi16(m[6], m[7]);
+   b0 = _mm_unpacklo_epi32(a0, a2); b1 = _mm_unpackhi_epi32(a0, a2);
+   b2 = _mm_unpacklo_epi32(a1, a3); b3 = _mm_unpackhi_epi32(a1, a3);
+   b4 = _mm_unpacklo_epi32(a4, a6); b5 = _mm_unpackhi_epi32(a4, a6);
+   b6 = _mm_unpacklo_epi32(a5, a7); b7 = _mm_unpackhi_epi32(a5, a7);
+   m[0] = _mm_unpacklo_epi64(b0, b4); m[1] = _mm_unpackhi_epi64(b0, b4);
+   m[2] = _mm_unpacklo_epi64(b1, b5); m[3] = _mm_unpackhi_epi64(b1, b5);
+   m[4] = _mm_unpacklo_epi64(b2, b6); m[5] = _mm_unpackhi_epi64(b2, b6);
+   m[6] = _mm_unpacklo_epi64(b3, b7); m[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// idct_block with the columns, then the rows, 8 at a time. Returns 0 without
+// writing anything if a block has values beyond 16 bits (only corrupt or
+// extreme data), which the scalar code handles.
+static int idct_block_sse2(uint8 *out, int out_stride, short data[64], uint8 *dequantize)
+{
+   __m128i m[8], zero = _mm_setzero_si128(), fits = _mm_set1_epi16(-1);
+   int i;
+   // dequantize, the products have to fit 16 bits
+   for (i=0; i < 8; ++i) {
+      __m128i d = _mm_loadu_si128((__m128i *) (data + i*8));
+      __m128i q = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) (dequantize + i*8)), zero);
+      m[i] = _mm_mullo_epi16(d, q);
+      fits = _mm_and_si128(fits, _mm_cmpeq_epi16(_mm_mulhi_epi16(d, q), _mm_srai_epi16(m[i], 15)));
+   }
+   if (_mm_movemask_epi8(fits) != 0xffff) return 0;
+   // columns: lane i of m[k] is row k of column i, keep 2 extra bits of precision
+   if (!idct_1d_sse2(m, m, 512, 10)) return 0;
+   // rows: the same with the block transposed, 1<<17 to remove as in the scalar code
+   transpose_8x16_sse2(m);
+   if (!idct_1d_sse2(m, m, 65536, 17)) return 0;
+   transpose_8x16_sse2(m);
+   for (i=0; i < 8; i += 2) {
+      // + 128 and clamp to 0..255 through saturation
+      __m128i bias = _mm_set1_epi16(128);
+      __m128i p = _mm_packus_epi16(_mm_adds_epi16(m[i], bias), _mm_adds_epi16(m[i+1], bias));
+      _mm_storel_epi64((__m128i *) (out + out_stride*i), p);
+      _mm_storel_epi64((__m128i *) (out + out_stride*(i+1)), _mm_unpackhi_epi64(p, p));
+   }
+   return 1;
+}
+#endif
+
 #if !STBI_SIMD
 // .344 seconds on 3*anemones.jpg
 static void idct_block(uint8 *out, int out_stride, short data[64], uint8 *dequantize)
@@ -878,6 +1012,10 @@ static void idct_block(uint8 *out, int out_stride, short data[64], uint8 *dequan
    uint8 *o,*dq = dequantize;
    short *d = data;
 
+   #if STBI_SSE2
+   if (stbi_simd && idct_block_sse2(out, out_stride, data, dequantize)) return;
+   #endif
+
    // columns
    for (i=0; i < 8; ++i,++d,++dq, ++v) {
       // if all zeroes, shortcut -- this avoids dequantizing 0s and IDCTing
@@ -1382,10 +1520,71 @@ static uint8 *resample_row_generic(uint8 *out, uint8 *in_near, uint8 *in_far, in
 
 // 0.38 seconds on 3*anemones.jpg   (0.25 with processor = Pro)
 // VC6 without processor=Pro is generating multiple LEAs per multiply!
+#if STBI_SSE2
+// YCbCr_to_RGB_row for 8 pixels at a time, returns how many it did. The
+// constants are split into a multiple of 65536, added to the upper 16 bits of
+// y_fixed, and a remainder that fits _mm_madd_epi16, so the 32 bit sums are
+// the scalar code's.
+static int YCbCr_to_RGB_sse2(uint8 *out, uint8 *y, uint8 *pcb, uint8 *pcr, int count, int step)
+{
+   __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi16(128), round = _mm_set1_epi32(32768);
+   __m128i r_const = _mm_setr_epi16((short) (float2fixed(1.40200f) - 65536), 0, (short) (float2fixed(1.40200f) - 65536), 0,
+                                    (short) (float2fixed(1.40200f) - 65536), 0, (short) (float2fixed(1.40200f) - 65536), 0);
+   __m128i g_const = _mm_setr_epi16((short) (65536 - float2fixed(0.71414f)), (short) -float2fixed(0.34414f),
+                                    (short) (65536 - float2fixed(0.71414f)), (short) -float2fixed(0.34414f),
+                                    (short) (65536 - float2fixed(0.71414f)), (short) -float2fixed(0.34414f),
+                                    (short) (65536 - float2fixed(0.71414f)), (short) -float2fixed(0.34414f));
+   __m128i b_const = _mm_setr_epi16(0, (short) (float2fixed(1.77200f) - 131072), 0, (short) (float2fixed(1.77200f) - 131072),
+                                    0, (short) (float2fixed(1.77200f) - 131072), 0, (short) (float2fixed(1.77200f) - 131072));
+   int i;
+   for (i=0; i+8 <= count; i += 8) {
+      __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) (y + i)), zero);
+      __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) (pcb + i)), zero), bias);
+      __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) (pcr + i)), zero), bias);
+      __m128i crcb_lo = _mm_unpacklo_epi16(cr, cb), crcb_hi = _mm_unpackhi_epi16(cr, cb);
+      // upper 16 bits: y plus the multiples of 65536
+      __m128i r_up = _mm_add_epi16(yy, cr);
+      __m128i g_up = _mm_sub_epi16(yy, cr);
+      __m128i b_up = _mm_add_epi16(yy, _mm_add_epi16(cb, cb));
+      __m128i r, g, b, rg, ba, pixels[2];
+      #define CHANNEL(up, c) \
+         _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(zero, up), round), _mm_madd_epi16(crcb_lo, c)), 16), \
+                         _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(zero, up), round), _mm_madd_epi16(crcb_hi, c)), 16))
+      r = CHANNEL(r_up, r_const);
+      g = CHANNEL(g_up, g_const);
+      b = CHANNEL(b_up, b_const);
+      #undef CHANNEL
+      // clamp to 0..255 through saturation and interleave with 255 as the 4th
+      rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+      ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_set1_epi8((char) 255));
+      pixels[0] = _mm_unpacklo_epi16(rg, ba);
+      pixels[1] = _mm_unpackhi_epi16(rg, ba);
+      if (step == 4) {
+         _mm_storeu_si128((__m128i *) out, pixels[0]);
+         _mm_storeu_si128((__m128i *) (out + 16), pixels[1]);
+      } else {
+         // 4 bytes a pixel too, the next one overwrites the 4th as in the scalar code
+         uint8 *p = (uint8 *) pixels;
+         int k;
+         for (k=0; k < 8; ++k)
+            memcpy(out + k*step, p + k*4, 4);
+      }
+      out += 8*step;
+   }
+   return i;
+}
+#endif
+
 static void YCbCr_to_RGB_row(uint8 *out, uint8 *y, uint8 *pcb, uint8 *pcr, int count, int step)
 {
-   int i;
-   for (i=0; i < count; ++i) {
+   int i = 0;
+   #if STBI_SSE2
+   if (stbi_simd) {
+      i = YCbCr_to_RGB_sse2(out, y, pcb, pcr, count, step);
+      out += i*step;
+   }
+   #endif
+   for (; i < count; ++i) {
       int y_fixed = (y[i] << 16) + 32768; // rounding
       int r,g,b;
       int cr = pcr[i] - 128;
@@ -2075,6 +2274,101 @@ static int paeth(int a, int b, int c)
    return c;
 }
 
+#if STBI_SSE2
+// pixels move as 4 bytes; with 3 components the 4th is the next pixel's first,
+// which gets overwritten in turn. Only the last pixel of a row is copied
+// exactly, so nothing is read or written past the buffers.
+static __m128i load_pixel_sse2(uint8 const *p)
+{
+   int v;
+   memcpy(&v, p, 4);
+   return _mm_cvtsi32_si128(v);
+}
+
+static void store_pixel_sse2(uint8 *p, __m128i x)
+{
+   int v = _mm_cvtsi128_si32(x);
+   memcpy(p, &v, 4);
+}
+
+// paeth's predictor for the components of a, b and c (in 16 bit lanes),
+// picked without branches
+static __m128i paeth_sse2(__m128i a, __m128i b, __m128i c)
+{
+   // pa = |b-c|, pb = |a-c|, pc = |a+b-2c|
+   __m128i zero = _mm_setzero_si128(), not_a, not_b;
+   __m128i pa = _mm_sub_epi16(b, c);
+   __m128i pb = _mm_sub_epi16(a, c);
+   __m128i pc = _mm_add_epi16(pa, pb);
+   pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+   pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+   pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+   // a if pa <= pb && pa <= pc, else b if pb <= pc, else c
+   not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+   not_b = _mm_cmpgt_epi16(pb, pc);
+   b = _mm_or_si128(_mm_and_si128(not_b, c), _mm_andnot_si128(not_b, b));
+   return _mm_or_si128(_mm_and_si128(not_a, b), _mm_andnot_si128(not_a, a));
+}
+
+// reverses F_sub, F_up, F_avg or F_paeth for the 'count' pixels of 3 or 4
+// components after the first one of a row. Up has no dependency between
+// pixels and goes 16 bytes at a time; sub, avg and paeth depend on the pixel
+// before, so those go a pixel at a time with its components in parallel.
+static void unfilter_row_sse2(int filter, uint8 *raw, uint8 *cur, uint8 *prior, uint32 count, int img_n, int out_n)
+{
+   __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1);
+   __m128i alpha = _mm_cvtsi32_si128(img_n != out_n ? (int) (0xffu << (8*img_n)) : 0);
+   __m128i a = load_pixel_sse2(cur - out_n), b, c = zero, x;
+   uint8 last[4];
+   uint32 i;
+   if (filter == F_paeth) // the first row has no prior, but no paeth either
+      c = _mm_unpacklo_epi8(load_pixel_sse2(prior - out_n), zero);
+   if (filter == F_up && img_n == out_n) {
+      uint32 n = count * img_n;
+      for (i=0; i+16 <= n; i += 16)
+         _mm_storeu_si128((__m128i *) (cur + i), _mm_add_epi8(_mm_loadu_si128((__m128i *) (raw + i)), _mm_loadu_si128((__m128i *) (prior + i))));
+      for (; i < n; ++i)
+         cur[i] = raw[i] + prior[i];
+      return;
+   }
+   #define PIXELS(f) \
+      for (i=0; i < count; ++i, raw += img_n, cur += out_n, prior += out_n) { \
+         if (i+1 == count) { \
+            memcpy(last, raw, img_n); \
+            raw = last; \
+         } \
+         x = load_pixel_sse2(raw); \
+         f; \
+         x = _mm_or_si128(x, alpha); \
+         if (i+1 == count) { \
+            store_pixel_sse2(last, x); \
+            memcpy(cur, last, out_n); \
+         } else \
+            store_pixel_sse2(cur, x); \
+         a = x; \
+      }
+   switch (filter) {
+      case F_sub:
+         PIXELS(x = _mm_add_epi8(x, a))
+         break;
+      case F_up:
+         PIXELS(x = _mm_add_epi8(x, load_pixel_sse2(prior)))
+         break;
+      case F_avg:
+         // (a + b) >> 1, _mm_avg_epu8 rounds up
+         PIXELS(b = load_pixel_sse2(prior);
+                x = _mm_add_epi8(x, _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one))))
+         break;
+      case F_paeth:
+         PIXELS(b = _mm_unpacklo_epi8(load_pixel_sse2(prior), zero);
+                x = _mm_add_epi8(x, _mm_packus_epi16(paeth_sse2(_mm_unpacklo_epi8(a, zero), b, c), zero));
+                c = b)
+         break;
+   }
+   #undef PIXELS
+}
+#endif
+
 // create the png data from post-deflated data
 static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
 {
@@ -2109,6 +2403,13 @@ static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
       raw += img_n;
       cur += out_n;
       prior += out_n;
+      #if STBI_SSE2
+      if (stbi_simd && (img_n == 3 || img_n == 4) && filter >= F_sub && filter <= F_paeth) {
+         unfilter_row_sse2(filter, raw, cur, prior, s->img_x-1, img_n, out_n);
+         raw += img_n * (s->img_x-1);
+         continue;
+      }
+      #endif
       // this is a little gross, so that we don't switch per-pixel or per-component
       if (img_n == out_n) {
          #define CASE(f) \
@@ -325,6 +325,12 @@ typedef struct
 // NOT THREADSAFE
 extern int stbi_register_loader(stbi_loader *loader);
 
+// turns the built in SSE2 versions of the JPEG IDCT, YCbCr->RGB conversion and
+// PNG unfiltering on or off (on by default). Both give the same output, this is
+// for testing and benchmarking. Returns 1 if the SSE2 versions were compiled in.
+// NOT THREADSAFE
+extern int stbi_enable_SIMD(int enable);
+
 // define faster low-level operations (typically SIMD support)
 #if STBI_SIMD
 typedef void (*stbi_idct_8x8)(uint8 *out, int out_stride, short data[64], unsigned short *dequantize);
@@ -0,0 +1,162 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Automatic exposure from a histogram of the scene's log luminance, replacing a hand tuned 'exposure' uniform.
+// Input is the mipmapped log2 luminance written by the bloom chain (BloomRenderer::LuminanceTexture()); a small
+// mip level (at most MaxSamples texels a side) is copied into one of a ring of pixel buffer objects and read back
+// LATENCY - 1 frames later, guarded by a fence, so the CPU never waits on the GPU. From the histogram the darkest
+// LowPercentile and brightest 1 - HighPercentile of the samples are dropped (black backgrounds and light sources
+// shouldn't drive the exposure) and the rest is averaged. The exposure then adapts to that average over time,
+// faster towards bright than towards dark like the eye, and maps it to middle grey (KeyValue).
+class AutoExposure
+{
+public:
+    // Histogram range in log2 luminance, samples outside are clamped into the outer bins
+    GLfloat MinLogLuminance, MaxLogLuminance;
+    GLfloat LowPercentile, HighPercentile;
+    GLfloat SpeedUp, SpeedDown;  // Adaptation rates per second towards a brighter and a darker scene
+    GLfloat KeyValue;            // Luminance the adapted average is mapped to
+    GLfloat Compensation;        // Exposure bias in stops
+    GLfloat MinExposure, MaxExposure;
+    GLuint MaxSamples;
+    // Current state
+    GLfloat Exposure;
+    GLfloat TargetLuminance;     // Histogram average of the last read back frame
+    GLfloat AdaptedLuminance;
+
+    AutoExposure(GLuint maxSamples = 64)
+        : MinLogLuminance(-10.0f), MaxLogLuminance(6.0f), LowPercentile(0.5f), HighPercentile(0.95f), SpeedUp(3.0f), SpeedDown(1.0f),
+          KeyValue(0.18f), Compensation(0.0f), MinExposure(0.05f), MaxExposure(20.0f), MaxSamples(maxSamples),
+          Exposure(1.0f), TargetLuminance(KeyValue), AdaptedLuminance(KeyValue), frame(0), adapted(GL_FALSE)
+    {
+        glGenBuffers(LATENCY, this->pbos);
+        for (GLuint i = 0; i < LATENCY; i++)
+        {
+            this->fences[i] = 0;
+            this->sampleCounts[i] = 0;
+        }
+        this->histogram.resize((GLuint)HISTOGRAM_BINS);
+    }
+
+    ~AutoExposure()
+    {
+        for (GLuint i = 0; i < LATENCY; i++)
+            if (this->fences[i])
+                glDeleteSync(this->fences[i]);
+        glDeleteBuffers(LATENCY, this->pbos);
+    }
+
+    // Queues the readback of this frame's luminance (width x height: size of the texture's base level),
+    // consumes the oldest finished readback and adapts the exposure over deltaTime seconds
+    void Update(GLuint luminanceTexture, GLuint width, GLuint height, GLfloat deltaTime)
+    {
+        // Smallest level that still has enough texels for a meaningful histogram
+        GLuint level = 0;
+        while ((width >> level) > this->MaxSamples || (height >> level) > this->MaxSamples)
+            level++;
+        GLuint levelWidth = std::max(width >> level, 1u), levelHeight = std::max(height >> level, 1u);
+
+        // 1. Copy into this frame's buffer, the oldest one. If the GPU still hadn't finished it, its data is dropped.
+        GLuint slot = this->frame % LATENCY;
+        if (this->fences[slot])
+            glDeleteSync(this->fences[slot]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbos[slot]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, levelWidth * levelHeight * sizeof(GLfloat), NULL, GL_STREAM_READ);
+        glBindTexture(GL_TEXTURE_2D, luminanceTexture);
+        glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->sampleCounts[slot] = levelWidth * levelHeight;
+        this->frame++;
+
+        // 2. Read back the next buffer in the ring (LATENCY - 1 frames old) if the GPU is done with it
+        GLuint oldest = this->frame % LATENCY;
+        if (this->fences[oldest] && glClientWaitSync(this->fences[oldest], 0, 0) != GL_TIMEOUT_EXPIRED)
+        {
+            this->consume(oldest);
+            glDeleteSync(this->fences[oldest]);
+            this->fences[oldest] = 0;
+        }
+
+        // 3. Adapt in log space, exponentially towards the target
+        if (this->adapted)
+        {
+            GLfloat current = std::log2(this->AdaptedLuminance), target = std::log2(this->TargetLuminance);
+            GLfloat speed = target > current ? this->SpeedUp : this->SpeedDown;
+            current += (target - current) * (1.0f - std::exp(-deltaTime * speed));
+            this->AdaptedLuminance = std::exp2(current);
+        }
+        this->Exposure = this->KeyValue / this->AdaptedLuminance * std::exp2(this->Compensation);
+        this->Exposure = std::min(std::max(this->Exposure, this->MinExposure), this->MaxExposure);
+    }
+
+    void PrintStats() const
+    {
+        std::cout << "Auto exposure: " << this->Exposure << " (" << this->Compensation << " EV), scene luminance "
+                  << this->TargetLuminance << ", adapted " << this->AdaptedLuminance << std::endl;
+    }
+
+private:
+    static const GLuint LATENCY = 3;
+    static const GLuint HISTOGRAM_BINS = 64;
+
+    GLuint pbos[LATENCY];
+    GLsync fences[LATENCY];
+    GLuint sampleCounts[LATENCY];
+    GLuint frame;
+    GLboolean adapted; // The first result is taken over directly instead of fading in from the default
+    std::vector<GLuint> histogram;
+
+    // Builds the histogram of a finished readback and averages it into TargetLuminance
+    void consume(GLuint slot)
+    {
+        GLuint count = this->sampleCounts[slot];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbos[slot]);
+        const GLfloat* samples = (const GLfloat*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * sizeof(GLfloat), GL_MAP_READ_BIT);
+        if (samples)
+        {
+            std::fill(this->histogram.begin(), this->histogram.end(), 0);
+            GLfloat binScale = (GLuint)HISTOGRAM_BINS / (this->MaxLogLuminance - this->MinLogLuminance);
+            for (GLuint i = 0; i < count; i++)
+            {
+                GLint bin = (GLint)((samples[i] - this->MinLogLuminance) * binScale);
+                this->histogram[std::min(std::max(bin, 0), (GLint)HISTOGRAM_BINS - 1)]++;
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            // Average of the bin centers between the two percentiles
+            GLfloat low = count * this->LowPercentile, high = count * this->HighPercentile;
+            GLfloat below = 0.0f, sum = 0.0f, weight = 0.0f;
+            for (GLuint bin = 0; bin < (GLuint)HISTOGRAM_BINS; bin++)
+            {
+                GLfloat binCount = (GLfloat)this->histogram[bin];
+                GLfloat inside = std::min(below + binCount, high) - std::max(below, low);
+                if (inside > 0.0f)
+                {
+                    sum += inside * (this->MinLogLuminance + (bin + 0.5f) / binScale);
+                    weight += inside;
+                }
+                below += binCount;
+            }
+            if (weight > 0.0f)
+            {
+                this->TargetLuminance = std::exp2(sum / weight);
+                if (!this->adapted)
+                {
+                    this->AdaptedLuminance = this->TargetLuminance;
+                    this->adapted = GL_TRUE;
+                }
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+// Before anything making GL calls, so they are counted
+#include <learnopengl/gl_stats.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/render_graph.h>
+#include <learnopengl/input_recorder.h>
+
+// A camera pose at a time along a CameraPath, in seconds
+struct CameraKey {
+    GLfloat Time;
+    glm::vec3 Position;
+    GLfloat Yaw, Pitch;
+};
+
+// Camera keyframes, interpolated linearly. Two keys at the same time cut from one pose to the next.
+class CameraPath
+{
+public:
+    std::vector<CameraKey> Keys;
+
+    // Reads one "time x y z yaw pitch" key per line, '#' starts a comment. Keys must come in time order, yaw isn't
+    // wrapped so a turn can go past 360 degrees. Returns false if the file can't be read or holds no key.
+    bool Load(const std::string& path)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::BENCHMARK:: Can't read camera path " << path << std::endl;
+            return false;
+        }
+        this->Keys.clear();
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line.substr(0, line.find('#')));
+            CameraKey key;
+            if (fields >> key.Time >> key.Position.x >> key.Position.y >> key.Position.z >> key.Yaw >> key.Pitch)
+                this->Keys.push_back(key);
+        }
+        return !this->Keys.empty();
+    }
+
+    // A full turn on the spot from the camera's current pose
+    static CameraPath Turn(const Camera& camera, GLfloat duration)
+    {
+        CameraPath path;
+        CameraKey start = { 0.0f, camera.Position, camera.Yaw, camera.Pitch };
+        CameraKey end = { duration, camera.Position, camera.Yaw + 360.0f, camera.Pitch };
+        path.Keys.push_back(start);
+        path.Keys.push_back(end);
+        return path;
+    }
+
+    GLfloat Duration() const
+    {
+        return this->Keys.empty() ? 0.0f : this->Keys.back().Time;
+    }
+
+    // Puts camera where the path is at time
+    void Apply(GLfloat time, Camera& camera) const
+    {
+        if (this->Keys.empty())
+            return;
+        GLuint next = 0;
+        while (next < this->Keys.size() && this->Keys[next].Time <= time)
+            next++;
+        const CameraKey& a = this->Keys[next > 0 ? next - 1 : 0];
+        const CameraKey& b = this->Keys[std::min(next, (GLuint)this->Keys.size() - 1)];
+        GLfloat t = b.Time > a.Time ? (time - a.Time) / (b.Time - a.Time) : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        camera.Position = glm::mix(a.Position, b.Position, t);
+        camera.Yaw = a.Yaw + (b.Yaw - a.Yaw) * t;
+        camera.Pitch = a.Pitch + (b.Pitch - a.Pitch) * t;
+        camera.ProcessMouseMovement(0.0f, 0.0f); // Recomputes the camera's vectors from the new angles
+    }
+};
+
+// Frame time benchmark of a demo. A demo built with LEARNOPENGL_BENCHMARK (the <demo>_benchmark targets) renders
+// into a hidden window with vsync off, so it also runs on machines without a GPU or a screen, e.g. on Mesa's llvmpipe
+// under a virtual X server: LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./bloom_benchmark. After some warm up frames the camera
+// follows a path for a fixed number of frames, then the demo exits and writes a JSON report: CPU frame times,
+// per pass CPU/GPU times when the demo draws through a RenderGraph and the draw calls and state changes per frame.
+// Command line: [frames] [--warmup frames] [--path camera.path | --replay recorded.input] [--output report.json]
+// Without a path the camera turns once on the spot, with --replay it moves as recorded (see InputRecorder, handed to
+// Attach()) and the run lasts as long as the recording. Without an output the report goes to stdout and everything
+// else the demo prints through std::cout (status lines, loader errors) is sent to stderr, so stdout parses as JSON.
+// In regular builds every call here does nothing, so the demos call it unconditionally.
+class FrameBenchmark
+{
+public:
+    std::string Name;
+    GLuint Frames, WarmupFrames;
+    CameraPath Path;
+    std::string OutputFile;
+
+    FrameBenchmark(const std::string& name, int argc, char* argv[])
+        : Name(name), Frames(600), WarmupFrames(60), replay(GL_FALSE), frameCountGiven(GL_FALSE), frame(0), width(0), height(0),
+          reportBuffer(NULL)
+    {
+#ifdef LEARNOPENGL_BENCHMARK
+        this->active = GL_TRUE;
+#else
+        this->active = GL_FALSE;
+#endif
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument == "--warmup" && i + 1 < argc)
+                this->WarmupFrames = std::atoi(argv[++i]);
+            else if (argument == "--path" && i + 1 < argc)
+                this->Path.Load(argv[++i]);
+            else if (argument == "--output" && i + 1 < argc)
+                this->OutputFile = argv[++i];
+            else if (argument.compare(0, 2, "--") == 0 && i + 1 < argc)
+                i++; // Someone else's option and its value, --replay is the InputRecorder's
+            else if (std::atoi(argv[i]) > 0)
+            {
+                this->Frames = std::atoi(argv[i]);
+                this->frameCountGiven = GL_TRUE;
+            }
+        }
+        // Keep stdout for the report
+        if (this->active && this->OutputFile.empty())
+            this->reportBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    ~FrameBenchmark()
+    {
+        if (this->reportBuffer)
+            std::cout.rdbuf(this->reportBuffer);
+    }
+
+    // Call once the demo's InputRecorder is constructed. While it replays the camera follows the replayed input,
+    // until the recording ends unless a frame count was given. A replay that can't be read ends the benchmark
+    // with an error rather than measuring live input that never comes.
+    void Attach(const InputRecorder& input)
+    {
+        if (!this->active)
+            return;
+        if (input.ReplayFailed())
+        {
+            std::cout << "ERROR::BENCHMARK:: Can't run " << this->Name << " without its replay" << std::endl;
+            glfwTerminate();
+            std::exit(EXIT_FAILURE);
+        }
+        this->replay = input.Replaying();
+        if (this->replay && !this->frameCountGiven)
+            this->Frames = 0;
+    }
+
+    GLboolean Active() const
+    {
+        return this->active;
+    }
+
+    // Call before glfwCreateWindow()
+    void WindowHints()
+    {
+        if (this->active)
+            glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    }
+
+    // Call once the context is current and GLEW initialized
+    void Start(GLFWwindow* window)
+    {
+        if (!this->active)
+            return;
+        glfwSwapInterval(0);
+        glfwGetFramebufferSize(window, &this->width, &this->height);
+        this->frameEnd = std::chrono::high_resolution_clock::now();
+        std::cout << "Benchmarking " << this->Name << " on " << glGetString(GL_RENDERER) << ": " << this->WarmupFrames
+                  << " warm up and " << (this->Frames ? std::to_string(this->Frames) : "the replay's") << " measured frames" << std::endl;
+    }
+
+    // False once all frames are done
+    GLboolean Running() const
+    {
+        return !this->active || this->Frames == 0 || this->frame < this->WarmupFrames + this->Frames;
+    }
+
+    // Call after the demo's own camera movement, replaces it with the path's pose of this frame unless replaying input
+    void PlaceCamera(Camera& camera)
+    {
+        if (!this->active || this->replay)
+            return;
+        if (this->Path.Keys.empty())
+            this->Path = CameraPath::Turn(camera, 10.0f);
+        // Warm up at the start of the path, then walk it from start to end over the measured frames
+        GLuint measured = this->frame < this->WarmupFrames ? 0 : this->frame - this->WarmupFrames;
+        this->Path.Apply(this->Path.Duration() * measured / std::max(this->Frames - 1, 1u), camera);
+    }
+
+    // Call after the buffers were swapped
+    void EndFrame(RenderGraph* graph = NULL)
+    {
+        if (!this->active)
+            return;
+        std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+        if (this->frame >= this->WarmupFrames)
+        {
+            this->frameTimes.push_back(std::chrono::duration<double, std::milli>(now - this->frameEnd).count());
+            this->calls.push_back(GLCalls());
+        }
+        else if (this->frame + 1 == this->WarmupFrames && graph)
+            graph->TakeTimings(); // Measure the pass times from here on
+        ResetGLCalls();
+        this->frameEnd = now;
+        this->frame++;
+    }
+
+    // Writes the report, call once Running() is false
+    void Report(RenderGraph* graph = NULL)
+    {
+        if (!this->active || this->frameTimes.empty())
+            return;
+        std::vector<RenderGraphTiming> passes;
+        if (graph)
+            passes = graph->TakeTimings();
+        std::vector<double> sorted = this->frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (GLuint i = 0; i < sorted.size(); i++)
+            total += sorted[i];
+        GLCallCounts sum = { 0, 0, 0, 0, 0, 0, 0 };
+        for (GLuint i = 0; i < this->calls.size(); i++)
+        {
+            sum.DrawCalls += this->calls[i].DrawCalls;
+            sum.ProgramBinds += this->calls[i].ProgramBinds;
+            sum.TextureBinds += this->calls[i].TextureBinds;
+            sum.VertexArrayBinds += this->calls[i].VertexArrayBinds;
+            sum.FramebufferBinds += this->calls[i].FramebufferBinds;
+            sum.BufferBinds += this->calls[i].BufferBinds;
+            sum.CapabilityChanges += this->calls[i].CapabilityChanges;
+        }
+        double frames = this->calls.size();
+
+        std::ostringstream json;
+        json << "{\n";
+        json << "  \"demo\": \"" << this->Name << "\",\n";
+        json << "  \"renderer\": \"" << escape((const char*)glGetString(GL_RENDERER)) << "\",\n";
+        json << "  \"width\": " << this->width << ",\n";
+        json << "  \"height\": " << this->height << ",\n";
+        json << "  \"warmup_frames\": " << this->WarmupFrames << ",\n";
+        json << "  \"frames\": " << sorted.size() << ",\n";
+        json << "  \"frame_time_ms\": { \"mean\": " << total / sorted.size() << ", \"median\": " << percentile(sorted, 0.5)
+             << ", \"p95\": " << percentile(sorted, 0.95) << ", \"p99\": " << percentile(sorted, 0.99)
+             << ", \"min\": " << sorted.front() << ", \"max\": " << sorted.back() << " },\n";
+        json << "  \"passes\": [";
+        for (GLuint i = 0; i < passes.size(); i++)
+            json << (i ? "," : "") << "\n    { \"name\": \"" << escape(passes[i].Pass) << "\", \"cpu_ms\": " << passes[i].CpuMs
+                 << ", \"gpu_ms\": " << passes[i].GpuMs << " }";
+        json << (passes.empty() ? "],\n" : "\n  ],\n");
+        json << "  \"per_frame\": { \"draw_calls\": " << sum.DrawCalls / frames << ", \"state_changes\": " << sum.StateChanges() / frames
+             << ", \"program_binds\": " << sum.ProgramBinds / frames << ", \"texture_binds\": " << sum.TextureBinds / frames
+             << ", \"vertex_array_binds\": " << sum.VertexArrayBinds / frames << ", \"framebuffer_binds\": " << sum.FramebufferBinds / frames
+             << ", \"buffer_binds\": " << sum.BufferBinds / frames << ", \"capability_changes\": " << sum.CapabilityChanges / frames << " }\n";
+        json << "}\n";
+
+        if (this->OutputFile.empty())
+        {
+            std::ostream report(this->reportBuffer);
+            report << json.str() << std::flush;
+            return;
+        }
+        std::ofstream file(this->OutputFile.c_str());
+        file << json.str();
+        if (!file)
+            std::cout << "ERROR::BENCHMARK:: Failed to write " << this->OutputFile << std::endl;
+        else
+            std::cout << "Benchmark report written to " << this->OutputFile << std::endl;
+    }
+
+private:
+    GLboolean active;
+    GLboolean replay;
+    GLboolean frameCountGiven;
+    GLuint frame;
+    GLint width, height;
+    std::chrono::high_resolution_clock::time_point frameEnd;
+    std::vector<double> frameTimes;
+    std::vector<GLCallCounts> calls;
+    std::streambuf* reportBuffer; // stdout's, while std::cout goes to stderr
+
+    static double percentile(const std::vector<double>& sorted, double fraction)
+    {
+        return sorted[std::min((size_t)(fraction * sorted.size()), sorted.size() - 1)];
+    }
+
+    static std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        for (GLuint i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '"' || text[i] == '\\')
+                escaped += '\\';
+            escaped += text[i];
+        }
+        return escaped;
+    }
+};
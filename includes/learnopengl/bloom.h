@@ -0,0 +1,198 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/screen_quad.h>
+
+// A single level of the bloom chain
+struct BloomMip {
+    glm::ivec2 Size;
+    GLuint Texture;
+};
+
+// Progressive downsample/upsample bloom (Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare").
+// The HDR scene is thresholded and downsampled with a 13-tap filter into a chain of 1/2 ... 1/64 resolution
+// textures, then walked back up with a 3x3 tent filter that is additively blended into the next larger level.
+// Each pass only touches its own (small) level, so the whole chain costs a fraction of a single
+// full-resolution blur pass while giving a much wider, stable glow.
+// The result ends up in the 1/2 resolution level (BloomTexture()) and is added to the scene in bloom_final.frag
+// scaled by CompositeWeight().
+// The first downsample also writes the log2 luminance of the unthresholded scene to LuminanceTexture() (second
+// render target) and mipmaps it, so auto exposure gets its input without another pass over the full resolution scene.
+class BloomRenderer
+{
+public:
+    // Bloom options
+    GLfloat Threshold;    // Brightness above which pixels start to bloom (same luminance test as the scene shaders)
+    GLfloat Knee;         // Width of the soft transition around the threshold, 0 gives a hard cut
+    GLfloat FilterRadius; // Radius of the upsample tent filter in texture coordinates, controls the glow spread
+    GLfloat Strength;     // Overall bloom intensity
+
+    // Constructor, width/height are the resolution of the HDR source, mipCount the number of chain levels (1/2 ... 1/2^mipCount)
+    BloomRenderer(GLuint width, GLuint height, GLuint mipCount = 6)
+        : Threshold(1.0f), Knee(0.1f), FilterRadius(0.005f), Strength(1.0f), FBO(0), luminanceTexture(0), mipCount(mipCount),
+          downsampleShader("shaders/bloom_downsample.vs", "shaders/bloom_downsample.frag"),
+          upsampleShader("shaders/bloom_downsample.vs", "shaders/bloom_upsample.frag")
+    {
+        glGenFramebuffers(1, &this->FBO);
+        this->Resize(width, height);
+
+        this->downsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->downsampleShader.Program, "srcTexture"), 0);
+        this->upsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->upsampleShader.Program, "srcTexture"), 0);
+        glUseProgram(0);
+    }
+
+    ~BloomRenderer()
+    {
+        this->releaseMips();
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(1, &this->luminanceTexture);
+    }
+
+    // (Re)creates the mip chain for a new source resolution
+    void Resize(GLuint width, GLuint height)
+    {
+        this->releaseMips();
+        glm::ivec2 mipSize(width, height);
+        for (GLuint i = 0; i < this->mipCount; i++)
+        {
+            mipSize = glm::max(mipSize / 2, glm::ivec2(1));
+            BloomMip mip;
+            mip.Size = mipSize;
+            glGenTextures(1, &mip.Texture);
+            glBindTexture(GL_TEXTURE_2D, mip.Texture);
+            // Packed float format: half the bandwidth of RGB16F and plenty of precision for a blurred glow
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, mipSize.x, mipSize.y, 0, GL_RGB, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // We clamp to the edge as the filters would otherwise sample repeated texture values!
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            this->mips.push_back(mip);
+        }
+
+        // Log luminance at the size of the first level, with a full mip chain down to 1x1
+        if (this->luminanceTexture == 0)
+            glGenTextures(1, &this->luminanceTexture);
+        glBindTexture(GL_TEXTURE_2D, this->luminanceTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, this->mips[0].Size.x, this->mips[0].Size.y, 0, GL_RED, GL_FLOAT, NULL);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->mips[0].Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, this->luminanceTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::BLOOM:: Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Runs the whole chain on the given HDR texture. Leaves framebuffer 0 bound, the caller restores its viewport.
+    void Render(GLuint srcTexture, GLuint srcWidth, GLuint srcHeight)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glDisable(GL_DEPTH_TEST);
+        this->renderDownsamples(srcTexture, srcWidth, srcHeight);
+        this->renderUpsamples();
+        glEnable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Half resolution bloom result, bind it as 'bloomBlur' in bloom_final.frag
+    GLuint BloomTexture() const { return this->mips[0].Texture; }
+
+    // Log2 luminance of the source at 1/2 resolution, mipmapped. Input of AutoExposure.
+    GLuint LuminanceTexture() const { return this->luminanceTexture; }
+
+    // Every level adds its own copy of the bright pixels, normalize so the glow has the energy of the thresholded image
+    GLfloat CompositeWeight() const { return this->Strength / (GLfloat)this->mipCount; }
+
+    const std::vector<BloomMip>& Mips() const { return this->mips; }
+
+    // Video memory used by the chain in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        GLsizeiptr bytes = 0;
+        for (GLuint i = 0; i < this->mips.size(); i++)
+            bytes += (GLsizeiptr)this->mips[i].Size.x * this->mips[i].Size.y * 4;
+        // R16F luminance with its mip chain
+        bytes += (GLsizeiptr)this->mips[0].Size.x * this->mips[0].Size.y * 2 * 4 / 3;
+        return bytes;
+    }
+
+private:
+    GLuint FBO;
+    GLuint luminanceTexture;
+    GLuint mipCount;
+    std::vector<BloomMip> mips;
+    Shader downsampleShader;
+    Shader upsampleShader;
+
+    void renderDownsamples(GLuint srcTexture, GLuint srcWidth, GLuint srcHeight)
+    {
+        this->downsampleShader.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, srcTexture);
+        glUniform2f(glGetUniformLocation(this->downsampleShader.Program, "srcResolution"), (GLfloat)srcWidth, (GLfloat)srcHeight);
+        glUniform1f(glGetUniformLocation(this->downsampleShader.Program, "threshold"), this->Threshold);
+        glUniform1f(glGetUniformLocation(this->downsampleShader.Program, "knee"), this->Knee);
+        for (GLuint i = 0; i < this->mips.size(); i++)
+        {
+            const BloomMip& mip = this->mips[i];
+            // Only the first pass thresholds the scene and applies the anti-firefly (Karis) average,
+            // it also writes the scene's log luminance to the second target
+            glUniform1i(glGetUniformLocation(this->downsampleShader.Program, "prefilter"), i == 0);
+            glViewport(0, 0, mip.Size.x, mip.Size.y);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mip.Texture, 0);
+            GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+            glDrawBuffers(i == 0 ? 2 : 1, attachments);
+            RenderScreenQuad();
+
+            // This level is the source of the next one
+            glUniform2f(glGetUniformLocation(this->downsampleShader.Program, "srcResolution"), (GLfloat)mip.Size.x, (GLfloat)mip.Size.y);
+            glBindTexture(GL_TEXTURE_2D, mip.Texture);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, this->luminanceTexture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    void renderUpsamples()
+    {
+        this->upsampleShader.Use();
+        glUniform1f(glGetUniformLocation(this->upsampleShader.Program, "filterRadius"), this->FilterRadius);
+        // Additive blending: each level accumulates the blurred contribution of all smaller levels
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glBlendEquation(GL_FUNC_ADD);
+        glActiveTexture(GL_TEXTURE0);
+        for (GLint i = (GLint)this->mips.size() - 1; i > 0; i--)
+        {
+            const BloomMip& mip = this->mips[i];
+            const BloomMip& nextMip = this->mips[i - 1];
+            glBindTexture(GL_TEXTURE_2D, mip.Texture);
+            glViewport(0, 0, nextMip.Size.x, nextMip.Size.y);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, nextMip.Texture, 0);
+            RenderScreenQuad();
+        }
+        glDisable(GL_BLEND);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void releaseMips()
+    {
+        for (GLuint i = 0; i < this->mips.size(); i++)
+            glDeleteTextures(1, &this->mips[i].Texture);
+        this->mips.clear();
+    }
+};
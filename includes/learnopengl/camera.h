@@ -44,6 +44,8 @@ public:
     GLfloat MovementSpeed;
     GLfloat MouseSensitivity;
     GLfloat Zoom;
+    // Sub-pixel offset of the last jittered projection, in pixels
+    glm::vec2 Jitter;
 
     // Constructor with vectors
     Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), FrontMy(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM)
@@ -70,6 +72,38 @@ public:
         return glm::lookAt(this->Position, this->Position + this->Front, this->Up);
     }
 
+    // Returns the perspective projection matrix for the current field of view (Zoom)
+    glm::mat4 GetProjectionMatrix(GLfloat aspect, GLfloat nearPlane, GLfloat farPlane)
+    {
+        return glm::perspective(this->Zoom, aspect, nearPlane, farPlane);
+    }
+
+    // Returns the projection matrix shifted by a sub-pixel offset for temporal anti-aliasing. The offsets walk the
+    // Halton (2, 3) sequence over sampleCount frames so the samples of consecutive frames cover the pixel evenly.
+    glm::mat4 GetJitteredProjectionMatrix(GLfloat aspect, GLfloat nearPlane, GLfloat farPlane, GLuint frameIndex, GLuint width, GLuint height, GLuint sampleCount = 8)
+    {
+        GLuint index = frameIndex % sampleCount + 1;
+        this->Jitter = glm::vec2(Halton(index, 2) - 0.5f, Halton(index, 3) - 0.5f);
+        glm::mat4 projection = this->GetProjectionMatrix(aspect, nearPlane, farPlane);
+        // The third column is multiplied by the view space z and w = -z, so subtracting it offsets every vertex by a constant in NDC
+        projection[2][0] -= this->Jitter.x * 2.0f / width;
+        projection[2][1] -= this->Jitter.y * 2.0f / height;
+        return projection;
+    }
+
+    // Element index (starting at 1) of the Halton low discrepancy sequence in the given base, in [0, 1)
+    static GLfloat Halton(GLuint index, GLuint base)
+    {
+        GLfloat result = 0.0f, fraction = 1.0f;
+        while (index > 0)
+        {
+            fraction /= base;
+            result += fraction * (index % base);
+            index /= base;
+        }
+        return result;
+    }
+
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, GLfloat deltaTime)
     {
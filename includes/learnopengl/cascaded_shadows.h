@@ -0,0 +1,190 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/shadow_cache.h>
+
+// Cascaded shadow maps for a directional light (Engel, "Cascaded Shadow Maps", ShaderX5; Zhang et al. "Parallel-Split Shadow Maps").
+// The camera frustum is cut into CascadeCount slices along the view direction and every slice gets its own
+// orthographic shadow map, stored as one layer of a depth texture array. Near slices are small so shadows close
+// to the camera get many texels per meter, far slices cover a lot more ground with the same resolution.
+//
+// - Split distances use the practical split scheme: a blend (SplitLambda) of logarithmic and uniform splits.
+// - Every cascade is fitted around the bounding sphere of its frustum slice, so its size doesn't change when the
+//   camera rotates, and its origin is snapped to whole shadow map texels, so shadow edges don't shimmer when it moves.
+// - Casters between the light and the cascade are kept by depth clamping instead of pushing the near plane far away,
+//   which keeps the full depth precision for the receivers.
+//
+// The fragment shader picks the cascade from the view space depth, see shaders/shadow_mapping.frag.
+class CascadedShadowMap
+{
+public:
+    GLuint FBO;
+    GLuint DepthArray;
+    GLuint Resolution;
+    GLuint CascadeCount;
+    GLfloat SplitLambda; // 0 = uniform splits, 1 = logarithmic splits
+    std::vector<GLfloat> SplitDistances;      // View space far distance of every cascade
+    std::vector<glm::mat4> LightSpaceMatrices; // World -> light clip space of every cascade
+    std::vector<GLfloat> TexelSizes;          // World space size of one shadow map texel in every cascade
+
+    // Maximum number of cascades the shaders are written for
+    static const GLuint MAX_CASCADES = 4;
+    // Format of the depth array, a ShadowCache of the cascades has to use the same one
+    static const GLenum DEPTH_FORMAT = GL_DEPTH_COMPONENT24;
+
+    CascadedShadowMap(GLuint resolution = 2048, GLuint cascadeCount = 4, GLfloat splitLambda = 0.75f)
+        : FBO(0), DepthArray(0), Resolution(resolution), CascadeCount(cascadeCount < MAX_CASCADES ? cascadeCount : (GLuint)MAX_CASCADES), SplitLambda(splitLambda),
+          SplitDistances(this->CascadeCount), LightSpaceMatrices(this->CascadeCount), TexelSizes(this->CascadeCount)
+    {
+        glGenTextures(1, &this->DepthArray);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->DepthArray);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, DEPTH_FORMAT, resolution, resolution, this->CascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        // Hardware depth comparison, a single lookup already returns a bilinearly filtered 2x2 PCF result
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &this->FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->DepthArray, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::CSM:: Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~CascadedShadowMap()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(1, &this->DepthArray);
+    }
+
+    // Fits the cascades to the camera frustum [nearPlane, shadowDistance] for a light shining along lightDirection.
+    // fov is the vertical field of view in radians, like Camera::Zoom.
+    void Update(const glm::mat4& view, GLfloat fov, GLfloat aspect, GLfloat nearPlane, GLfloat shadowDistance, glm::vec3 lightDirection)
+    {
+        lightDirection = glm::normalize(lightDirection);
+        glm::mat4 inverseView = glm::inverse(view);
+        GLfloat splitNear = nearPlane;
+        for (GLuint i = 0; i < this->CascadeCount; i++)
+        {
+            // Practical split scheme
+            GLfloat p = (i + 1) / (GLfloat)this->CascadeCount;
+            GLfloat logSplit = nearPlane * std::pow(shadowDistance / nearPlane, p);
+            GLfloat uniformSplit = nearPlane + (shadowDistance - nearPlane) * p;
+            GLfloat splitFar = this->SplitLambda * logSplit + (1.0f - this->SplitLambda) * uniformSplit;
+            this->SplitDistances[i] = splitFar;
+
+            // Bounding sphere of the frustum slice in world space
+            glm::vec3 corners[8];
+            GLfloat tanY = std::tan(fov * 0.5f), tanX = tanY * aspect;
+            glm::vec3 center(0.0f);
+            for (GLuint c = 0; c < 8; c++)
+            {
+                GLfloat depth = c < 4 ? splitNear : splitFar;
+                glm::vec3 viewCorner((c & 1 ? 1.0f : -1.0f) * tanX * depth, (c & 2 ? 1.0f : -1.0f) * tanY * depth, -depth);
+                corners[c] = glm::vec3(inverseView * glm::vec4(viewCorner, 1.0f));
+                center += corners[c];
+            }
+            center /= 8.0f;
+            GLfloat radius = 0.0f;
+            for (GLuint c = 0; c < 8; c++)
+                radius = std::max(radius, glm::length(corners[c] - center));
+            // Quantize the radius so floating point noise doesn't resize the cascade from frame to frame
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::mat4 lightView = glm::lookAt(center - lightDirection * radius, center, up);
+            glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+
+            // Snap the cascade to whole texels: move the projection so the world origin lands on a texel corner
+            glm::mat4 shadowMatrix = lightProjection * lightView;
+            glm::vec4 origin = shadowMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) * (this->Resolution * 0.5f);
+            glm::vec4 offset = (glm::vec4(glm::floor(glm::vec2(origin) + 0.5f), 0.0f, 0.0f) - glm::vec4(glm::vec2(origin), 0.0f, 0.0f))
+                               * (2.0f / this->Resolution);
+            lightProjection[3][0] += offset.x;
+            lightProjection[3][1] += offset.y;
+
+            this->LightSpaceMatrices[i] = lightProjection * lightView;
+            this->TexelSizes[i] = 2.0f * radius / this->Resolution;
+            splitNear = splitFar;
+        }
+    }
+
+    // Renders the casters into every cascade. drawCasters is called once per cascade with depthShader in use and
+    // its 'lightSpaceMatrix' set. Leaves the shadow FBO bound with the viewport set to the shadow map resolution.
+    template <typename DrawFunction>
+    void Render(Shader& depthShader, DrawFunction drawCasters)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glViewport(0, 0, this->Resolution, this->Resolution);
+        glEnable(GL_DEPTH_CLAMP); // Casters in front of the near plane get flattened onto it instead of clipped
+        depthShader.Use();
+        GLint lightSpaceLocation = glGetUniformLocation(depthShader.Program, "lightSpaceMatrix");
+        for (GLuint i = 0; i < this->CascadeCount; i++)
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->DepthArray, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glUniformMatrix4fv(lightSpaceLocation, 1, GL_FALSE, glm::value_ptr(this->LightSpaceMatrices[i]));
+            drawCasters(depthShader);
+        }
+        glDisable(GL_DEPTH_CLAMP);
+    }
+
+    // Same as above, but through a cache of the static casters: drawStatic only runs for the cascades whose light
+    // matrix changed, drawDynamic runs every frame on top of the cached depth of the cascades dynamicBounds (world
+    // space bounding spheres, center and radius) touch. Use a cache created for DepthArray.
+    template <typename StaticFunction, typename DynamicFunction>
+    void Render(ShadowCache& cache, Shader& depthShader, StaticFunction drawStatic, const std::vector<glm::vec4>& dynamicBounds,
+                DynamicFunction drawDynamic)
+    {
+        glEnable(GL_DEPTH_CLAMP);
+        depthShader.Use();
+        GLint lightSpaceLocation = glGetUniformLocation(depthShader.Program, "lightSpaceMatrix");
+        cache.Render(this->LightSpaceMatrices,
+            [&](GLint layer) { glUniformMatrix4fv(lightSpaceLocation, 1, GL_FALSE, glm::value_ptr(this->LightSpaceMatrices[layer])); },
+            [&]() { drawStatic(depthShader); },
+            dynamicBounds,
+            [&]() { drawDynamic(depthShader); });
+        glDisable(GL_DEPTH_CLAMP);
+    }
+
+    // Binds the depth array to textureUnit and uploads the cascade uniforms of shaders/shadow_mapping.frag
+    void SetUniforms(Shader& shader, GLuint textureUnit)
+    {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->DepthArray);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(shader.Program, "shadowMap"), textureUnit);
+        glUniform1i(glGetUniformLocation(shader.Program, "cascadeCount"), this->CascadeCount);
+        glUniform1fv(glGetUniformLocation(shader.Program, "cascadeSplits"), this->CascadeCount, &this->SplitDistances[0]);
+        glUniform1fv(glGetUniformLocation(shader.Program, "cascadeTexelSizes"), this->CascadeCount, &this->TexelSizes[0]);
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "lightSpaceMatrices"), this->CascadeCount, GL_FALSE, glm::value_ptr(this->LightSpaceMatrices[0]));
+    }
+
+    // Video memory used by the depth array in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        return (GLsizeiptr)this->Resolution * this->Resolution * this->CascadeCount * 4;
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader.h>
+
+// Clustered forward shading (Olsson et al., "Clustered Deferred and Forward Shading").
+// The view frustum is cut into screen tiles of TileSize x TileSize pixels and exponentially spaced depth slices.
+// Every frame the lights' spheres of influence are assigned to the clusters they touch on the CPU, and the
+// fragment shader only loops over the lights of its own cluster, so its cost follows the number of lights
+// nearby instead of the number of lights in the scene.
+//
+// Everything is uploaded through buffer textures (core in OpenGL 3.3):
+//   - clusterLights:       two RGBA32F texels per light, (position, radius) and (color, 0), world space
+//   - clusterGrid:         one RG32UI texel per cluster, (first index, light count)
+//   - clusterLightIndices: R16UI light indices, the lists of all clusters back to back
+// A buffer texture holds GL_MAX_TEXTURE_BUFFER_SIZE texels, only guaranteed to be 65536. MaxLights is clamped to
+// it and when the index lists outgrow it the clusters past the limit drop lights (see Update()).
+// See ClusteredLighting() in shaders/bloom.frag for the lookup.
+class ClusteredLights
+{
+public:
+    GLuint TileSize;
+    GLuint TilesX, TilesY, Slices;
+    GLfloat NearPlane, FarPlane; // Depth range the slices cover, lights beyond FarPlane are dropped
+    GLuint MaxLights;
+    // Result of the last Update(), IndexCount is before dropping the indices past the buffer texture limit
+    GLuint LightCount, IndexCount, MaxClusterLights;
+
+    ClusteredLights(GLuint screenWidth, GLuint screenHeight, GLfloat nearPlane, GLfloat farPlane,
+                    GLuint tileSize = 64, GLuint slices = 24, GLuint maxLights = 4096)
+        : TileSize(tileSize), TilesX((screenWidth + tileSize - 1) / tileSize), TilesY((screenHeight + tileSize - 1) / tileSize),
+          Slices(slices), NearPlane(nearPlane), FarPlane(farPlane), MaxLights(maxLights < 65536 ? maxLights : 65536),
+          LightCount(0), IndexCount(0), MaxClusterLights(0), screenSize(screenWidth, screenHeight), maxTexels(65536), overflowed(GL_FALSE)
+    {
+        GLuint clusterCount = this->TilesX * this->TilesY * this->Slices;
+        GLint limit;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &limit);
+        this->maxTexels = std::max(limit, 65536);
+        this->MaxLights = std::min(this->MaxLights, this->maxTexels / 2);
+        if (clusterCount > this->maxTexels)
+            std::cout << "ERROR::CLUSTERED_LIGHTS:: " << clusterCount << " clusters exceed the buffer texture limit of " << this->maxTexels << " texels" << std::endl;
+        this->clusterBounds.resize(clusterCount * 2);
+        this->clusterCounts.resize(clusterCount);
+        this->grid.resize(clusterCount * 2);
+
+        glGenBuffers(3, this->buffers);
+        glGenTextures(3, this->textures);
+        GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], this->buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~ClusteredLights()
+    {
+        glDeleteTextures(3, this->textures);
+        glDeleteBuffers(3, this->buffers);
+    }
+
+    // Distance at which a light of the given color falls below threshold with quadratic attenuation
+    static GLfloat LightRadius(const glm::vec3& color, GLfloat threshold = 0.05f)
+    {
+        GLfloat intensity = std::max(color.r, std::max(color.g, color.b));
+        return std::sqrt(intensity / threshold);
+    }
+
+    // Assigns the lights to the clusters of the camera given by view and projection and uploads the result
+    void Update(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& colors, const std::vector<GLfloat>& radii,
+                const glm::mat4& view, const glm::mat4& projection)
+    {
+        if (projection != this->cachedProjection)
+            this->buildClusterBounds(projection);
+
+        this->LightCount = std::min((GLuint)positions.size(), this->MaxLights);
+        this->lightData.resize(this->LightCount * 2);
+        this->pairs.clear();
+        std::fill(this->clusterCounts.begin(), this->clusterCounts.end(), 0);
+        GLfloat depthScale = this->Slices / std::log(this->FarPlane / this->NearPlane);
+        for (GLuint l = 0; l < this->LightCount; l++)
+        {
+            this->lightData[l * 2] = glm::vec4(positions[l], radii[l]);
+            this->lightData[l * 2 + 1] = glm::vec4(colors[l], 0.0f);
+
+            // Slices the sphere spans
+            glm::vec3 center = glm::vec3(view * glm::vec4(positions[l], 1.0f));
+            GLfloat radius = radii[l];
+            GLfloat nearDepth = -center.z - radius, farDepth = -center.z + radius;
+            if (farDepth < this->NearPlane || nearDepth > this->FarPlane)
+                continue;
+            GLint firstSlice = nearDepth <= this->NearPlane ? 0 : (GLint)(std::log(nearDepth / this->NearPlane) * depthScale);
+            GLint lastSlice = (GLint)(std::log(std::min(farDepth, this->FarPlane) / this->NearPlane) * depthScale);
+            lastSlice = std::min(lastSlice, (GLint)this->Slices - 1);
+
+            // Tiles its bounding box covers on screen, all of them if it reaches behind the near plane
+            GLint tileMin[2] = { 0, 0 };
+            GLint tileMax[2] = { (GLint)this->TilesX - 1, (GLint)this->TilesY - 1 };
+            if (nearDepth > this->NearPlane)
+                this->screenBounds(center, radius, projection, tileMin, tileMax);
+
+            // Exact sphere/cluster box test inside that range
+            GLfloat radiusSquared = radius * radius;
+            for (GLint z = firstSlice; z <= lastSlice; z++)
+                for (GLint y = tileMin[1]; y <= tileMax[1]; y++)
+                    for (GLint x = tileMin[0]; x <= tileMax[0]; x++)
+                    {
+                        GLuint cluster = (z * this->TilesY + y) * this->TilesX + x;
+                        glm::vec3 closest = glm::clamp(center, this->clusterBounds[cluster * 2], this->clusterBounds[cluster * 2 + 1]);
+                        glm::vec3 offset = closest - center;
+                        if (glm::dot(offset, offset) > radiusSquared)
+                            continue;
+                        this->pairs.push_back(glm::uvec2(cluster, l));
+                        this->clusterCounts[cluster]++;
+                    }
+        }
+
+        // Prefix sum over the counts, then scatter the light indices into one list. Lists that would run past the
+        // buffer texture limit are cut short, the clusters lose their last lights rather than read past the end.
+        GLuint offset = 0;
+        this->MaxClusterLights = 0;
+        this->IndexCount = 0;
+        for (GLuint c = 0; c < this->clusterCounts.size(); c++)
+        {
+            this->grid[c * 2] = offset;
+            this->grid[c * 2 + 1] = 0;
+            this->IndexCount += this->clusterCounts[c];
+            this->MaxClusterLights = std::max(this->MaxClusterLights, this->clusterCounts[c]);
+            this->clusterCounts[c] = std::min(this->clusterCounts[c], this->maxTexels - offset);
+            offset += this->clusterCounts[c];
+        }
+        if (this->IndexCount > offset && !this->overflowed)
+            std::cout << "ERROR::CLUSTERED_LIGHTS:: " << this->IndexCount << " light indices exceed the buffer texture limit of "
+                      << this->maxTexels << " texels, lights are dropped" << std::endl;
+        this->overflowed = this->IndexCount > offset;
+        this->indices.resize(offset > 0 ? offset : 1);
+        for (GLuint i = 0; i < this->pairs.size(); i++)
+        {
+            GLuint cluster = this->pairs[i].x;
+            if (this->grid[cluster * 2 + 1] < this->clusterCounts[cluster])
+                this->indices[this->grid[cluster * 2] + this->grid[cluster * 2 + 1]++] = (GLushort)this->pairs[i].y;
+        }
+
+        this->upload(0, this->lightData.size() * sizeof(glm::vec4), this->lightData.empty() ? NULL : &this->lightData[0]);
+        this->upload(1, this->grid.size() * sizeof(GLuint), &this->grid[0]);
+        this->upload(2, this->indices.size() * sizeof(GLushort), &this->indices[0]);
+    }
+
+    // Binds the buffer textures to textureUnit, textureUnit + 1 and textureUnit + 2 and sets the cluster uniforms
+    void SetUniforms(Shader& shader, GLuint textureUnit)
+    {
+        const GLchar* names[] = { "clusterLights", "clusterGrid", "clusterLightIndices" };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + textureUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glUniform1i(glGetUniformLocation(shader.Program, names[i]), textureUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        // slice = log(depth) * scale - bias
+        GLfloat scale = this->Slices / std::log(this->FarPlane / this->NearPlane);
+        glUniform3i(glGetUniformLocation(shader.Program, "clusterDims"), this->TilesX, this->TilesY, this->Slices);
+        glUniform1f(glGetUniformLocation(shader.Program, "clusterTileSize"), (GLfloat)this->TileSize);
+        glUniform2f(glGetUniformLocation(shader.Program, "clusterDepthParams"), scale, std::log(this->NearPlane) * scale);
+    }
+
+    void PrintStats() const
+    {
+        GLuint clusters = this->TilesX * this->TilesY * this->Slices;
+        std::cout << "Clustered lights: " << this->LightCount << " lights in " << this->TilesX << "x" << this->TilesY << "x" << this->Slices
+                  << " clusters, " << this->IndexCount / (GLfloat)clusters << " per cluster on average, " << this->MaxClusterLights << " at most" << std::endl;
+    }
+
+private:
+    glm::vec2 screenSize;
+    GLuint maxTexels;      // GL_MAX_TEXTURE_BUFFER_SIZE
+    GLboolean overflowed;  // The last Update() dropped indices, warn only when that starts
+    GLuint buffers[3];
+    GLuint textures[3];
+    glm::mat4 cachedProjection;
+    std::vector<glm::vec3> clusterBounds; // View space AABB of every cluster, min and max
+    std::vector<GLuint> clusterCounts;
+    std::vector<glm::uvec2> pairs;       // (cluster, light) of every assignment, in light order
+    std::vector<glm::vec4> lightData;
+    std::vector<GLuint> grid;
+    std::vector<GLushort> indices;
+
+    GLfloat sliceDepth(GLuint slice) const
+    {
+        return this->NearPlane * std::pow(this->FarPlane / this->NearPlane, slice / (GLfloat)this->Slices);
+    }
+
+    void buildClusterBounds(const glm::mat4& projection)
+    {
+        this->cachedProjection = projection;
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        for (GLuint y = 0; y < this->TilesY; y++)
+            for (GLuint x = 0; x < this->TilesX; x++)
+            {
+                // View space rays through the tile's corners, scaled so they reach depth 1
+                glm::vec3 rays[4];
+                for (GLuint c = 0; c < 4; c++)
+                {
+                    glm::vec2 pixel((x + (c & 1)) * this->TileSize, (y + (c >> 1)) * this->TileSize);
+                    glm::vec2 ndc = pixel / this->screenSize * 2.0f - 1.0f;
+                    glm::vec4 point = inverseProjection * glm::vec4(ndc, -1.0f, 1.0f);
+                    rays[c] = glm::vec3(point) / -point.z;
+                }
+                for (GLuint z = 0; z < this->Slices; z++)
+                {
+                    GLfloat depths[2] = { this->sliceDepth(z), this->sliceDepth(z + 1) };
+                    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+                    for (GLuint d = 0; d < 2; d++)
+                        for (GLuint c = 0; c < 4; c++)
+                        {
+                            glm::vec3 corner = rays[c] * depths[d];
+                            boundsMin = glm::min(boundsMin, corner);
+                            boundsMax = glm::max(boundsMax, corner);
+                        }
+                    GLuint cluster = (z * this->TilesY + y) * this->TilesX + x;
+                    this->clusterBounds[cluster * 2] = boundsMin;
+                    this->clusterBounds[cluster * 2 + 1] = boundsMax;
+                }
+            }
+    }
+
+    // Tile range covered by the projection of a view space sphere that lies entirely in front of the near plane
+    void screenBounds(const glm::vec3& center, GLfloat radius, const glm::mat4& projection, GLint tileMin[2], GLint tileMax[2]) const
+    {
+        glm::vec2 ndcMin(1e30f), ndcMax(-1e30f);
+        for (GLuint c = 0; c < 8; c++)
+        {
+            glm::vec3 corner = center + glm::vec3(c & 1 ? radius : -radius, c & 2 ? radius : -radius, c & 4 ? radius : -radius);
+            glm::vec4 clip = projection * glm::vec4(corner, 1.0f);
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        ndcMin = glm::clamp(ndcMin, -1.0f, 1.0f);
+        ndcMax = glm::clamp(ndcMax, -1.0f, 1.0f);
+        GLint tiles[2] = { (GLint)this->TilesX, (GLint)this->TilesY };
+        for (GLuint i = 0; i < 2; i++)
+        {
+            tileMin[i] = glm::clamp((GLint)((ndcMin[i] * 0.5f + 0.5f) * this->screenSize[i] / this->TileSize), 0, tiles[i] - 1);
+            tileMax[i] = glm::clamp((GLint)((ndcMax[i] * 0.5f + 0.5f) * this->screenSize[i] / this->TileSize), 0, tiles[i] - 1);
+        }
+    }
+
+    // Orphans the buffer and refills it, so the driver doesn't wait for last frame's draws still reading it
+    void upload(GLuint buffer, GLsizeiptr size, const GLvoid* data)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, size > 0 ? size : 16, NULL, GL_STREAM_DRAW);
+        if (size > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
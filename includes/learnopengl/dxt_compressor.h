@@ -0,0 +1,59 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Other Libs
+#include <image_DXT.h>
+
+// Parallel DXT1/DXT5 compression on top of SOIL's block encoder. The image is split into contiguous ranges of
+// 4x4 block rows, one per thread, which compress_image_rows_to_DXT writes straight to their place in the output,
+// so the result is byte for byte what the single threaded convert_image_to_DXT1/5 produce (at DXT_QUALITY_NORMAL)
+// and can go into the same DDS files. quality is one of DXT_QUALITY_FAST, _NORMAL and _HIGH.
+class DXTCompressor
+{
+public:
+    GLint Quality;
+    GLuint ThreadCount;
+
+    // threadCount 0 uses every hardware thread
+    DXTCompressor(GLint quality = DXT_QUALITY_NORMAL, GLuint threadCount = 0) : Quality(quality), ThreadCount(threadCount)
+    {
+        if (this->ThreadCount == 0)
+            this->ThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Bytes of the compressed image
+    static GLsizei CompressedSize(GLint width, GLint height, GLboolean dxt5)
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * (dxt5 ? 16 : 8);
+    }
+
+    // Compresses an 8 bit image with 1 to 4 channels into compressed (resized to fit)
+    void Compress(const unsigned char* image, GLint width, GLint height, GLint channels, GLboolean dxt5, std::vector<unsigned char>& compressed) const
+    {
+        compressed.resize(CompressedSize(width, height, dxt5));
+        GLint blockRows = (height + 3) / 4;
+        // Fewer threads than rows, and not more threads than it's worth starting for small mip levels
+        GLint threads = std::min(std::min((GLint)this->ThreadCount, blockRows), std::max(width * height / (64 * 64), 1));
+        if (threads <= 1)
+        {
+            compress_image_rows_to_DXT(image, width, height, channels, dxt5, this->Quality, 0, blockRows, &compressed[0]);
+            return;
+        }
+        std::vector<std::thread> workers;
+        GLint rowsPerThread = (blockRows + threads - 1) / threads;
+        for (GLint first = rowsPerThread; first < blockRows; first += rowsPerThread)
+            workers.push_back(std::thread(compress_image_rows_to_DXT, image, width, height, channels, (GLint)dxt5, this->Quality,
+                                          first, std::min(rowsPerThread, blockRows - first), &compressed[0]));
+        // The calling thread takes the first range
+        compress_image_rows_to_DXT(image, width, height, channels, dxt5, this->Quality, 0, std::min(rowsPerThread, blockRows), &compressed[0]);
+        for (GLuint i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+};
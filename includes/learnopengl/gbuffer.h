@@ -0,0 +1,185 @@
+#pragma once
+
+// Std. Includes
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include <learnopengl/shader.h>
+
+// Geometry buffer for deferred shading. The geometry pass writes the surface attributes once per pixel,
+// lighting then runs per light over the pixels it covers instead of per light and per drawn fragment.
+// The layout is packed to keep the bandwidth of every lighting pass low, 12 bytes per pixel in total:
+//   DepthTexture      (DEPTH24_STENCIL8) position is reconstructed from depth and the inverse projection
+//   NormalTexture     (RG16F)            view space normal, octahedron encoded
+//   AlbedoSpecTexture (RGBA8)            rgb = albedo, a = specular intensity
+// against 28 bytes for a position (RGB16F), normal (RGB16F), albedo/specular (RGBA8) and depth layout.
+// See shaders/g_buffer.frag for the encoding and shaders/deferred_light.frag for the decoding.
+//
+// Lighting is accumulated into LightTexture (RGBA16F). Its framebuffer gets a copy of the G-buffer depth and stencil
+// so light volumes can be depth and stencil tested without reading and testing against the same texture.
+class GBuffer
+{
+public:
+    GLuint FBO;
+    GLuint DepthTexture;
+    GLuint NormalTexture;
+    GLuint AlbedoSpecTexture;
+    GLuint LightFBO;
+    GLuint LightTexture;
+    GLuint Width, Height;
+
+    GBuffer(GLuint width, GLuint height)
+        : FBO(0), DepthTexture(0), NormalTexture(0), AlbedoSpecTexture(0), LightFBO(0), LightTexture(0), Width(0), Height(0), lightDepthStencil(0)
+    {
+        glGenFramebuffers(1, &this->FBO);
+        glGenFramebuffers(1, &this->LightFBO);
+        glGenTextures(1, &this->DepthTexture);
+        glGenTextures(1, &this->NormalTexture);
+        glGenTextures(1, &this->AlbedoSpecTexture);
+        glGenTextures(1, &this->LightTexture);
+        glGenRenderbuffers(1, &this->lightDepthStencil);
+        this->Resize(width, height);
+    }
+
+    ~GBuffer()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteFramebuffers(1, &this->LightFBO);
+        glDeleteTextures(1, &this->DepthTexture);
+        glDeleteTextures(1, &this->NormalTexture);
+        glDeleteTextures(1, &this->AlbedoSpecTexture);
+        glDeleteTextures(1, &this->LightTexture);
+        glDeleteRenderbuffers(1, &this->lightDepthStencil);
+    }
+
+    void Resize(GLuint width, GLuint height)
+    {
+        this->Width = width;
+        this->Height = height;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        allocateTarget(this->DepthTexture, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, this->DepthTexture, 0);
+        allocateTarget(this->NormalTexture, GL_RG16F, GL_RG, GL_FLOAT);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->NormalTexture, 0);
+        allocateTarget(this->AlbedoSpecTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, this->AlbedoSpecTexture, 0);
+        GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::GBUFFER:: Framebuffer not complete!" << std::endl;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->LightFBO);
+        allocateTarget(this->LightTexture, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->LightTexture, 0);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->lightDepthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->lightDepthStencil);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::GBUFFER:: Light framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Binds and clears the G-buffer for the geometry pass
+    void BeginGeometry()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glViewport(0, 0, this->Width, this->Height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+
+    // Copies the depth and stencil of the geometry pass to the light framebuffer, binds it and clears the lighting
+    void BeginLighting()
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->FBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->LightFBO);
+        glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->LightFBO);
+        glViewport(0, 0, this->Width, this->Height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    // Binds the G-buffer textures to textureUnit ... textureUnit + 2 and sets the samplers of shaders/deferred_light.frag
+    void BindTextures(Shader& shader, GLuint textureUnit)
+    {
+        const GLchar* names[] = { "gDepth", "gNormal", "gAlbedoSpec" };
+        GLuint textures[] = { this->DepthTexture, this->NormalTexture, this->AlbedoSpecTexture };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + textureUnit + i);
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+            glUniform1i(glGetUniformLocation(shader.Program, names[i]), textureUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Stencil tested light volumes: per light, the stencil pass marks the pixels whose surface lies inside the
+    // volume (back faces behind the surface, front faces in front of it, which also works with the camera inside
+    // the volume), then the lighting pass shades only those pixels and resets their stencil on the way.
+    // drawLight(light, shader, lighting) sets the volume's 'model' (and with lighting set the light's uniforms)
+    // on shader and draws the volume. Expects BeginLighting() and leaves additive blending disabled.
+    template <typename LightFunction>
+    void RenderLightVolumes(Shader& stencilShader, Shader& lightShader, GLuint lightCount, LightFunction drawLight)
+    {
+        glEnable(GL_STENCIL_TEST);
+        glEnable(GL_DEPTH_CLAMP); // Volumes reaching past the far plane still get their back faces
+        glBlendFunc(GL_ONE, GL_ONE);
+        glDepthMask(GL_FALSE);
+        for (GLuint i = 0; i < lightCount; i++)
+        {
+            // 1. Stencil: count the faces that fail the depth test, only depth tested, no color
+            stencilShader.Use();
+            glEnable(GL_DEPTH_TEST);
+            glDisable(GL_CULL_FACE);
+            glDisable(GL_BLEND);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+            drawLight(i, stencilShader, GL_FALSE);
+
+            // 2. Lighting: the back faces cover every marked pixel exactly once
+            lightShader.Use();
+            glDisable(GL_DEPTH_TEST);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glEnable(GL_BLEND);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            drawLight(i, lightShader, GL_TRUE);
+        }
+        glCullFace(GL_BACK);
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_CLAMP);
+        glDisable(GL_STENCIL_TEST);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+
+    // Video memory used by the G-buffer and the light buffer in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        return (GLsizeiptr)this->Width * this->Height * (4 + 4 + 4 + 8 + 4);
+    }
+
+private:
+    GLuint lightDepthStencil;
+
+    void allocateTarget(GLuint texture, GLenum internalFormat, GLenum format, GLenum type)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, this->Width, this->Height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// GL Includes
+#include <GL/glew.h>
+
+// Counts of the GL calls that cost the driver the most: draw calls and the binds and capability switches between
+// them. Counting is compiled in only for benchmark builds (LEARNOPENGL_BENCHMARK), where the calls below are
+// redirected through counting wrappers. Include this before any other learnopengl header so every call in the
+// translation unit goes through them. Calls made by other translation units and libraries aren't counted.
+struct GLCallCounts {
+    GLuint DrawCalls;         // glDraw*, a glMultiDraw* call counts once
+    GLuint ProgramBinds;
+    GLuint TextureBinds;
+    GLuint VertexArrayBinds;
+    GLuint FramebufferBinds;
+    GLuint BufferBinds;
+    GLuint CapabilityChanges; // glEnable/glDisable
+
+    // Everything but the draw calls
+    GLuint StateChanges() const
+    {
+        return this->ProgramBinds + this->TextureBinds + this->VertexArrayBinds + this->FramebufferBinds
+             + this->BufferBinds + this->CapabilityChanges;
+    }
+};
+
+// The counts since the last reset, all zero without LEARNOPENGL_BENCHMARK
+inline GLCallCounts& GLCalls()
+{
+    static GLCallCounts counts = { 0, 0, 0, 0, 0, 0, 0 };
+    return counts;
+}
+
+inline void ResetGLCalls()
+{
+    GLCallCounts zero = { 0, 0, 0, 0, 0, 0, 0 };
+    GLCalls() = zero;
+}
+
+#ifdef LEARNOPENGL_BENCHMARK
+// The wrappers are defined before the names are redirected, so they call the real functions
+inline void countedDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    GLCalls().DrawCalls++;
+    glDrawArrays(mode, first, count);
+}
+
+inline void countedDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+    GLCalls().DrawCalls++;
+    glDrawElements(mode, count, type, indices);
+}
+
+inline void countedDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    GLCalls().DrawCalls++;
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+
+inline void countedDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei instances)
+{
+    GLCalls().DrawCalls++;
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+inline void countedMultiDrawElementsBaseVertex(GLenum mode, const GLsizei* counts, GLenum type, const GLvoid* const* indices, GLsizei drawCount, const GLint* baseVertices)
+{
+    GLCalls().DrawCalls++;
+    glMultiDrawElementsBaseVertex(mode, counts, type, indices, drawCount, baseVertices);
+}
+
+inline void countedUseProgram(GLuint program)
+{
+    GLCalls().ProgramBinds++;
+    glUseProgram(program);
+}
+
+inline void countedBindTexture(GLenum target, GLuint texture)
+{
+    GLCalls().TextureBinds++;
+    glBindTexture(target, texture);
+}
+
+inline void countedBindVertexArray(GLuint array)
+{
+    GLCalls().VertexArrayBinds++;
+    glBindVertexArray(array);
+}
+
+inline void countedBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    GLCalls().FramebufferBinds++;
+    glBindFramebuffer(target, framebuffer);
+}
+
+inline void countedBindBuffer(GLenum target, GLuint buffer)
+{
+    GLCalls().BufferBinds++;
+    glBindBuffer(target, buffer);
+}
+
+inline void countedEnable(GLenum capability)
+{
+    GLCalls().CapabilityChanges++;
+    glEnable(capability);
+}
+
+inline void countedDisable(GLenum capability)
+{
+    GLCalls().CapabilityChanges++;
+    glDisable(capability);
+}
+
+// GLEW defines the entry points past GL 1.1 as macros already
+#undef glDrawArraysInstanced
+#undef glDrawElementsInstanced
+#undef glMultiDrawElementsBaseVertex
+#undef glUseProgram
+#undef glBindVertexArray
+#undef glBindFramebuffer
+#undef glBindBuffer
+#define glDrawArrays countedDrawArrays
+#define glDrawElements countedDrawElements
+#define glDrawArraysInstanced countedDrawArraysInstanced
+#define glDrawElementsInstanced countedDrawElementsInstanced
+#define glMultiDrawElementsBaseVertex countedMultiDrawElementsBaseVertex
+#define glUseProgram countedUseProgram
+#define glBindTexture countedBindTexture
+#define glBindVertexArray countedBindVertexArray
+#define glBindFramebuffer countedBindFramebuffer
+#define glBindBuffer countedBindBuffer
+#define glEnable countedEnable
+#define glDisable countedDisable
+#endif
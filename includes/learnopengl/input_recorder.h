@@ -0,0 +1,307 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/mapped_file.h>
+
+// Records the input and clock of a demo to a binary log and plays it back, so a run can be repeated frame for frame.
+// The demo keeps its GLFW callbacks: Attach() puts the recorder in front of them, PollEvents() takes the place of
+// glfwPollEvents() and Time() the place of glfwGetTime() for everything simulated (frame delta, animations), and
+// Seed() of the time based random seed. Construct it after glfwInit().
+//   --record file.input  runs live and writes every frame's time and the key, cursor and scroll events it got
+//   --replay file.input  ignores live input (but Escape) and feeds the logged events to the callbacks instead,
+//                        on a fixed timestep: every frame advances the clock by the step and gets the events logged
+//                        up to that time. With --step 0 every frame replays one logged frame at its logged time.
+//   --step seconds       fixed timestep of the clock, 1/60 s by default when replaying and in benchmark builds,
+//                        the wall clock otherwise
+// Keyboard movement is the held keys times the frame delta, so a replay on another step moves the camera the same
+// up to a step's worth of movement per key press; mouse movement replays exactly.
+// The log holds a header ("INPT", version, seed) and then records: a frame (type 0, float time) followed by the
+// events polled in that frame, a key (1: int16 key, int16 scancode, uint8 action, uint8 mods), a cursor position
+// (2: double x, y) or a scroll (3: double x, y), all in the byte order of the machine that recorded it.
+class InputRecorder
+{
+public:
+    enum Mode { INPUT_LIVE, INPUT_RECORD, INPUT_REPLAY };
+
+    InputRecorder(int argc, char* argv[])
+        : mode(INPUT_LIVE), replayFailed(GL_FALSE), step(-1.0), time(0.0), seed(0), frame(0), nextFrame(0), log(NULL),
+          window(NULL), keyCallback(NULL), cursorCallback(NULL), scrollCallback(NULL)
+    {
+        std::string record, replay;
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument == "--record")
+                record = argv[++i];
+            else if (argument == "--replay")
+                replay = argv[++i];
+            else if (argument == "--step")
+                this->step = std::atof(argv[++i]);
+        }
+        if (!replay.empty() && this->load(replay))
+            this->mode = INPUT_REPLAY;
+        else if (!replay.empty())
+            this->replayFailed = GL_TRUE; // Runs live instead
+        else if (!record.empty())
+        {
+            this->log = fopen(record.c_str(), "wb");
+            if (!this->log)
+                std::cout << "ERROR::INPUT_RECORDER:: Failed to write " << record << std::endl;
+            else
+            {
+                this->mode = INPUT_RECORD;
+                this->seed = (GLuint)glfwGetTime();
+                GLuint version = 1;
+                fwrite("INPT", 1, 4, this->log);
+                fwrite(&version, sizeof(GLuint), 1, this->log);
+                fwrite(&this->seed, sizeof(GLuint), 1, this->log);
+            }
+        }
+        if (this->step < 0.0)
+        {
+#ifdef LEARNOPENGL_BENCHMARK
+            this->step = 1.0 / 60.0;
+#else
+            this->step = this->mode == INPUT_REPLAY ? 1.0 / 60.0 : 0.0;
+#endif
+        }
+    }
+
+    ~InputRecorder()
+    {
+        if (this->log)
+            fclose(this->log);
+        if (current() == this)
+            current() = NULL;
+    }
+
+    // Call after the demo set its own callbacks, they get the live or the replayed events from here on
+    void Attach(GLFWwindow* window)
+    {
+        this->window = window;
+        current() = this;
+        this->keyCallback = glfwSetKeyCallback(window, InputRecorder::keyEvent);
+        this->cursorCallback = glfwSetCursorPosCallback(window, InputRecorder::cursorEvent);
+        this->scrollCallback = glfwSetScrollCallback(window, InputRecorder::scrollEvent);
+    }
+
+    // Call once per frame instead of glfwPollEvents(), advances the clock and delivers the frame's events
+    void PollEvents()
+    {
+        if (this->mode != INPUT_REPLAY)
+        {
+            this->time = this->step > 0.0 ? this->frame * this->step : glfwGetTime();
+            if (this->mode == INPUT_RECORD)
+            {
+                GLubyte type = EVENT_FRAME;
+                GLfloat frameTime = (GLfloat)this->time;
+                fwrite(&type, 1, 1, this->log);
+                fwrite(&frameTime, sizeof(GLfloat), 1, this->log);
+            }
+            glfwPollEvents();
+            this->frame++;
+            return;
+        }
+
+        glfwPollEvents(); // Only Escape and the window's own events get through
+        if (this->Finished())
+            return;
+        if (this->step > 0.0)
+            this->time = this->frames[0].Time + this->frame * this->step;
+        else
+            this->time = this->frames[this->nextFrame].Time;
+        while (!this->Finished() && this->frames[this->nextFrame].Time <= this->time)
+        {
+            const std::vector<InputEvent>& events = this->frames[this->nextFrame].Events;
+            for (GLuint i = 0; i < events.size(); i++)
+                this->dispatch(events[i]);
+            this->nextFrame++;
+        }
+        this->frame++;
+    }
+
+    // Seconds on the clock of the current frame, use instead of glfwGetTime()
+    GLdouble Time() const
+    {
+        return this->time;
+    }
+
+    // Seed for the demo's random numbers: logged when recording, so a replay places everything randomly placed the
+    // same way. Fixed in benchmark builds.
+    GLuint Seed() const
+    {
+#ifdef LEARNOPENGL_BENCHMARK
+        if (this->mode == INPUT_LIVE)
+            return 0;
+#endif
+        return this->mode == INPUT_LIVE ? (GLuint)glfwGetTime() : this->seed;
+    }
+
+    GLboolean Replaying() const
+    {
+        return this->mode == INPUT_REPLAY;
+    }
+
+    // True if --replay was given but its log couldn't be read, the demo then runs on live input
+    GLboolean ReplayFailed() const
+    {
+        return this->replayFailed;
+    }
+
+    // True once a replay ran out of logged frames
+    GLboolean Finished() const
+    {
+        return this->mode == INPUT_REPLAY && this->nextFrame >= this->frames.size();
+    }
+
+private:
+    enum EventType { EVENT_FRAME, EVENT_KEY, EVENT_CURSOR, EVENT_SCROLL };
+
+    struct InputEvent {
+        GLubyte Type;
+        GLint Key, Scancode, Action, Mods;
+        GLdouble X, Y;
+    };
+
+    struct InputFrame {
+        GLfloat Time;
+        std::vector<InputEvent> Events;
+    };
+
+    Mode mode;
+    GLboolean replayFailed;
+    GLdouble step;
+    GLdouble time;
+    GLuint seed;
+    GLuint frame;
+    GLuint nextFrame; // Next logged frame to replay
+    std::vector<InputFrame> frames;
+    FILE* log;
+    GLFWwindow* window;
+    GLFWkeyfun keyCallback;
+    GLFWcursorposfun cursorCallback;
+    GLFWscrollfun scrollCallback;
+
+    // The recorder the GLFW callbacks go to
+    static InputRecorder*& current()
+    {
+        static InputRecorder* recorder = NULL;
+        return recorder;
+    }
+
+    static void keyEvent(GLFWwindow* window, int key, int scancode, int action, int mods)
+    {
+        InputRecorder* recorder = current();
+        if (recorder->mode == INPUT_REPLAY && key != GLFW_KEY_ESCAPE)
+            return;
+        if (recorder->mode == INPUT_RECORD)
+        {
+            GLubyte type = EVENT_KEY, keyAction = (GLubyte)action, keyMods = (GLubyte)mods;
+            GLshort keyCode = (GLshort)key, keyScancode = (GLshort)scancode;
+            fwrite(&type, 1, 1, recorder->log);
+            fwrite(&keyCode, sizeof(GLshort), 1, recorder->log);
+            fwrite(&keyScancode, sizeof(GLshort), 1, recorder->log);
+            fwrite(&keyAction, 1, 1, recorder->log);
+            fwrite(&keyMods, 1, 1, recorder->log);
+        }
+        if (recorder->keyCallback)
+            recorder->keyCallback(window, key, scancode, action, mods);
+    }
+
+    static void cursorEvent(GLFWwindow* window, double x, double y)
+    {
+        current()->pointerEvent(EVENT_CURSOR, x, y);
+    }
+
+    static void scrollEvent(GLFWwindow* window, double x, double y)
+    {
+        current()->pointerEvent(EVENT_SCROLL, x, y);
+    }
+
+    void pointerEvent(GLubyte type, GLdouble x, GLdouble y)
+    {
+        if (this->mode == INPUT_REPLAY)
+            return;
+        if (this->mode == INPUT_RECORD)
+        {
+            fwrite(&type, 1, 1, this->log);
+            fwrite(&x, sizeof(GLdouble), 1, this->log);
+            fwrite(&y, sizeof(GLdouble), 1, this->log);
+        }
+        InputEvent event = { type, 0, 0, 0, 0, x, y };
+        this->dispatch(event);
+    }
+
+    // Hands an event to the demo's callback for it
+    void dispatch(const InputEvent& event)
+    {
+        if (event.Type == EVENT_KEY && this->keyCallback)
+            this->keyCallback(this->window, event.Key, event.Scancode, event.Action, event.Mods);
+        else if (event.Type == EVENT_CURSOR && this->cursorCallback)
+            this->cursorCallback(this->window, event.X, event.Y);
+        else if (event.Type == EVENT_SCROLL && this->scrollCallback)
+            this->scrollCallback(this->window, event.X, event.Y);
+    }
+
+    // Reads a log into frames, false if it isn't one. A log cut short (the recording crashed) replays up to the cut.
+    bool load(const std::string& path)
+    {
+        MappedFile file(path);
+        const size_t headerSize = 4 + 2 * sizeof(GLuint);
+        GLuint version = 0;
+        if (file.Data && file.Size >= headerSize)
+            memcpy(&version, file.Data + 4, sizeof(GLuint));
+        if (!file.Data || file.Size < headerSize || memcmp(file.Data, "INPT", 4) != 0 || version != 1)
+        {
+            std::cout << "ERROR::INPUT_RECORDER:: " << path << " is not an input log" << std::endl;
+            return false;
+        }
+        memcpy(&this->seed, file.Data + 8, sizeof(GLuint));
+        const unsigned char* data = file.Data + headerSize;
+        const unsigned char* end = file.Data + file.Size;
+        while (data < end)
+        {
+            GLubyte type = *data++;
+            if (type == EVENT_FRAME && end - data >= (ptrdiff_t)sizeof(GLfloat))
+            {
+                InputFrame frame;
+                memcpy(&frame.Time, data, sizeof(GLfloat));
+                data += sizeof(GLfloat);
+                this->frames.push_back(frame);
+            }
+            else if (type == EVENT_KEY && end - data >= 6 && !this->frames.empty())
+            {
+                GLshort key, scancode;
+                memcpy(&key, data, sizeof(GLshort));
+                memcpy(&scancode, data + 2, sizeof(GLshort));
+                InputEvent event = { type, key, scancode, data[4], data[5], 0.0, 0.0 };
+                data += 6;
+                this->frames.back().Events.push_back(event);
+            }
+            else if ((type == EVENT_CURSOR || type == EVENT_SCROLL) && end - data >= (ptrdiff_t)(2 * sizeof(GLdouble)) && !this->frames.empty())
+            {
+                InputEvent event = { type, 0, 0, 0, 0, 0.0, 0.0 };
+                memcpy(&event.X, data, sizeof(GLdouble));
+                memcpy(&event.Y, data + sizeof(GLdouble), sizeof(GLdouble));
+                data += 2 * sizeof(GLdouble);
+                this->frames.back().Events.push_back(event);
+            }
+            else
+                break; // Truncated or corrupt from here on
+        }
+        std::cout << "Replaying " << this->frames.size() << " frames of input from " << path << std::endl;
+        return !this->frames.empty();
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <climits>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// GL Includes
+#include <GL/glew.h>
+
+// Other Libs
+#include <SOIL.h>
+
+// Read only view of a whole file through a memory mapping. Loaders parse straight from Data instead of copying the
+// file through stdio or stream buffers first, the pages are read in by the OS as they're touched. The mapping is
+// hinted as read front to back (MADV_SEQUENTIAL), which is how every asset loader here goes through it.
+// Data is NULL if the file can't be opened. An empty file maps nothing but still counts as opened, with Size 0.
+class MappedFile
+{
+public:
+    const unsigned char* Data;
+    size_t Size;
+
+    MappedFile() : Data(NULL), Size(0), mapping(NULL)
+    {
+    }
+
+    explicit MappedFile(const std::string& path) : Data(NULL), Size(0), mapping(NULL)
+    {
+        this->Open(path);
+    }
+
+    ~MappedFile()
+    {
+        this->Close();
+    }
+
+    // Maps path, replacing any previous mapping. Returns false if it can't be opened.
+    bool Open(const std::string& path)
+    {
+        this->Close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return false;
+        }
+        this->Size = (size_t)size.QuadPart;
+        if (this->Size > 0)
+        {
+            HANDLE view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (view)
+            {
+                this->mapping = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(view); // The view keeps the mapping alive
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+        struct stat info;
+        if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            close(file);
+            return false;
+        }
+        this->Size = (size_t)info.st_size;
+        if (this->Size > 0)
+        {
+            void* mapped = mmap(NULL, this->Size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapped != MAP_FAILED)
+            {
+                madvise(mapped, this->Size, MADV_SEQUENTIAL);
+                this->mapping = mapped;
+            }
+        }
+        close(file); // The mapping keeps the file alive
+#endif
+        if (this->Size > 0 && !this->mapping)
+        {
+            this->Size = 0;
+            return false;
+        }
+        static const unsigned char empty = 0;
+        this->Data = this->mapping ? (const unsigned char*)this->mapping : &empty;
+        return true;
+    }
+
+    void Close()
+    {
+        if (this->mapping)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(this->mapping);
+#else
+            munmap(this->mapping, this->Size);
+#endif
+        }
+        this->mapping = NULL;
+        this->Data = NULL;
+        this->Size = 0;
+    }
+
+private:
+    void* mapping;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// SOIL_load_image() decoding straight from a mapping of the file, same arguments and result
+inline unsigned char* LoadImageMapped(const std::string& path, GLint* width, GLint* height, GLint* channels, GLint forceChannels)
+{
+    MappedFile file(path);
+    if (!file.Data || file.Size == 0 || file.Size > INT_MAX)
+        return NULL;
+    return SOIL_load_image_from_memory(file.Data, (int)file.Size, width, height, channels, forceChannels);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <sys/stat.h>
+
+// Other Libs
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+#include <learnopengl/mapped_file.h>
+
+// Assimp file access through MappedFile: a model's files (the .obj, its .mtl, ...) are mapped instead of read
+// through stdio, so the importer's reads are copies out of the page cache without a system call each.
+// Read only, opening a file for writing fails. Hand one to Assimp::Importer::SetIOHandler(), which owns it from then on.
+class MappedIOStream : public Assimp::IOStream
+{
+public:
+    MappedFile File;
+
+    MappedIOStream(const std::string& path) : File(path), position(0)
+    {
+    }
+
+    size_t Read(void* buffer, size_t size, size_t count)
+    {
+        if (size == 0)
+            return 0;
+        count = std::min(count, (this->File.Size - this->position) / size);
+        memcpy(buffer, this->File.Data + this->position, size * count);
+        this->position += size * count;
+        return count;
+    }
+
+    size_t Write(const void* buffer, size_t size, size_t count)
+    {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin)
+    {
+        size_t target = origin == aiOrigin_SET ? offset : origin == aiOrigin_CUR ? this->position + offset : this->File.Size + offset;
+        if (target > this->File.Size)
+            return aiReturn_FAILURE;
+        this->position = target;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const
+    {
+        return this->position;
+    }
+
+    size_t FileSize() const
+    {
+        return this->File.Size;
+    }
+
+    void Flush()
+    {
+    }
+
+private:
+    size_t position;
+};
+
+class MappedIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char* file) const
+    {
+        struct stat info;
+        return stat(file, &info) == 0;
+    }
+
+    char getOsSeparator() const
+    {
+        return '/';
+    }
+
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb")
+    {
+        if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+'))
+            return NULL;
+        MappedIOStream* stream = new MappedIOStream(file);
+        if (!stream->File.Data)
+        {
+            delete stream;
+            return NULL;
+        }
+        return stream;
+    }
+
+    void Close(Assimp::IOStream* file)
+    {
+        delete file;
+    }
+};
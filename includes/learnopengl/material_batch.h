@@ -0,0 +1,207 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <cstddef>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+#include <learnopengl/texture_arrays.h>
+
+// Draws the static model instances of a scene with one glMultiDrawElementsBaseVertex call instead of a draw call and
+// texture binds per mesh. The meshes' vertices are transformed to world space once and merged into one buffer, each
+// vertex carrying the array and layer of its mesh's diffuse texture (packed into TextureArrays), so the shader picks
+// the texture and no state changes between meshes. Meshes outside the view frustum are left out of the call.
+// Only for instances that never move: Add() every instance, then Build() once.
+// The arrays hold every level of every texture and are not streamed; count Arrays.MemoryBytes() against any texture
+// budget (TextureResidency::ReservedBytes). The models keep their own textures for drawing unbatched, so while the
+// batch draws them those copies go untouched and a TextureResidency frees their finer levels first when short.
+class MaterialBatch
+{
+public:
+    TextureArrays Arrays;
+    // Work of the last Draw()
+    GLuint DrawCalls, TextureBinds, MeshesDrawn;
+    // What the meshes drawn would have cost through Model::Draw()
+    GLuint UnbatchedDrawCalls, UnbatchedTextureBinds;
+
+    MaterialBatch(GLint maxTextureSize = 1024)
+        : Arrays(64, maxTextureSize), DrawCalls(0), TextureBinds(0), MeshesDrawn(0), UnbatchedDrawCalls(0),
+          UnbatchedTextureBinds(0), shader("shaders/model_batch.vs", "shaders/model_batch.frag"), VAO(0), VBO(0), EBO(0)
+    {
+    }
+
+    ~MaterialBatch()
+    {
+        glDeleteVertexArrays(1, &this->VAO);
+        glDeleteBuffers(1, &this->VBO);
+        glDeleteBuffers(1, &this->EBO);
+    }
+
+    // Adds an instance of model placed by transform
+    void Add(const Model& model, const glm::mat4& transform)
+    {
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+        GLfloat scale = std::sqrt(std::max(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                                    glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+                                           glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+        for (GLuint i = 0; i < model.meshes.size(); i++)
+        {
+            const Mesh& mesh = model.meshes[i];
+            Range range;
+            range.FirstIndex = this->indices.size();
+            range.IndexCount = mesh.indices.size();
+            range.BaseVertex = this->vertices.size();
+            range.VertexCount = mesh.vertices.size();
+            range.Center = glm::vec3(transform * glm::vec4(mesh.Center, 1.0f));
+            range.Radius = mesh.Radius * scale;
+            range.TextureCount = mesh.textures.size();
+            // The shader samples the texture on unit 0, the mesh's first one
+            range.Texture = mesh.textures.empty() ? -1 : (GLint)this->Arrays.Add(model.directory + '/' + mesh.textures[0].path.C_Str());
+            this->ranges.push_back(range);
+            for (GLuint j = 0; j < mesh.vertices.size(); j++)
+            {
+                BatchVertex vertex;
+                vertex.Position = glm::vec3(transform * glm::vec4(mesh.vertices[j].Position, 1.0f));
+                vertex.Normal = normalMatrix * mesh.vertices[j].Normal;
+                vertex.TexCoords = mesh.vertices[j].TexCoords;
+                this->vertices.push_back(vertex);
+            }
+            this->indices.insert(this->indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+    }
+
+    // Packs the textures and uploads the merged meshes
+    void Build()
+    {
+        this->Arrays.Build();
+        for (GLuint i = 0; i < this->ranges.size(); i++)
+        {
+            glm::ivec2 slot = this->ranges[i].Texture < 0 ? glm::ivec2(-1, -1) : this->Arrays.Slot(this->ranges[i].Texture);
+            for (GLsizei j = 0; j < this->ranges[i].VertexCount; j++)
+                this->vertices[this->ranges[i].BaseVertex + j].Material = slot;
+        }
+        glGenVertexArrays(1, &this->VAO);
+        glGenBuffers(1, &this->VBO);
+        glGenBuffers(1, &this->EBO);
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(BatchVertex), this->vertices.empty() ? NULL : &this->vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), this->indices.empty() ? NULL : &this->indices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)offsetof(BatchVertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)offsetof(BatchVertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (GLvoid*)offsetof(BatchVertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 2, GL_INT, sizeof(BatchVertex), (GLvoid*)offsetof(BatchVertex, Material));
+        glBindVertexArray(0);
+        // The GPU copies are all that's needed from here on
+        std::vector<BatchVertex>().swap(this->vertices);
+        std::vector<GLuint>().swap(this->indices);
+    }
+
+    // Draws the meshes that intersect the view frustum
+    void Draw(const glm::mat4& view, const glm::mat4& projection)
+    {
+        this->Draw(view, projection, projection);
+    }
+
+    // Same as above, culled against cullProjection instead, e.g. the unjittered projection while TAA jitters projection
+    void Draw(const glm::mat4& view, const glm::mat4& projection, const glm::mat4& cullProjection)
+    {
+        // Frustum planes from the rows of the view projection matrix, pointing inwards
+        glm::mat4 viewProjection = cullProjection * view;
+        glm::vec4 planes[6];
+        for (GLint i = 0; i < 3; i++)
+        {
+            glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+        this->counts.clear();
+        this->offsets.clear();
+        this->baseVertices.clear();
+        this->UnbatchedDrawCalls = this->UnbatchedTextureBinds = 0;
+        for (GLuint i = 0; i < this->ranges.size(); i++)
+        {
+            const Range& range = this->ranges[i];
+            GLboolean visible = GL_TRUE;
+            for (GLint p = 0; p < 6 && visible; p++)
+                visible = glm::dot(glm::vec3(planes[p]), range.Center) + planes[p].w >= -range.Radius * glm::length(glm::vec3(planes[p]));
+            if (!visible)
+                continue;
+            this->counts.push_back(range.IndexCount);
+            this->offsets.push_back((GLvoid*)(range.FirstIndex * sizeof(GLuint)));
+            this->baseVertices.push_back(range.BaseVertex);
+            this->UnbatchedDrawCalls++;
+            this->UnbatchedTextureBinds += range.TextureCount;
+        }
+        this->MeshesDrawn = this->counts.size();
+        this->DrawCalls = this->TextureBinds = 0;
+        if (this->counts.empty())
+            return;
+
+        this->shader.Use();
+        glUniformMatrix4fv(glGetUniformLocation(this->shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(this->shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        this->TextureBinds = this->Arrays.Bind(this->shader, 0);
+        // Samplers of different types can't share a unit, keep the 2D shadow map off the arrays' units
+        glUniform1i(glGetUniformLocation(this->shader.Program, "shadowMap"), TextureArrays::MAX_ARRAYS);
+        glBindVertexArray(this->VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, &this->counts[0], GL_UNSIGNED_INT, &this->offsets[0], this->counts.size(), &this->baseVertices[0]);
+        glBindVertexArray(0);
+        this->DrawCalls = 1;
+    }
+
+    // Prints the cost of the last Draw() against drawing the same meshes one by one
+    void PrintStats()
+    {
+        std::cout << "Material batch: " << this->MeshesDrawn << " of " << this->ranges.size() << " meshes in " << this->DrawCalls
+                  << " draw calls with " << this->TextureBinds << " texture binds (" << this->UnbatchedDrawCalls << " and "
+                  << this->UnbatchedTextureBinds << " unbatched), " << this->Arrays.TextureCount() << " textures in "
+                  << this->Arrays.Arrays.size() << " arrays, " << this->Arrays.MemoryBytes() / (1024.0f * 1024.0f) << " MB" << std::endl;
+    }
+
+private:
+    struct BatchVertex {
+        glm::vec3 Position;
+        glm::vec3 Normal;
+        glm::vec2 TexCoords;
+        glm::ivec2 Material; // Texture array and layer, (-1, -1) for none
+    };
+
+    // A mesh instance in the merged buffers
+    struct Range {
+        GLuint FirstIndex;
+        GLsizei IndexCount;
+        GLint BaseVertex;
+        GLsizei VertexCount;
+        glm::vec3 Center; // World space bounding sphere
+        GLfloat Radius;
+        GLuint TextureCount;
+        GLint Texture;    // Index in Arrays, -1 without textures
+    };
+
+    Shader shader;
+    GLuint VAO, VBO, EBO;
+    std::vector<BatchVertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<Range> ranges;
+    // Arguments of the multi-draw, rebuilt every Draw()
+    std::vector<GLsizei> counts;
+    std::vector<GLvoid*> offsets;
+    std::vector<GLint> baseVertices;
+};
@@ -34,6 +34,10 @@ public:
     vector<GLuint> indices;
     vector<Texture> textures;
     GLuint VAO;
+    // Bounding sphere in model space and the texture coordinate range across the mesh, for texture residency
+    glm::vec3 Center;
+    GLfloat Radius;
+    GLfloat TexCoordRange;
 
     /*  Functions  */
     // Constructor
@@ -42,6 +46,7 @@ public:
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->computeBounds();
 
         // Now that we have all the required data, set the vertex buffers and its attribute pointers.
         this->setupMesh();
@@ -89,6 +94,23 @@ private:
     GLuint VBO, EBO;
 
     /*  Functions    */
+    // Sphere around the bounding box and the larger of the u and v ranges
+    void computeBounds()
+    {
+        glm::vec3 minPosition(0.0f), maxPosition(0.0f);
+        glm::vec2 minTexCoords(0.0f), maxTexCoords(0.0f);
+        for(GLuint i = 0; i < this->vertices.size(); i++)
+        {
+            minPosition = i == 0 ? this->vertices[i].Position : glm::min(minPosition, this->vertices[i].Position);
+            maxPosition = i == 0 ? this->vertices[i].Position : glm::max(maxPosition, this->vertices[i].Position);
+            minTexCoords = i == 0 ? this->vertices[i].TexCoords : glm::min(minTexCoords, this->vertices[i].TexCoords);
+            maxTexCoords = i == 0 ? this->vertices[i].TexCoords : glm::max(maxTexCoords, this->vertices[i].TexCoords);
+        }
+        this->Center = (minPosition + maxPosition) * 0.5f;
+        this->Radius = glm::length(maxPosition - minPosition) * 0.5f;
+        this->TexCoordRange = glm::max(maxTexCoords.x - minTexCoords.x, maxTexCoords.y - minTexCoords.y);
+    }
+
     // Initializes all the buffer objects/arrays
     void setupMesh()
     {
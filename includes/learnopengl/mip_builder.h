@@ -0,0 +1,369 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_BUILDER_SSE 1
+#include <emmintrin.h>
+#endif
+
+enum MipFilter {
+    MIP_FILTER_BOX,    // 2x2 average, cheap
+    MIP_FILTER_KAISER  // 6x6 Kaiser windowed sinc, sharper distant textures with less aliasing
+};
+
+// One level of a mip chain, 8 bits per channel with the channel count of the source
+struct MipLevel {
+    GLint Width, Height;
+    std::vector<unsigned char> Pixels;
+};
+
+// Builds complete mip chains on the CPU, so they can be made on worker threads and uploaded (or baked) with the
+// image instead of calling glGenerateMipmap on the GL thread.
+//   - sRGB textures (SRGB) are filtered in linear space: averaging the encoded values darkens every level.
+//   - With AlphaCutoff > 0 the alpha of every level is scaled so the same fraction of texels passes the alpha test
+//     as in the base level (Castano, "Computing Alpha Mipmaps"). Averaging alone makes alpha tested foliage
+//     (grass, thorns) thin out and vanish in the distance.
+// Levels are filtered from the previous one in float RGBA, one pixel per SSE register; the rows of every pass are
+// split over ThreadCount threads.
+class MipBuilder
+{
+public:
+    MipFilter Filter;
+    GLboolean SRGB;
+    GLfloat AlphaCutoff;
+    GLuint ThreadCount;
+    GLboolean UseSIMD; // Falls back to the scalar kernels when false or when SSE2 isn't available
+
+    MipBuilder(MipFilter filter = MIP_FILTER_BOX, GLboolean srgb = GL_FALSE, GLfloat alphaCutoff = 0.0f, GLuint threadCount = 0)
+        : Filter(filter), SRGB(srgb), AlphaCutoff(alphaCutoff),
+          ThreadCount(threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())), UseSIMD(GL_TRUE)
+    {
+        // Kaiser windowed sinc for a 2:1 reduction, taps at -2.5 ... 2.5 source pixels from the output pixel center
+        GLfloat sum = 0.0f;
+        for (GLint i = 0; i < KAISER_TAPS; i++)
+        {
+            GLfloat x = i - KAISER_TAPS / 2 + 0.5f;
+            this->kaiser[i] = sinc(x * 0.5f) * besselI0(KAISER_ALPHA * std::sqrt(std::max(1.0f - (x / 3.0f) * (x / 3.0f), 0.0f))) / besselI0(KAISER_ALPHA);
+            sum += this->kaiser[i];
+        }
+        for (GLint i = 0; i < KAISER_TAPS; i++)
+            this->kaiser[i] /= sum;
+    }
+
+    // Number of levels of a full chain down to 1x1
+    static GLuint LevelCount(GLint width, GLint height)
+    {
+        GLuint levels = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+            levels++;
+        }
+        return levels;
+    }
+
+    // Fills levels with the whole chain of an 8 bit image with 1 to 4 channels, levels[0] being a copy of the image
+    // (none if image is NULL, e.g. a failed load)
+    void Build(const unsigned char* image, GLint width, GLint height, GLint channels, std::vector<MipLevel>& levels) const
+    {
+        if (!image || width <= 0 || height <= 0)
+        {
+            levels.clear();
+            return;
+        }
+        levels.resize(LevelCount(width, height));
+        levels[0].Width = width;
+        levels[0].Height = height;
+        levels[0].Pixels.assign(image, image + width * height * channels);
+        if (levels.size() == 1)
+            return;
+
+        // Base level to linear float RGBA
+        const GLfloat* toLinear = srgbToLinear();
+        std::vector<GLfloat> current(width * height * 4), next, scratch;
+        for (GLint i = 0; i < width * height; i++)
+        {
+            const unsigned char* pixel = image + i * channels;
+            GLfloat* out = &current[i * 4];
+            for (GLint c = 0; c < 3; c++)
+            {
+                unsigned char value = pixel[channels < 3 ? 0 : c];
+                out[c] = this->SRGB ? toLinear[value] : value / 255.0f;
+            }
+            out[3] = (channels == 2 || channels == 4) ? pixel[channels - 1] / 255.0f : 1.0f;
+        }
+        GLfloat coverage = this->AlphaCutoff > 0.0f ? alphaCoverage(&current[0], width * height, this->AlphaCutoff, 1.0f) : 0.0f;
+
+        for (GLuint level = 1; level < levels.size(); level++)
+        {
+            GLint levelWidth = std::max(width / 2, 1), levelHeight = std::max(height / 2, 1);
+            next.resize(levelWidth * levelHeight * 4);
+            this->downsample(&current[0], width, height, &next[0], levelWidth, levelHeight, scratch);
+            current.swap(next);
+            width = levelWidth;
+            height = levelHeight;
+
+            // Scale the alpha of the stored level (the next one is still filtered from the unscaled values)
+            GLfloat alphaScale = 1.0f;
+            if (this->AlphaCutoff > 0.0f)
+                alphaScale = coverageScale(&current[0], width * height, this->AlphaCutoff, coverage);
+            levels[level].Width = width;
+            levels[level].Height = height;
+            levels[level].Pixels.resize(width * height * channels);
+            this->encode(&current[0], width * height, channels, alphaScale, &levels[level].Pixels[0]);
+        }
+    }
+
+private:
+    static const GLint KAISER_TAPS = 6;
+    static const GLint KAISER_ALPHA = 4;
+    GLfloat kaiser[KAISER_TAPS]; // Normalized weights
+
+    static GLfloat sinc(GLfloat x)
+    {
+        return x == 0.0f ? 1.0f : std::sin(3.14159265f * x) / (3.14159265f * x);
+    }
+
+    static GLfloat besselI0(GLfloat x)
+    {
+        GLfloat sum = 1.0f, term = 1.0f;
+        for (GLint k = 1; k < 20; k++)
+        {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Linear values of the sRGB codes offset, offset + 1, ... (tables are built once, thread safe as local statics)
+    static std::vector<GLfloat> srgbTable(GLfloat offset, GLint count)
+    {
+        std::vector<GLfloat> table(count);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLfloat c = (i + offset) / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }
+
+    static const GLfloat* srgbToLinear()
+    {
+        static const std::vector<GLfloat> table = srgbTable(0.0f, 256);
+        return &table[0];
+    }
+
+    // Linear values halfway between consecutive sRGB codes, so encoding rounds to the nearest code
+    static const GLfloat* srgbThresholds()
+    {
+        static const std::vector<GLfloat> table = srgbTable(0.5f, 255);
+        return &table[0];
+    }
+
+    // Fraction of the pixels whose scaled alpha passes the cutoff
+    static GLfloat alphaCoverage(const GLfloat* pixels, GLint count, GLfloat cutoff, GLfloat scale)
+    {
+        GLint passed = 0;
+        for (GLint i = 0; i < count; i++)
+            if (pixels[i * 4 + 3] * scale >= cutoff)
+                passed++;
+        return (GLfloat)passed / count;
+    }
+
+    // Alpha scale that gives a level the target coverage, by bisection
+    static GLfloat coverageScale(const GLfloat* pixels, GLint count, GLfloat cutoff, GLfloat coverage)
+    {
+        GLfloat low = 0.0f, high = 4.0f, scale = 1.0f;
+        for (GLint i = 0; i < 10; i++)
+        {
+            GLfloat current = alphaCoverage(pixels, count, cutoff, scale);
+            if (current < coverage)
+                low = scale;
+            else if (current > coverage)
+                high = scale;
+            else
+                break;
+            scale = (low + high) * 0.5f;
+        }
+        return scale;
+    }
+
+    // Float RGBA back to 8 bit with the source channel count
+    void encode(const GLfloat* pixels, GLint count, GLint channels, GLfloat alphaScale, unsigned char* out) const
+    {
+        const GLfloat* thresholds = srgbThresholds();
+        for (GLint i = 0; i < count; i++)
+        {
+            const GLfloat* pixel = pixels + i * 4;
+            unsigned char rgba[4];
+            for (GLint c = 0; c < 3; c++)
+            {
+                if (this->SRGB)
+                    rgba[c] = (unsigned char)(std::upper_bound(thresholds, thresholds + 255, pixel[c]) - thresholds);
+                else
+                    rgba[c] = (unsigned char)(std::min(std::max(pixel[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+            rgba[3] = (unsigned char)(std::min(std::max(pixel[3] * alphaScale, 0.0f), 1.0f) * 255.0f + 0.5f);
+            if (channels >= 3)
+            {
+                for (GLint c = 0; c < 3; c++)
+                    out[i * channels + c] = rgba[c];
+                if (channels == 4)
+                    out[i * channels + 3] = rgba[3];
+            }
+            else
+            {
+                out[i * channels] = rgba[0];
+                if (channels == 2)
+                    out[i * channels + 1] = rgba[3];
+            }
+        }
+    }
+
+    // Filters src (width x height float RGBA) into dst (levelWidth x levelHeight)
+    void downsample(const GLfloat* src, GLint width, GLint height, GLfloat* dst, GLint levelWidth, GLint levelHeight, std::vector<GLfloat>& scratch) const
+    {
+        if (this->Filter == MIP_FILTER_KAISER)
+        {
+            // Separable: horizontally into scratch (full height), then vertically
+            scratch.resize(levelWidth * height * 4);
+            GLfloat* horizontal = &scratch[0];
+            this->parallelRows(height, [=](GLint first, GLint last) {
+                this->kaiserRows(src, width, horizontal, levelWidth, first, last);
+            });
+            this->parallelRows(levelHeight, [=](GLint first, GLint last) {
+                for (GLint y = first; y < last; y++)
+                    this->kaiserColumns(horizontal, height, levelWidth, dst + y * levelWidth * 4, y);
+            });
+        }
+        else
+        {
+            this->parallelRows(levelHeight, [=](GLint first, GLint last) {
+                this->boxRows(src, width, height, dst, levelWidth, first, last);
+            });
+        }
+    }
+
+    // Runs rows [0, count) as contiguous ranges on up to ThreadCount threads; small levels stay on the caller
+    template <typename Function>
+    void parallelRows(GLint count, Function function) const
+    {
+        GLint threads = std::min((GLint)this->ThreadCount, std::max(count / 16, 1));
+        if (threads <= 1)
+        {
+            function(0, count);
+            return;
+        }
+        GLint rowsPerThread = (count + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        for (GLint first = rowsPerThread; first < count; first += rowsPerThread)
+            workers.push_back(std::thread(function, first, std::min(first + rowsPerThread, count)));
+        function(0, std::min(rowsPerThread, count));
+        for (GLuint i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    // 2x2 average with the last row/column repeated for odd sizes
+    void boxRows(const GLfloat* src, GLint width, GLint height, GLfloat* dst, GLint levelWidth, GLint first, GLint last) const
+    {
+        for (GLint y = first; y < last; y++)
+        {
+            const GLfloat* row0 = src + std::min(y * 2, height - 1) * width * 4;
+            const GLfloat* row1 = src + std::min(y * 2 + 1, height - 1) * width * 4;
+            GLfloat* out = dst + y * levelWidth * 4;
+            for (GLint x = 0; x < levelWidth; x++)
+            {
+                GLint x0 = std::min(x * 2, width - 1) * 4, x1 = std::min(x * 2 + 1, width - 1) * 4;
+#ifdef MIP_BUILDER_SSE
+                if (this->UseSIMD)
+                {
+                    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+                                            _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+                    _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+                    continue;
+                }
+#endif
+                for (GLint c = 0; c < 4; c++)
+                    out[x * 4 + c] = ((row0[x0 + c] + row0[x1 + c]) + (row1[x0 + c] + row1[x1 + c])) * 0.25f; // Same order as the SSE path
+            }
+        }
+    }
+
+    // Horizontal Kaiser pass over rows [first, last), edges clamped
+    void kaiserRows(const GLfloat* src, GLint width, GLfloat* dst, GLint levelWidth, GLint first, GLint last) const
+    {
+        for (GLint y = first; y < last; y++)
+        {
+            const GLfloat* row = src + y * width * 4;
+            GLfloat* out = dst + y * levelWidth * 4;
+            for (GLint x = 0; x < levelWidth; x++)
+            {
+                const GLfloat* taps[KAISER_TAPS];
+                for (GLint t = 0; t < KAISER_TAPS; t++)
+                    taps[t] = row + std::min(std::max(x * 2 - KAISER_TAPS / 2 + 1 + t, 0), width - 1) * 4;
+                this->filter(taps, out + x * 4);
+            }
+        }
+    }
+
+    // Vertical Kaiser pass producing output row y
+    void kaiserColumns(const GLfloat* src, GLint height, GLint levelWidth, GLfloat* out, GLint y) const
+    {
+        const GLfloat* rows[KAISER_TAPS];
+        for (GLint t = 0; t < KAISER_TAPS; t++)
+            rows[t] = src + std::min(std::max(y * 2 - KAISER_TAPS / 2 + 1 + t, 0), height - 1) * levelWidth * 4;
+        for (GLint x = 0; x < levelWidth; x++)
+        {
+            const GLfloat* taps[KAISER_TAPS];
+            for (GLint t = 0; t < KAISER_TAPS; t++)
+                taps[t] = rows[t] + x * 4;
+            this->filter(taps, out + x * 4);
+        }
+    }
+
+    // Weighted sum of KAISER_TAPS RGBA pixels
+    void filter(const GLfloat* const* taps, GLfloat* out) const
+    {
+#ifdef MIP_BUILDER_SSE
+        if (this->UseSIMD)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (GLint t = 0; t < KAISER_TAPS; t++)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(taps[t]), _mm_set1_ps(this->kaiser[t])));
+            _mm_storeu_ps(out, sum);
+            return;
+        }
+#endif
+        for (GLint c = 0; c < 4; c++)
+        {
+            GLfloat sum = 0.0f;
+            for (GLint t = 0; t < KAISER_TAPS; t++)
+                sum += taps[t][c] * this->kaiser[t];
+            out[c] = sum;
+        }
+    }
+};
+
+// Uploads a chain made by MipBuilder::Build to the bound GL_TEXTURE_2D and limits sampling to the levels present
+inline void UploadMipChain(const std::vector<MipLevel>& levels, GLenum internalFormat, GLenum format)
+{
+    if (levels.empty())
+        return;
+    // Rows of the small levels aren't 4 byte aligned
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLuint i = 0; i < levels.size(); i++)
+        glTexImage2D(GL_TEXTURE_2D, i, internalFormat, levels[i].Width, levels[i].Height, 0, format, GL_UNSIGNED_BYTE, &levels[i].Pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+}
@@ -17,8 +17,11 @@ using namespace std;
 #include <assimp/postprocess.h>
 
 #include <learnopengl/mesh.h>
+#include <learnopengl/texture_baker.h>
+#include <learnopengl/texture_residency.h>
+#include <learnopengl/mapped_io_system.h>
 
-GLint TextureFromFile(const char* path, string directory, bool gamma = false);
+GLint TextureFromFile(const char* path, string directory, bool gamma = false, GLfloat alphaCutoff = 0.0f);
 
 class Model 
 {
@@ -28,10 +31,14 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    TextureResidency* residency; // Streams the textures in as far as they're needed if set, loads them whole otherwise
+    GLfloat alphaCutoff;         // Alpha test threshold of a model drawn with discard, 0 if it's opaque
 
     /*  Functions   */
-    // Constructor, expects a filepath to a 3D model.
-    Model(GLchar* path, bool gamma = false) : gammaCorrection(gamma)
+    // Constructor, expects a filepath to a 3D model. The textures of an alpha tested model are loaded with alpha and
+    // mips that keep the coverage of alphaCutoff.
+    Model(GLchar* path, bool gamma = false, TextureResidency* residency = NULL, GLfloat alphaCutoff = 0.0f)
+        : gammaCorrection(gamma), residency(residency), alphaCutoff(alphaCutoff)
     {
         this->loadModel(path);
     }
@@ -42,6 +49,21 @@ public:
         for(GLuint i = 0; i < this->meshes.size(); i++)
             this->meshes[i].Draw(shader);
     }
+
+    // Tells the residency manager how large the meshes of this instance appear this frame
+    void RequestTextures(const glm::mat4& model)
+    {
+        if (!this->residency)
+            return;
+        GLfloat scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        for(GLuint i = 0; i < this->meshes.size(); i++)
+        {
+            const Mesh& mesh = this->meshes[i];
+            glm::vec3 center = glm::vec3(model * glm::vec4(mesh.Center, 1.0f));
+            for(GLuint j = 0; j < mesh.textures.size(); j++)
+                this->residency->Touch(mesh.textures[j].id, center, mesh.Radius * scale, mesh.TexCoordRange);
+        }
+    }
     
 private:
     /*  Functions   */
@@ -50,6 +72,8 @@ private:
     {
         // Read file via ASSIMP
         Assimp::Importer importer;
+        // Files are mapped rather than read through stdio, the importer owns the handler
+        importer.SetIOHandler(new MappedIOSystem());
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
         // Check for errors
         if(!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
@@ -173,7 +197,11 @@ private:
             if(!skip)
             {   // If texture hasn't been loaded already, load it
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                if (this->residency)
+                    texture.id = this->residency->Load(this->directory + '/' + string(str.C_Str()), this->gammaCorrection,
+                                                       this->alphaCutoff > 0.0f, this->alphaCutoff);
+                else
+                    texture.id = TextureFromFile(str.C_Str(), this->directory, false, this->alphaCutoff);
                 texture.type = typeName;
                 texture.path = str;
                 textures.push_back(texture);
@@ -187,19 +215,35 @@ private:
 
 
 
-GLint TextureFromFile(const char* path, string directory, bool gamma)
+// alphaCutoff > 0 loads the texture with alpha, see Model
+GLint TextureFromFile(const char* path, string directory, bool gamma, GLfloat alphaCutoff)
 {
      //Generate texture ID and load texture data 
     string filename = string(path);
     filename = directory + '/' + filename;
-    GLuint textureID;
+    // Compressed with precomputed mips if possible, the decoded image otherwise
+    GLboolean alpha = alphaCutoff > 0.0f;
+    GLuint textureID = LoadTextureBaked(filename, gamma, alpha, alphaCutoff);
+    if (textureID != 0)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return textureID;
+    }
     glGenTextures(1, &textureID);
     int width,height;
-    unsigned char* image = SOIL_load_image(filename.c_str(), &width, &height, 0, SOIL_LOAD_RGB);
+    unsigned char* image = LoadImageMapped(filename, &width, &height, 0, alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+    // Mips are filtered on the CPU, in linear space for sRGB textures and keeping the alpha test coverage
+    std::vector<MipLevel> levels;
+    MipBuilder(MIP_FILTER_BOX, gamma, alphaCutoff).Build(image, width, height, alpha ? 4 : 3, levels);
     // Assign texture to ID
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, gamma ? GL_SRGB : GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);	
+    if (alpha)
+        UploadMipChain(levels, gamma ? GL_SRGB_ALPHA : GL_RGBA, GL_RGBA);
+    else
+        UploadMipChain(levels, gamma ? GL_SRGB : GL_RGB, GL_RGB);
 
     // Parameters
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
@@ -0,0 +1,130 @@
+#pragma once
+
+// Std. Includes
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/screen_quad.h>
+
+// Weighted blended order-independent transparency (McGuire & Bavoil, JCGT 2013).
+// Transparent surfaces are accumulated in any order into two render targets that share the depth buffer
+// of the opaque pass, then resolved on top of the opaque image with a single full-screen composite.
+// No CPU sorting is needed, so a whole transparent set can be drawn as one unsorted (instanced) batch.
+//
+// To stay within OpenGL 3.3 core (no per draw buffer blend functions) both targets use the same
+// glBlendFuncSeparate(ONE, ONE, ZERO, ONE_MINUS_SRC_ALPHA):
+//   AccumTexture  (RGBA16F) rgb = sum(premultiplied color * weight)   a = product(1 - alpha)  (revealage)
+//   WeightTexture (R16F)    r   = sum(alpha * weight)
+// Transparent fragment shaders therefore write vec4(color.rgb * color.a * w, color.a) to location 0
+// and color.a * w to location 1 (see shaders/blending_oit.frag).
+class WeightedBlendedOIT
+{
+public:
+    GLuint FBO;
+    GLuint AccumTexture;
+    GLuint WeightTexture;
+    GLuint Width, Height;
+
+    // Constructor, depthAttachment is the depth attachment of the opaque pass so transparent fragments get depth tested against it,
+    // a renderbuffer or a 2D texture as given by depthTarget
+    WeightedBlendedOIT(GLuint width, GLuint height, GLuint depthAttachment, GLenum depthTarget = GL_RENDERBUFFER)
+        : FBO(0), AccumTexture(0), WeightTexture(0), Width(0), Height(0)
+    {
+        glGenFramebuffers(1, &this->FBO);
+        glGenTextures(1, &this->AccumTexture);
+        glGenTextures(1, &this->WeightTexture);
+        this->Resize(width, height, depthAttachment, depthTarget);
+    }
+
+    ~WeightedBlendedOIT()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(1, &this->AccumTexture);
+        glDeleteTextures(1, &this->WeightTexture);
+    }
+
+    // (Re)allocates the accumulation targets, call it whenever the opaque targets are resized
+    void Resize(GLuint width, GLuint height, GLuint depthAttachment, GLenum depthTarget = GL_RENDERBUFFER)
+    {
+        this->Width = width;
+        this->Height = height;
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        allocateTarget(this->AccumTexture, GL_RGBA16F, GL_RGBA);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->AccumTexture, 0);
+        allocateTarget(this->WeightTexture, GL_R16F, GL_RED);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, this->WeightTexture, 0);
+        if (depthTarget == GL_RENDERBUFFER)
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthAttachment);
+        else
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTarget, depthAttachment, 0);
+        GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::OIT:: Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Binds the accumulation targets and sets up the blend/depth state for the transparent geometry.
+    // Depth testing stays enabled against the opaque depth, depth writes are disabled.
+    void BeginTransparent()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glViewport(0, 0, this->Width, this->Height);
+        GLfloat accumClear[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // revealage starts at 1 (nothing covers the pixel)
+        GLfloat weightClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, accumClear);
+        glClearBufferfv(GL_COLOR, 1, weightClear);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // Restores the default state after the transparent geometry has been drawn
+    void EndTransparent()
+    {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Resolves the accumulated transparency over whatever framebuffer/draw buffer is currently bound
+    // (normally the opaque color buffer). Expects shaders/oit_composite.frag.
+    void Composite(Shader& compositeShader)
+    {
+        compositeShader.Use();
+        glUniform1i(glGetUniformLocation(compositeShader.Program, "accumTexture"), 0);
+        glUniform1i(glGetUniformLocation(compositeShader.Program, "weightTexture"), 1);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, this->AccumTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, this->WeightTexture);
+
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        RenderScreenQuad();
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    void allocateTarget(GLuint texture, GLint internalFormat, GLenum format)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, this->Width, this->Height, 0, format, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
@@ -0,0 +1,442 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/shadow_atlas.h>
+
+// A shadow caster for point lights: a bounding sphere for culling and a function drawing the mesh
+struct PointShadowCaster {
+    glm::vec3 Center;
+    GLfloat Radius;
+    GLboolean Dynamic; // Moves every frame, the faces it touches are re-rendered every frame
+    std::function<void(Shader&, GLsizei)> Draw; // Sets 'model' and draws the mesh the given number of instances
+};
+
+// Omnidirectional shadows for many point lights in one fixed size depth texture.
+// Every light gets six square tiles (one per cube face, in GL cube map face order) of a shadow atlas; the shaders
+// pick the face and project into its tile themselves (see PointShadowCalculation() in shaders/shadow_mapping.frag),
+// which gives a cube map array with a resolution per light on plain OpenGL 3.3 and allows hardware depth comparison.
+//
+// Tile sizes follow importance: Allocate() gives a light about as many texels per face as its sphere of influence
+// covers pixels on screen. A light only changes size when the wanted size is clearly past the rounding point
+// (Hysteresis), at most MaxReallocationsPerFrame lights change per frame, most important first, and a light
+// keeps its old tiles when the atlas has no room for the new ones, so shadows don't pop back and forth.
+//
+// Rendering is proportional to what is visible from each face instead of 6x everything:
+//   - casters are culled against the four side planes of every face frustum on the CPU,
+//   - a caster is drawn once, instanced over all the faces it touches; the vertex shader moves every instance
+//     into its tile and clips it to the face with gl_ClipDistance,
+//   - only the faces of lights that moved or got new tiles and the faces a dynamic caster touches (now or last
+//     frame) are cleared and re-rendered.
+class PointShadowAtlas
+{
+public:
+    GLuint FBO;
+    GLuint DepthMap;
+    GLuint AtlasSize;
+    GLuint MaxLights;
+    GLfloat NearPlane;
+    GLfloat Hysteresis;              // Powers of two the wanted size has to move past the rounding point before a light is resized
+    GLuint MaxReallocationsPerFrame; // Lights that may change size in one frame
+    GLboolean InstancedRendering;    // One instanced draw per caster for all faces, otherwise one draw per caster and face
+    // Work done since the last PrintStats()
+    GLuint FaceRenders, DrawCalls, Reallocations;
+
+    // Faces per instanced draw, matches the arrays in point_shadows_depth_instanced.vs
+    static const GLuint MAX_BATCH = 16;
+
+    PointShadowAtlas(GLuint atlasSize = 4096, GLuint maxLights = 8, GLuint minTileSize = 64, GLuint maxTileSize = 1024)
+        : FBO(0), DepthMap(0), AtlasSize(atlasSize), MaxLights(maxLights), NearPlane(0.05f), Hysteresis(0.3f),
+          MaxReallocationsPerFrame(2), InstancedRendering(GL_TRUE), FaceRenders(0), DrawCalls(0), Reallocations(0),
+          frames(0), lights(maxLights), lightCount(0), allocator(atlasSize, minTileSize),
+          instancedShader("shaders/point_shadows_depth_instanced.vs", "shaders/shadow_mapping_depth.frag"),
+          faceShader("shaders/shadow_mapping_depth.vs", "shaders/shadow_mapping_depth.frag")
+    {
+        this->minTileSize = this->allocator.MinTileSize();
+        this->maxTileSize = maxTileSize < atlasSize / 2 ? maxTileSize : atlasSize / 2;
+
+        glGenTextures(1, &this->DepthMap);
+        glBindTexture(GL_TEXTURE_2D, this->DepthMap);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, atlasSize, atlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &this->FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, this->DepthMap, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::POINT_SHADOWS:: Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~PointShadowAtlas()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(1, &this->DepthMap);
+    }
+
+    // Number of lights casting shadows, the lights past count give their tiles back
+    void SetLightCount(GLuint count)
+    {
+        this->lightCount = count < this->MaxLights ? count : this->MaxLights;
+        for (GLuint l = this->lightCount; l < this->MaxLights; l++)
+            this->releaseTiles(this->lights[l]);
+    }
+
+    // A light's shadow covers the sphere of the given radius around it, nothing further away is rendered or shadowed
+    void SetLight(GLuint index, glm::vec3 position, GLfloat radius)
+    {
+        PointShadowLight& light = this->lights[index];
+        if (light.Valid && light.Position == position && light.Radius == radius)
+            return;
+        light.Position = position;
+        light.Radius = radius;
+        light.Valid = GL_FALSE;
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, this->NearPlane, radius);
+        for (GLuint face = 0; face < 6; face++)
+            light.FaceMatrices[face] = projection * glm::lookAt(position, position + faceDirection(face), faceUp(face));
+    }
+
+    // The static casters moved, re-render every light on the next Render()
+    void Invalidate()
+    {
+        for (GLuint i = 0; i < this->lights.size(); i++)
+            this->lights[i].Valid = GL_FALSE;
+    }
+
+    // Re-evaluates the tile size of every light for a camera at viewPos with a vertical field of view of fovY
+    // radians over screenHeight pixels. Call once per frame before Render().
+    void Allocate(const glm::vec3& viewPos, GLfloat fovY, GLuint screenHeight)
+    {
+        // Wanted size as a power of two: the height of the light's sphere of influence on screen
+        std::vector<GLfloat> wanted(this->lightCount);
+        std::vector<GLuint> order(this->lightCount);
+        GLfloat tanHalfFov = std::abs(std::tan(fovY * 0.5f));
+        for (GLuint l = 0; l < this->lightCount; l++)
+        {
+            const PointShadowLight& light = this->lights[l];
+            GLfloat distance = glm::length(light.Position - viewPos);
+            GLfloat pixels = distance <= light.Radius ? (GLfloat)screenHeight : screenHeight * light.Radius / (distance * tanHalfFov);
+            wanted[l] = std::log2(glm::clamp(pixels, (GLfloat)this->minTileSize, (GLfloat)this->maxTileSize));
+            order[l] = l;
+        }
+        // The most important lights get first pick when the atlas is full
+        std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b) { return wanted[a] > wanted[b]; });
+
+        GLuint changes = 0;
+        for (GLuint i = 0; i < order.size(); i++)
+        {
+            PointShadowLight& light = this->lights[order[i]];
+            GLuint size = 1 << (GLuint)std::floor(wanted[order[i]] + 0.5f);
+            if (light.Tiles[0].Node >= 0)
+            {
+                if (std::abs(wanted[order[i]] - std::log2((GLfloat)light.Tiles[0].Size)) <= 0.5f + this->Hysteresis)
+                    continue;
+                if (changes < this->MaxReallocationsPerFrame && this->allocateTiles(light, size))
+                    changes++;
+            }
+            else
+            {
+                // No tiles yet (or no room last time): take the largest size that fits
+                for (; size >= this->minTileSize; size /= 2)
+                    if (this->allocateTiles(light, size))
+                        break;
+            }
+        }
+    }
+
+    // Renders the faces that changed. Leaves FBO bound with the viewport set to the whole atlas.
+    void Render(const std::vector<PointShadowCaster>& casters)
+    {
+        this->frames++;
+        // Faces every caster touches, per light, and the faces that need rendering
+        std::vector<GLuint> faceMasks(this->lightCount * casters.size(), 0);
+        std::vector<GLuint> dirty(this->lightCount, 0);
+        for (GLuint l = 0; l < this->lightCount; l++)
+        {
+            PointShadowLight& light = this->lights[l];
+            if (light.Tiles[0].Node < 0)
+                continue; // No room in the atlas, the light casts no shadows
+            GLuint dynamicMask = 0;
+            for (GLuint c = 0; c < casters.size(); c++)
+            {
+                GLuint mask = touchedFaces(light, casters[c]);
+                faceMasks[l * casters.size() + c] = mask;
+                if (casters[c].Dynamic)
+                    dynamicMask |= mask;
+            }
+            // Faces a dynamic caster left since last frame have to be redrawn as well to erase it
+            dirty[l] = light.Valid ? dynamicMask | light.DynamicMask : (GLuint)ALL_FACES;
+            light.DynamicMask = dynamicMask;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        // Only clear the tiles being redrawn, the rest of the atlas keeps its depth
+        glEnable(GL_SCISSOR_TEST);
+        for (GLuint l = 0; l < this->lightCount; l++)
+            for (GLuint face = 0; face < 6; face++)
+            {
+                if (!(dirty[l] & (1 << face)))
+                    continue;
+                const ShadowAtlasTile& tile = this->lights[l].Tiles[face];
+                glScissor(tile.X, tile.Y, tile.Size, tile.Size);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                this->FaceRenders++;
+            }
+        glDisable(GL_SCISSOR_TEST);
+
+        // Slope scaled bias while rendering, the constant part is added in the shader in world units
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 2.0f);
+        if (this->InstancedRendering)
+            this->renderInstanced(casters, faceMasks, dirty);
+        else
+            this->renderFaces(casters, faceMasks, dirty);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glViewport(0, 0, this->AtlasSize, this->AtlasSize);
+
+        for (GLuint l = 0; l < this->lightCount; l++)
+            this->lights[l].Valid = GL_TRUE;
+    }
+
+    // Binds the atlas to textureUnit and sets the point shadow uniforms of shaders/shadow_mapping.frag
+    void SetUniforms(Shader& shader, GLuint textureUnit)
+    {
+        // Per face: xy = tile offset and z = tile size in texture coordinates, w = tile texel size at unit distance
+        // (0 = the light has no tiles)
+        std::vector<glm::vec4> tiles(this->lightCount * 6, glm::vec4(0.0f));
+        for (GLuint l = 0; l < this->lightCount; l++)
+            for (GLuint face = 0; face < 6; face++)
+            {
+                const ShadowAtlasTile& tile = this->lights[l].Tiles[face];
+                if (tile.Node >= 0)
+                    tiles[l * 6 + face] = glm::vec4(tile.X / (GLfloat)this->AtlasSize, tile.Y / (GLfloat)this->AtlasSize,
+                                                    tile.Size / (GLfloat)this->AtlasSize, 2.0f / tile.Size);
+            }
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D, this->DepthMap);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(shader.Program, "pointShadowMap"), textureUnit);
+        glUniform1f(glGetUniformLocation(shader.Program, "pointShadowNear"), this->NearPlane);
+        if (!tiles.empty())
+            glUniform4fv(glGetUniformLocation(shader.Program, "pointShadowTiles"), tiles.size(), glm::value_ptr(tiles[0]));
+    }
+
+    // Face size of a light's tiles in texels, 0 if it has none
+    GLuint TileSize(GLuint light) const
+    {
+        return this->lights[light].Tiles[0].Node >= 0 ? this->lights[light].Tiles[0].Size : 0;
+    }
+
+    // Prints the average work per frame since the last call and the current tile sizes
+    void PrintStats()
+    {
+        GLfloat frames = this->frames > 0 ? (GLfloat)this->frames : 1.0f;
+        std::cout << "Point shadows (" << (this->InstancedRendering ? "instanced" : "per face") << "): "
+                  << this->FaceRenders / frames << " faces, " << this->DrawCalls / frames << " draw calls per frame, "
+                  << this->Reallocations << " reallocations" << std::endl;
+        std::cout << "  " << this->AtlasSize << "x" << this->AtlasSize << " atlas "
+                  << 100.0 * this->allocator.UsedTexels() / ((GLfloat)this->AtlasSize * this->AtlasSize) << "% used, tiles:";
+        for (GLuint l = 0; l < this->lightCount; l++)
+            std::cout << " " << this->TileSize(l);
+        std::cout << std::endl;
+        this->FaceRenders = this->DrawCalls = this->Reallocations = 0;
+        this->frames = 0;
+    }
+
+    // Video memory used by the atlas in bytes, independent of the number of lights
+    GLsizeiptr MemoryBytes() const
+    {
+        return (GLsizeiptr)this->AtlasSize * this->AtlasSize * 4;
+    }
+
+private:
+    struct PointShadowLight {
+        glm::vec3 Position;
+        GLfloat Radius;
+        GLboolean Valid;    // The tiles hold the static casters for Position/Radius
+        GLuint DynamicMask; // Faces dynamic casters were rendered into last frame
+        glm::mat4 FaceMatrices[6];
+        ShadowAtlasTile Tiles[6];
+        PointShadowLight() : Position(0.0f), Radius(0.0f), Valid(GL_FALSE), DynamicMask(0) { }
+    };
+
+    static const GLuint ALL_FACES = 0x3F;
+
+    GLuint frames;
+    std::vector<PointShadowLight> lights;
+    GLuint lightCount;
+    ShadowAtlasAllocator allocator;
+    GLuint minTileSize, maxTileSize;
+    Shader instancedShader;
+    Shader faceShader;
+
+    static glm::vec3 faceDirection(GLuint face)
+    {
+        glm::vec3 direction(0.0f);
+        direction[face / 2] = face % 2 ? -1.0f : 1.0f;
+        return direction;
+    }
+
+    // Up vectors of the GL cube map faces, so the shaders can use the cube map face/coordinate rules
+    static glm::vec3 faceUp(GLuint face)
+    {
+        if (face == 2)
+            return glm::vec3(0.0f, 0.0f, 1.0f);
+        if (face == 3)
+            return glm::vec3(0.0f, 0.0f, -1.0f);
+        return glm::vec3(0.0f, -1.0f, 0.0f);
+    }
+
+    // Moves a light to six new tiles of the given size. The new tiles are taken before the old ones are given back:
+    // a light that doesn't fit at the new size keeps its old tiles.
+    bool allocateTiles(PointShadowLight& light, GLuint size)
+    {
+        ShadowAtlasTile tiles[6];
+        for (GLuint face = 0; face < 6; face++)
+        {
+            if (!this->allocator.Allocate(size, tiles[face]))
+            {
+                for (GLuint i = 0; i < face; i++)
+                    this->allocator.Free(tiles[i]);
+                return false;
+            }
+        }
+        this->releaseTiles(light);
+        for (GLuint face = 0; face < 6; face++)
+            light.Tiles[face] = tiles[face];
+        light.Valid = GL_FALSE;
+        this->Reallocations++;
+        return true;
+    }
+
+    void releaseTiles(PointShadowLight& light)
+    {
+        for (GLuint face = 0; face < 6; face++)
+            this->allocator.Free(light.Tiles[face]);
+    }
+
+    // Bitmask of the faces of light whose frustum the caster's bounding sphere intersects
+    static GLuint touchedFaces(const PointShadowLight& light, const PointShadowCaster& caster)
+    {
+        glm::vec3 center = caster.Center - light.Position;
+        if (glm::length(center) - caster.Radius > light.Radius)
+            return 0;
+        // A face frustum is bounded by four planes through the light at 45 degrees between its axis and the other two
+        const GLfloat invSqrt2 = 0.70710678f;
+        GLuint mask = 0;
+        for (GLuint face = 0; face < 6; face++)
+        {
+            GLuint axis = face / 2;
+            GLfloat sign = face % 2 ? -1.0f : 1.0f;
+            GLboolean inside = GL_TRUE;
+            for (GLuint other = 0; other < 3 && inside; other++)
+            {
+                if (other == axis)
+                    continue;
+                GLfloat along = sign * center[axis];
+                inside = (along + center[other]) * invSqrt2 >= -caster.Radius && (along - center[other]) * invSqrt2 >= -caster.Radius;
+            }
+            if (inside)
+                mask |= 1 << face;
+        }
+        return mask;
+    }
+
+    // One instanced draw per caster covering every dirty face it touches, of all lights
+    void renderInstanced(const std::vector<PointShadowCaster>& casters, const std::vector<GLuint>& faceMasks, const std::vector<GLuint>& dirty)
+    {
+        glViewport(0, 0, this->AtlasSize, this->AtlasSize);
+        for (GLuint i = 0; i < 4; i++)
+            glEnable(GL_CLIP_DISTANCE0 + i);
+
+        this->instancedShader.Use();
+        GLint matricesLocation = glGetUniformLocation(this->instancedShader.Program, "faceMatrices");
+        GLint tilesLocation = glGetUniformLocation(this->instancedShader.Program, "faceTiles");
+        glm::mat4 matrices[MAX_BATCH];
+        glm::vec4 tiles[MAX_BATCH];
+        for (GLuint c = 0; c < casters.size(); c++)
+        {
+            GLsizei count = 0;
+            for (GLuint l = 0; l < this->lightCount; l++)
+            {
+                GLuint mask = dirty[l] & faceMasks[l * casters.size() + c];
+                for (GLuint face = 0; face < 6; face++)
+                {
+                    if (!(mask & (1 << face)))
+                        continue;
+                    // Tile in normalized device coordinates of the atlas: xy = center, zw = half size
+                    const ShadowAtlasTile& tile = this->lights[l].Tiles[face];
+                    GLfloat halfSize = tile.Size / (GLfloat)this->AtlasSize;
+                    matrices[count] = this->lights[l].FaceMatrices[face];
+                    tiles[count] = glm::vec4(tile.X * 2.0f / this->AtlasSize - 1.0f + halfSize,
+                                             tile.Y * 2.0f / this->AtlasSize - 1.0f + halfSize, halfSize, halfSize);
+                    if (++count == (GLsizei)MAX_BATCH)
+                    {
+                        this->drawBatch(casters[c], matricesLocation, tilesLocation, matrices, tiles, count);
+                        count = 0;
+                    }
+                }
+            }
+            if (count > 0)
+                this->drawBatch(casters[c], matricesLocation, tilesLocation, matrices, tiles, count);
+        }
+
+        for (GLuint i = 0; i < 4; i++)
+            glDisable(GL_CLIP_DISTANCE0 + i);
+    }
+
+    void drawBatch(const PointShadowCaster& caster, GLint matricesLocation, GLint tilesLocation,
+                   const glm::mat4* matrices, const glm::vec4* tiles, GLsizei count)
+    {
+        glUniformMatrix4fv(matricesLocation, count, GL_FALSE, glm::value_ptr(matrices[0]));
+        glUniform4fv(tilesLocation, count, glm::value_ptr(tiles[0]));
+        caster.Draw(this->instancedShader, count);
+        this->DrawCalls++;
+    }
+
+    // Reference path: every dirty face on its own with the viewport on its tile, drawing only the casters touching it
+    void renderFaces(const std::vector<PointShadowCaster>& casters, const std::vector<GLuint>& faceMasks, const std::vector<GLuint>& dirty)
+    {
+        this->faceShader.Use();
+        GLint lightSpaceLocation = glGetUniformLocation(this->faceShader.Program, "lightSpaceMatrix");
+        for (GLuint l = 0; l < this->lightCount; l++)
+        {
+            for (GLuint face = 0; face < 6; face++)
+            {
+                if (!(dirty[l] & (1 << face)))
+                    continue;
+                const ShadowAtlasTile& tile = this->lights[l].Tiles[face];
+                glViewport(tile.X, tile.Y, tile.Size, tile.Size);
+                glUniformMatrix4fv(lightSpaceLocation, 1, GL_FALSE, glm::value_ptr(this->lights[l].FaceMatrices[face]));
+                for (GLuint c = 0; c < casters.size(); c++)
+                {
+                    if (!(faceMasks[l * casters.size() + c] & (1 << face)))
+                        continue;
+                    casters[c].Draw(this->faceShader, 1);
+                    this->DrawCalls++;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,400 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Describes a pooled render target. The size is relative to the pool resolution (1.0 full, 0.5 half, ...)
+// so every target follows the window when the pool is resized.
+struct RenderTargetDesc {
+    GLint InternalFormat;
+    GLfloat Scale;
+    GLint Filter;
+
+    RenderTargetDesc(GLint internalFormat = GL_RGBA8, GLfloat scale = 1.0f, GLint filter = GL_LINEAR)
+        : InternalFormat(internalFormat), Scale(scale), Filter(filter) { }
+
+    bool operator==(const RenderTargetDesc& other) const
+    {
+        return this->InternalFormat == other.InternalFormat && this->Scale == other.Scale && this->Filter == other.Filter;
+    }
+};
+
+// A texture owned by the pool
+struct RenderTarget {
+    RenderTargetDesc Desc;
+    GLuint Texture;
+    GLsizei Width, Height;
+    GLboolean InUse;
+};
+
+// Pool of 2D render target textures. Acquire() hands out a free texture matching the description and only
+// allocates when none is available, Release() returns it. Passes that acquire their targets right before
+// they write them and release them after their last reader therefore share the same memory whenever their
+// lifetimes don't overlap, so the number of live targets follows the widest point of the frame instead of
+// the number of passes. Long lived targets (e.g. the scene color) can simply be acquired once and never released.
+class RenderTargetPool
+{
+public:
+    GLuint Width, Height;
+
+    RenderTargetPool(GLuint width, GLuint height) : Width(width), Height(height) { }
+
+    ~RenderTargetPool()
+    {
+        for (GLuint i = 0; i < this->targets.size(); i++)
+            glDeleteTextures(1, &this->targets[i].Texture);
+    }
+
+    // Returns a texture matching desc, allocating a new one only if every matching texture is in use
+    GLuint Acquire(const RenderTargetDesc& desc)
+    {
+        for (GLuint i = 0; i < this->targets.size(); i++)
+        {
+            if (!this->targets[i].InUse && this->targets[i].Desc == desc)
+            {
+                this->targets[i].InUse = GL_TRUE;
+                return this->targets[i].Texture;
+            }
+        }
+        RenderTarget target;
+        target.Desc = desc;
+        target.InUse = GL_TRUE;
+        glGenTextures(1, &target.Texture);
+        this->allocate(target);
+        this->targets.push_back(target);
+        return target.Texture;
+    }
+
+    // Hands a texture back to the pool so later passes can reuse its memory
+    void Release(GLuint texture)
+    {
+        RenderTarget* target = this->find(texture);
+        if (target)
+            target->InUse = GL_FALSE;
+        else
+            std::cout << "ERROR::RENDER_TARGET_POOL:: Released texture " << texture << " is not part of the pool" << std::endl;
+    }
+
+    // Reallocates every target for the new resolution. Texture names stay the same, so framebuffers the
+    // textures are attached to remain valid.
+    void Resize(GLuint width, GLuint height)
+    {
+        if (width == this->Width && height == this->Height)
+            return;
+        this->Width = width;
+        this->Height = height;
+        for (GLuint i = 0; i < this->targets.size(); i++)
+            this->allocate(this->targets[i]);
+    }
+
+    // Frees the targets nobody holds, e.g. after a chain lost some of its passes
+    void Trim()
+    {
+        for (GLint i = (GLint)this->targets.size() - 1; i >= 0; i--)
+        {
+            if (!this->targets[i].InUse)
+            {
+                glDeleteTextures(1, &this->targets[i].Texture);
+                this->targets.erase(this->targets.begin() + i);
+            }
+        }
+    }
+
+    // Size of a target with the given description at the current pool resolution
+    void TargetSize(const RenderTargetDesc& desc, GLsizei& width, GLsizei& height) const
+    {
+        width = std::max((GLsizei)(this->Width * desc.Scale), 1);
+        height = std::max((GLsizei)(this->Height * desc.Scale), 1);
+    }
+
+    // Size of a pooled texture, returns false if the texture isn't owned by the pool
+    bool TextureSize(GLuint texture, GLsizei& width, GLsizei& height)
+    {
+        RenderTarget* target = this->find(texture);
+        if (!target)
+            return false;
+        width = target->Width;
+        height = target->Height;
+        return true;
+    }
+
+    GLuint TargetCount() const { return this->targets.size(); }
+
+    // Video memory used by all pooled targets in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        GLsizeiptr bytes = 0;
+        for (GLuint i = 0; i < this->targets.size(); i++)
+            bytes += (GLsizeiptr)this->targets[i].Width * this->targets[i].Height * bytesPerPixel(this->targets[i].Desc.InternalFormat);
+        return bytes;
+    }
+
+    void PrintStats() const
+    {
+        std::cout << "Render targets: " << this->targets.size() << " textures, "
+                  << this->MemoryBytes() / (1024.0f * 1024.0f) << " MB" << std::endl;
+        for (GLuint i = 0; i < this->targets.size(); i++)
+        {
+            const RenderTarget& target = this->targets[i];
+            std::cout << "  #" << target.Texture << " " << target.Width << "x" << target.Height
+                      << " format 0x" << std::hex << target.Desc.InternalFormat << std::dec
+                      << (target.InUse ? " (in use)" : "") << std::endl;
+        }
+    }
+
+private:
+    std::vector<RenderTarget> targets;
+
+    RenderTarget* find(GLuint texture)
+    {
+        for (GLuint i = 0; i < this->targets.size(); i++)
+            if (this->targets[i].Texture == texture)
+                return &this->targets[i];
+        return nullptr;
+    }
+
+    void allocate(RenderTarget& target)
+    {
+        this->TargetSize(target.Desc, target.Width, target.Height);
+        GLenum format, type;
+        pixelFormat(target.Desc.InternalFormat, format, type);
+        glBindTexture(GL_TEXTURE_2D, target.Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, target.Desc.InternalFormat, target.Width, target.Height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, target.Desc.Filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, target.Desc.Filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // Post-process filters must not sample the opposite border
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Any matching client format/type is fine as no data is uploaded, it only has to be legal for the internal format
+    static void pixelFormat(GLint internalFormat, GLenum& format, GLenum& type)
+    {
+        switch (internalFormat)
+        {
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+            format = GL_DEPTH_COMPONENT; type = GL_FLOAT; break;
+        case GL_DEPTH24_STENCIL8:
+            format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; break;
+        case GL_R8: case GL_R16F: case GL_R32F:
+            format = GL_RED; type = GL_FLOAT; break;
+        case GL_RG8: case GL_RG16F: case GL_RG32F:
+            format = GL_RG; type = GL_FLOAT; break;
+        case GL_RGB8: case GL_SRGB8: case GL_RGB16F: case GL_RGB32F: case GL_R11F_G11F_B10F:
+            format = GL_RGB; type = GL_FLOAT; break;
+        default:
+            format = GL_RGBA; type = GL_FLOAT; break;
+        }
+    }
+
+    static GLuint bytesPerPixel(GLint internalFormat)
+    {
+        switch (internalFormat)
+        {
+        case GL_R8: return 1;
+        case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGB8: case GL_SRGB8: return 3; // Drivers usually pad these to 4 bytes
+        case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: return 8;
+        case GL_RGB32F: return 12;
+        case GL_RGBA32F: return 16;
+        default: return 4; // RGBA8, SRGB8_ALPHA8, RG16F, R32F, R11F_G11F_B10F, RGB10_A2, depth 24/32
+        }
+    }
+};
+
+// Per pass information handed to a pass callback
+struct PostProcessContext {
+    std::vector<GLuint> Inputs; // Textures of the declared inputs, in declaration order
+    GLuint Output;              // Texture the pass renders to, 0 when it renders to the default framebuffer
+    GLsizei Width, Height;      // Size of the output, the viewport is already set to it
+};
+
+// A chain of full-screen passes. Every pass declares the named resources it reads and the one it writes;
+// the chain acquires each output from the RenderTargetPool right before the pass runs and releases it after
+// its last reader, so intermediate targets of different passes alias the same memory.
+//
+// Resources come either from the pool (output with a RenderTargetDesc) or are imported textures owned by
+// someone else (the scene color, effects with their own targets like BloomRenderer). For a pooled output the
+// chain binds its framebuffer with the target attached; a pass writing an imported resource binds its own.
+// A pass with an empty output name renders to the default framebuffer.
+// Disabled passes are skipped and their output forwards to their first input, so effects can be toggled
+// without rewiring the passes that follow.
+class PostProcessChain
+{
+public:
+    typedef std::function<void(const PostProcessContext&)> PassFunction;
+
+    PostProcessChain(RenderTargetPool& pool) : pool(pool), FBO(0)
+    {
+        glGenFramebuffers(1, &this->FBO);
+    }
+
+    ~PostProcessChain()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+    }
+
+    // Registers (or updates after a resize) a texture owned outside of the chain
+    void Import(const std::string& name, GLuint texture, GLsizei width, GLsizei height)
+    {
+        ImportedResource& resource = this->imported[name];
+        resource.Texture = texture;
+        resource.Width = width;
+        resource.Height = height;
+    }
+
+    // Adds a pass writing a pooled target (or the default framebuffer when output is empty)
+    void AddPass(const std::string& name, const std::vector<std::string>& inputs, const std::string& output,
+                 const RenderTargetDesc& outputDesc, PassFunction execute)
+    {
+        Pass pass;
+        pass.Name = name;
+        pass.Inputs = inputs;
+        pass.Output = output;
+        pass.OutputDesc = outputDesc;
+        pass.Execute = execute;
+        pass.Enabled = GL_TRUE;
+        this->passes.push_back(pass);
+    }
+
+    // Adds a pass writing an imported resource or the default framebuffer
+    void AddPass(const std::string& name, const std::vector<std::string>& inputs, const std::string& output, PassFunction execute)
+    {
+        this->AddPass(name, inputs, output, RenderTargetDesc(), execute);
+    }
+
+    void SetEnabled(const std::string& name, GLboolean enabled)
+    {
+        for (GLuint i = 0; i < this->passes.size(); i++)
+            if (this->passes[i].Name == name)
+                this->passes[i].Enabled = enabled;
+    }
+
+    // Runs all enabled passes in order. Leaves the default framebuffer bound.
+    void Execute()
+    {
+        // Resolve the actual resource behind every name (disabled passes forward their first input)
+        // and find the last pass reading each one
+        std::map<std::string, std::string> aliases;
+        std::map<std::string, GLint> lastUse;
+        for (GLuint i = 0; i < this->passes.size(); i++)
+        {
+            const Pass& pass = this->passes[i];
+            if (!pass.Enabled)
+            {
+                if (!pass.Output.empty())
+                    aliases[pass.Output] = pass.Inputs.empty() ? std::string() : resolve(aliases, pass.Inputs[0]);
+                continue;
+            }
+            aliases.erase(pass.Output);
+            for (GLuint j = 0; j < pass.Inputs.size(); j++)
+                lastUse[resolve(aliases, pass.Inputs[j])] = i;
+        }
+
+        // Walk the passes again with the same aliasing, acquiring and releasing pooled targets on the fly
+        aliases.clear();
+        std::map<std::string, GLuint> live;
+        for (GLuint i = 0; i < this->passes.size(); i++)
+        {
+            const Pass& pass = this->passes[i];
+            if (!pass.Enabled)
+            {
+                if (!pass.Output.empty())
+                    aliases[pass.Output] = pass.Inputs.empty() ? std::string() : resolve(aliases, pass.Inputs[0]);
+                continue;
+            }
+            aliases.erase(pass.Output);
+
+            PostProcessContext context;
+            for (GLuint j = 0; j < pass.Inputs.size(); j++)
+                context.Inputs.push_back(this->texture(live, resolve(aliases, pass.Inputs[j])));
+
+            if (pass.Output.empty())
+            {
+                context.Output = 0;
+                context.Width = this->pool.Width;
+                context.Height = this->pool.Height;
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, context.Width, context.Height);
+            }
+            else if (this->imported.count(pass.Output))
+            {
+                const ImportedResource& resource = this->imported[pass.Output];
+                context.Output = resource.Texture;
+                context.Width = resource.Width;
+                context.Height = resource.Height;
+            }
+            else
+            {
+                context.Output = this->pool.Acquire(pass.OutputDesc);
+                live[pass.Output] = context.Output;
+                this->pool.TargetSize(pass.OutputDesc, context.Width, context.Height);
+                glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, context.Output, 0);
+                glViewport(0, 0, context.Width, context.Height);
+            }
+
+            pass.Execute(context);
+
+            // Targets past their last reader go back to the pool for the following passes
+            for (std::map<std::string, GLuint>::iterator it = live.begin(); it != live.end();)
+            {
+                std::map<std::string, GLint>::iterator use = lastUse.find(it->first);
+                if (use == lastUse.end() || use->second <= (GLint)i)
+                {
+                    this->pool.Release(it->second);
+                    live.erase(it++);
+                }
+                else
+                    ++it;
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+private:
+    struct Pass {
+        std::string Name;
+        std::vector<std::string> Inputs;
+        std::string Output;
+        RenderTargetDesc OutputDesc;
+        PassFunction Execute;
+        GLboolean Enabled;
+    };
+    struct ImportedResource {
+        GLuint Texture;
+        GLsizei Width, Height;
+    };
+
+    RenderTargetPool& pool;
+    GLuint FBO;
+    std::vector<Pass> passes;
+    std::map<std::string, ImportedResource> imported;
+
+    static std::string resolve(const std::map<std::string, std::string>& aliases, const std::string& name)
+    {
+        std::map<std::string, std::string>::const_iterator it = aliases.find(name);
+        return it == aliases.end() ? name : it->second;
+    }
+
+    GLuint texture(const std::map<std::string, GLuint>& live, const std::string& name)
+    {
+        std::map<std::string, GLuint>::const_iterator it = live.find(name);
+        if (it != live.end())
+            return it->second;
+        if (this->imported.count(name))
+            return this->imported[name].Texture;
+        std::cout << "ERROR::POST_PROCESS:: Pass input '" << name << "' was never written" << std::endl;
+        return 0;
+    }
+};
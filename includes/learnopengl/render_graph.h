@@ -0,0 +1,327 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// A framebuffer the render graph can render into
+struct RenderGraphTarget {
+    GLuint FBO;
+    GLsizei Width, Height;
+    GLbitfield ClearMask;   // Buffers cleared once per frame, before the first pass writing the target
+    glm::vec4 ClearColor;
+};
+
+// Average time a pass took, see RenderGraph::TakeTimings()
+struct RenderGraphTiming {
+    std::string Pass;
+    double CpuMs, GpuMs;
+};
+
+// Frame graph for a single frame of rendering.
+// Targets (framebuffers) are registered once, passes are declared every frame with the resources they read
+// and the target they write, in any order. Execute() then
+//   - culls every pass that doesn't contribute to the requested output (e.g. a shadow pass nobody samples),
+//   - orders the remaining passes so every resource is written before it is read (declaration order breaks ties),
+//   - binds a target and sets its viewport only when it differs from the previous pass and clears it only
+//     before its first writer,
+//   - measures every pass on the CPU and, through GL_TIME_ELAPSED queries read back a few frames later so
+//     the CPU never waits for the GPU, on the GPU.
+// A pass gets its target bound with the viewport set and is expected to leave it that way when it binds
+// framebuffers of its own (like the bloom or OIT helpers do).
+class RenderGraph
+{
+public:
+    typedef std::function<void()> PassFunction;
+
+    RenderGraph() : frameIndex(0) { }
+
+    ~RenderGraph()
+    {
+        for (std::map<std::string, PassTimer>::iterator it = this->timers.begin(); it != this->timers.end(); ++it)
+            glDeleteQueries(QUERY_LATENCY, it->second.Queries);
+    }
+
+    // Registers a target, or updates it (e.g. after a resize) if the name is already known
+    void AddTarget(const std::string& name, GLuint fbo, GLsizei width, GLsizei height,
+                   GLbitfield clearMask = 0, glm::vec4 clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))
+    {
+        RenderGraphTarget& target = this->targets[name];
+        target.FBO = fbo;
+        target.Width = width;
+        target.Height = height;
+        target.ClearMask = clearMask;
+        target.ClearColor = clearColor;
+    }
+
+    // Declares a pass for the current frame
+    void AddPass(const std::string& name, const std::vector<std::string>& reads, const std::string& target, PassFunction execute)
+    {
+        if (!this->targets.count(target))
+            std::cout << "ERROR::RENDER_GRAPH:: Pass '" << name << "' writes unknown target '" << target << "'" << std::endl;
+        Pass pass;
+        pass.Name = name;
+        pass.Reads = reads;
+        pass.Target = target;
+        pass.Execute = execute;
+        this->passes.push_back(pass);
+    }
+
+    // Culls, orders and runs the passes declared this frame that contribute to output, then forgets them
+    void Execute(const std::string& output)
+    {
+        std::vector<GLuint> order = this->compile(output);
+        this->lastOrder.clear();
+        this->lastCulled.clear();
+        for (GLuint i = 0; i < this->passes.size(); i++)
+            if (std::find(order.begin(), order.end(), i) == order.end())
+                this->lastCulled.push_back(this->passes[i].Name);
+
+        std::map<std::string, bool> cleared;
+        GLint boundFBO = -1;
+        GLsizei viewportWidth = 0, viewportHeight = 0;
+        GLuint slot = this->frameIndex % QUERY_LATENCY;
+        for (GLuint i = 0; i < order.size(); i++)
+        {
+            const Pass& pass = this->passes[order[i]];
+            const RenderGraphTarget& target = this->targets[pass.Target];
+            this->lastOrder.push_back(pass.Name);
+
+            PassTimer& timer = this->timer(pass.Name);
+            timer.collect(slot);
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, timer.Queries[slot]);
+
+            if (boundFBO != (GLint)target.FBO)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+                boundFBO = target.FBO;
+            }
+            if (viewportWidth != target.Width || viewportHeight != target.Height)
+            {
+                glViewport(0, 0, target.Width, target.Height);
+                viewportWidth = target.Width;
+                viewportHeight = target.Height;
+            }
+            if (target.ClearMask && !cleared[pass.Target])
+            {
+                glClearColor(target.ClearColor.r, target.ClearColor.g, target.ClearColor.b, target.ClearColor.a);
+                glClear(target.ClearMask);
+                cleared[pass.Target] = true;
+            }
+
+            pass.Execute();
+
+            glEndQuery(GL_TIME_ELAPSED);
+            timer.Issued[slot] = GL_TRUE;
+            timer.CpuTotal += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            timer.CpuSamples++;
+        }
+        this->passes.clear();
+        this->frameIndex++;
+    }
+
+    // Average CPU/GPU time in ms of every pass executed in the last frame, since the last call. Starts new averages.
+    std::vector<RenderGraphTiming> TakeTimings()
+    {
+        std::vector<RenderGraphTiming> timings;
+        for (GLuint i = 0; i < this->lastOrder.size(); i++)
+        {
+            PassTimer& timer = this->timer(this->lastOrder[i]);
+            RenderGraphTiming timing;
+            timing.Pass = this->lastOrder[i];
+            timing.CpuMs = timer.CpuSamples ? timer.CpuTotal / timer.CpuSamples : 0.0;
+            timing.GpuMs = timer.GpuSamples ? timer.GpuTotal / timer.GpuSamples : 0.0;
+            timings.push_back(timing);
+            timer.CpuTotal = timer.GpuTotal = 0.0;
+            timer.CpuSamples = timer.GpuSamples = 0;
+        }
+        return timings;
+    }
+
+    // Prints the average CPU/GPU time of every pass since the last call and the passes culled in the last frame
+    void PrintTimings()
+    {
+        std::vector<RenderGraphTiming> timings = this->TakeTimings();
+        double cpuFrame = 0.0, gpuFrame = 0.0;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Render graph (" << timings.size() << " passes)        CPU ms     GPU ms" << std::endl;
+        for (GLuint i = 0; i < timings.size(); i++)
+        {
+            cpuFrame += timings[i].CpuMs;
+            gpuFrame += timings[i].GpuMs;
+            std::cout << "  " << std::left << std::setw(24) << timings[i].Pass << std::right
+                      << std::setw(10) << timings[i].CpuMs << std::setw(11) << timings[i].GpuMs << std::endl;
+        }
+        std::cout << "  " << std::left << std::setw(24) << "total" << std::right
+                  << std::setw(10) << cpuFrame << std::setw(11) << gpuFrame << std::endl;
+        for (GLuint i = 0; i < this->lastCulled.size(); i++)
+            std::cout << "  culled: " << this->lastCulled[i] << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+
+    // Names of the passes executed in the last frame, in execution order
+    const std::vector<std::string>& ExecutedPasses() const { return this->lastOrder; }
+
+private:
+    // Frames a query result is allowed to be in flight before it is read back
+    static const GLuint QUERY_LATENCY = 3;
+
+    struct Pass {
+        std::string Name;
+        std::vector<std::string> Reads;
+        std::string Target;
+        PassFunction Execute;
+    };
+
+    struct PassTimer {
+        GLuint Queries[QUERY_LATENCY];
+        GLboolean Issued[QUERY_LATENCY];
+        double CpuTotal, GpuTotal;
+        GLuint CpuSamples, GpuSamples;
+
+        // Adds the result of the query issued QUERY_LATENCY frames ago in this slot, if the GPU is done with it
+        void collect(GLuint slot)
+        {
+            if (!this->Issued[slot])
+                return;
+            GLint available = 0;
+            glGetQueryObjectiv(this->Queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return; // Dropping the sample is better than stalling the pipeline
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(this->Queries[slot], GL_QUERY_RESULT, &nanoseconds);
+            this->GpuTotal += nanoseconds / 1000000.0;
+            this->GpuSamples++;
+            this->Issued[slot] = GL_FALSE;
+        }
+    };
+
+    std::map<std::string, RenderGraphTarget> targets;
+    std::vector<Pass> passes;
+    std::map<std::string, PassTimer> timers;
+    std::vector<std::string> lastOrder;
+    std::vector<std::string> lastCulled;
+    GLuint frameIndex;
+
+    PassTimer& timer(const std::string& name)
+    {
+        std::map<std::string, PassTimer>::iterator it = this->timers.find(name);
+        if (it != this->timers.end())
+            return it->second;
+        PassTimer& timer = this->timers[name];
+        glGenQueries(QUERY_LATENCY, timer.Queries);
+        for (GLuint i = 0; i < QUERY_LATENCY; i++)
+            timer.Issued[i] = GL_FALSE;
+        timer.CpuTotal = timer.GpuTotal = 0.0;
+        timer.CpuSamples = timer.GpuSamples = 0;
+        return timer;
+    }
+
+    // Returns the indices of the passes to run, in execution order
+    std::vector<GLuint> compile(const std::string& output)
+    {
+        GLuint count = this->passes.size();
+        // Edges: a pass depends on the last earlier writer of everything it reads (or the first later one if
+        // the writer was declared after it), and on the previous writer and readers of the target it writes
+        std::vector<std::vector<GLuint> > dependencies(count);
+        for (GLuint i = 0; i < count; i++)
+        {
+            const Pass& pass = this->passes[i];
+            for (GLuint r = 0; r < pass.Reads.size(); r++)
+            {
+                GLint writer = this->lastWriter(pass.Reads[r], i);
+                if (writer < 0)
+                    writer = this->firstWriterAfter(pass.Reads[r], i);
+                if (writer >= 0 && writer != (GLint)i)
+                    dependencies[i].push_back(writer);
+                else if (writer < 0 && !this->targets.count(pass.Reads[r]))
+                    std::cout << "ERROR::RENDER_GRAPH:: Pass '" << pass.Name << "' reads '" << pass.Reads[r] << "' which nothing writes" << std::endl;
+            }
+            for (GLuint j = 0; j < i; j++)
+            {
+                const Pass& earlier = this->passes[j];
+                // Readers only have to finish first if they saw an earlier version of the target, not this pass' output
+                bool reads = std::find(earlier.Reads.begin(), earlier.Reads.end(), pass.Target) != earlier.Reads.end()
+                             && this->lastWriter(pass.Target, j) >= 0;
+                if (earlier.Target == pass.Target || reads)
+                    dependencies[i].push_back(j);
+            }
+        }
+
+        // Cull: keep only the passes the output (transitively) depends on
+        std::vector<bool> live(count, false);
+        std::vector<GLuint> stack;
+        for (GLuint i = 0; i < count; i++)
+            if (this->passes[i].Target == output)
+                stack.push_back(i);
+        while (!stack.empty())
+        {
+            GLuint i = stack.back();
+            stack.pop_back();
+            if (live[i])
+                continue;
+            live[i] = true;
+            for (GLuint d = 0; d < dependencies[i].size(); d++)
+                stack.push_back(dependencies[i][d]);
+        }
+
+        // Order: repeatedly run the earliest declared live pass whose dependencies have all run
+        std::vector<GLuint> order;
+        std::vector<bool> done(count, false);
+        GLuint liveCount = std::count(live.begin(), live.end(), true);
+        while (order.size() < liveCount)
+        {
+            GLint next = -1;
+            for (GLuint i = 0; i < count && next < 0; i++)
+            {
+                if (!live[i] || done[i])
+                    continue;
+                bool ready = true;
+                for (GLuint d = 0; d < dependencies[i].size(); d++)
+                    ready = ready && (done[dependencies[i][d]] || !live[dependencies[i][d]]);
+                if (ready)
+                    next = i;
+            }
+            if (next < 0)
+            {
+                std::cout << "ERROR::RENDER_GRAPH:: Dependency cycle, falling back to declaration order" << std::endl;
+                order.clear();
+                for (GLuint i = 0; i < count; i++)
+                    if (live[i])
+                        order.push_back(i);
+                break;
+            }
+            done[next] = true;
+            order.push_back(next);
+        }
+        return order;
+    }
+
+    GLint lastWriter(const std::string& resource, GLuint before) const
+    {
+        for (GLint i = (GLint)before - 1; i >= 0; i--)
+            if (this->passes[i].Target == resource)
+                return i;
+        return -1;
+    }
+
+    GLint firstWriterAfter(const std::string& resource, GLuint after) const
+    {
+        for (GLuint i = after + 1; i < this->passes.size(); i++)
+            if (this->passes[i].Target == resource)
+                return i;
+        return -1;
+    }
+};
@@ -4,10 +4,10 @@
 #include <GL/glew.h>
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 
+#include <learnopengl/mapped_file.h>
+
 class Shader
 {
 public:
@@ -15,63 +15,42 @@ public:
     // Constructor generates the shader on the fly
     Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* geometryPath = nullptr)
     {
-        // 1. Retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        try
-        {
-            // Open files
-            std::ifstream vShaderFile(vertexPath);
-            std::ifstream fShaderFile(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // Convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            // If geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                std::ifstream gShaderFile(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::exception e)
-        {
+        // 1. Map the vertex/fragment source code from filePath, compiled straight from the mappings
+        MappedFile vShaderFile(vertexPath);
+        MappedFile fShaderFile(fragmentPath);
+        MappedFile gShaderFile;
+        // If geometry shader path is present, also load a geometry shader
+        if(geometryPath != nullptr)
+            gShaderFile.Open(geometryPath);
+        if (!vShaderFile.Data || !fShaderFile.Data || (geometryPath != nullptr && !gShaderFile.Data))
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        }
-        const GLchar* vShaderCode = vertexCode.c_str();
-        const GLchar * fShaderCode = fragmentCode.c_str();
+        // A missing file compiles as an empty source, which fails with the compile log
+        const GLchar* vShaderCode = vShaderFile.Data ? (const GLchar*)vShaderFile.Data : "";
+        const GLchar * fShaderCode = fShaderFile.Data ? (const GLchar*)fShaderFile.Data : "";
+        GLint vShaderLength = vShaderFile.Size, fShaderLength = fShaderFile.Size;
         // 2. Compile shaders
         GLuint vertex, fragment;
         GLint success;
         GLchar infoLog[512];
         // Vertex Shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
         glCompileShader(vertex);
         checkCompileErrors(vertex, "VERTEX");
 
         // Fragment Shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // If geometry shader is given, compile geometry shader
         GLuint geometry;
         if(geometryPath != nullptr)
         {
-            const GLchar * gShaderCode = geometryCode.c_str();
+            const GLchar * gShaderCode = gShaderFile.Data ? (const GLchar*)gShaderFile.Data : "";
+            GLint gShaderLength = gShaderFile.Size;
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glShaderSource(geometry, 1, &gShaderCode, &gShaderLength);
             glCompileShader(geometry);
             checkCompileErrors(geometry, "GEOMETRY");
         }
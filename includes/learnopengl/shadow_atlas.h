@@ -0,0 +1,149 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// A square tile of a shadow atlas, in texels
+struct ShadowAtlasTile {
+    GLint X, Y;
+    GLint Size;
+    GLint Node; // Quadtree node of the tile, -1 if the tile isn't allocated
+    ShadowAtlasTile() : X(0), Y(0), Size(0), Node(-1) { }
+};
+
+// Quadtree allocator for square power of two tiles of one big shadow map.
+// Level 0 is the whole atlas, every level below splits a node into four quadrants, down to minTileSize.
+// Tiles are carved out of the smallest free node that fits (best fit), so large free areas stay in one piece,
+// and a freed tile merges back with its siblings once all four are free.
+// Allocation is purely CPU side bookkeeping; which texels a tile covers never changes while it is allocated.
+class ShadowAtlasAllocator
+{
+public:
+    ShadowAtlasAllocator(GLuint atlasSize, GLuint minTileSize)
+        : atlasSize(atlasSize), levelCount(1)
+    {
+        while ((atlasSize >> this->levelCount) >= minTileSize && this->levelCount < 12)
+            this->levelCount++;
+        GLuint nodeCount = 0;
+        for (GLuint level = 0; level < this->levelCount; level++)
+            nodeCount += 1 << (2 * level);
+        this->nodes.assign(nodeCount, FREE);
+    }
+
+    GLuint AtlasSize() const { return this->atlasSize; }
+    GLuint MinTileSize() const { return this->atlasSize >> (this->levelCount - 1); }
+    GLuint MaxTileSize() const { return this->atlasSize; }
+
+    // Allocates a tile of size texels (rounded up to a power of two), returns false when the atlas has no room for it
+    bool Allocate(GLuint size, ShadowAtlasTile& tile)
+    {
+        GLuint level = this->levelForSize(size);
+        GLint node = -1;
+        GLint nodeLevel = level;
+        for (; nodeLevel >= 0 && node < 0; nodeLevel--)
+            node = this->findFree(0, 0, nodeLevel);
+        if (node < 0)
+            return false;
+        // Split the free node down to the requested size, always continuing in the first quadrant
+        for (nodeLevel++; nodeLevel < (GLint)level; nodeLevel++)
+        {
+            this->nodes[node] = SPLIT;
+            for (GLint i = 1; i <= 4; i++)
+                this->nodes[node * 4 + i] = FREE;
+            node = node * 4 + 1;
+        }
+        this->nodes[node] = USED;
+        tile.Node = node;
+        tile.Size = this->atlasSize >> level;
+        glm::ivec2 origin = this->nodeOrigin(node, level);
+        tile.X = origin.x;
+        tile.Y = origin.y;
+        return true;
+    }
+
+    void Free(ShadowAtlasTile& tile)
+    {
+        if (tile.Node < 0)
+            return;
+        GLint node = tile.Node;
+        tile.Node = -1;
+        this->nodes[node] = FREE;
+        // Merge the parent back once all four quadrants are free
+        while (node > 0)
+        {
+            GLint parent = (node - 1) / 4;
+            for (GLint i = 1; i <= 4; i++)
+                if (this->nodes[parent * 4 + i] != FREE)
+                    return;
+            this->nodes[parent] = FREE;
+            node = parent;
+        }
+    }
+
+    // Texels currently handed out
+    GLuint64 UsedTexels() const
+    {
+        GLuint64 texels = 0;
+        GLuint first = 0;
+        for (GLuint level = 0; level < this->levelCount; level++)
+        {
+            GLuint count = 1 << (2 * level);
+            GLuint64 tileTexels = (GLuint64)(this->atlasSize >> level) * (this->atlasSize >> level);
+            for (GLuint i = first; i < first + count; i++)
+                if (this->nodes[i] == USED)
+                    texels += tileTexels;
+            first += count;
+        }
+        return texels;
+    }
+
+private:
+    enum NodeState { FREE, USED, SPLIT };
+
+    GLuint atlasSize;
+    GLuint levelCount;
+    std::vector<GLubyte> nodes; // Complete quadtree, children of node n are 4n + 1 ... 4n + 4
+
+    GLuint levelForSize(GLuint size) const
+    {
+        GLuint level = 0;
+        while (level + 1 < this->levelCount && (this->atlasSize >> (level + 1)) >= size)
+            level++;
+        return level;
+    }
+
+    // Depth first search for a free node at exactly level, only descending into split nodes
+    GLint findFree(GLint node, GLint nodeLevel, GLint level) const
+    {
+        GLubyte state = this->nodes[node];
+        if (nodeLevel == level)
+            return state == FREE ? node : -1;
+        if (state != SPLIT)
+            return -1;
+        for (GLint i = 1; i <= 4; i++)
+        {
+            GLint found = this->findFree(node * 4 + i, nodeLevel + 1, level);
+            if (found >= 0)
+                return found;
+        }
+        return -1;
+    }
+
+    glm::ivec2 nodeOrigin(GLint node, GLuint level) const
+    {
+        // Walk back up, every step adds the quadrant offset at that level
+        glm::ivec2 origin(0);
+        for (GLuint l = level; l > 0; l--)
+        {
+            GLint quadrant = (node - 1) % 4;
+            GLint size = this->atlasSize >> l;
+            origin += glm::ivec2(quadrant % 2, quadrant / 2) * size;
+            node = (node - 1) / 4;
+        }
+        return origin;
+    }
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <string>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Keeps the depth of the static shadow casters around so a shadow map only pays for what changed.
+// Next to the shadow map, a depth array texture, it owns a second array of the same shape that only holds the
+// static casters. Every frame, per layer (cascade) of the shadow map:
+//   - the static casters are re-rendered into the static layer only if the light's matrix for that layer
+//     changed or the static geometry was invalidated,
+//   - the dynamic casters' bounding spheres are tested against the layer's light frustum, they are only drawn
+//     into the layers they touch,
+//   - the shadow map layer is restored from the static layer with a depth blit when the static layer changed,
+//     when dynamic casters are drawn into it or when they were last frame and have left it since,
+//   - a layer that has neither new static content nor dynamic casters, now or last frame, isn't touched at all.
+// The light itself can be refreshed at a lower rate: BeginFrame() only returns true every UpdateInterval
+// frames, the caller keeps the light's shadow matrices as they are on the other frames so the cache stays valid.
+class ShadowCache
+{
+public:
+    GLuint StaticTexture;
+    GLuint UpdateInterval; // Frames between two updates of the light's shadow, 1 = every frame
+    GLuint UpdateOffset;   // Frame the updates are aligned to, stagger it between lights so they don't update together
+    // Work done since the last PrintStats(), in layers
+    GLuint StaticRenders, DynamicRenders, Copies;
+
+    // shadowTexture is a GL_TEXTURE_2D_ARRAY of layerCount layers of resolution x resolution texels in internalFormat
+    ShadowCache(GLuint shadowTexture, GLuint resolution, GLuint layerCount, GLenum internalFormat,
+                GLuint updateInterval = 1, GLuint updateOffset = 0)
+        : StaticTexture(0), UpdateInterval(updateInterval), UpdateOffset(updateOffset),
+          StaticRenders(0), DynamicRenders(0), Copies(0),
+          shadowTexture(shadowTexture), resolution(resolution), layerCount(layerCount),
+          staticFBO(0), shadowFBO(0), frame(0), statsFrames(0),
+          cachedMatrices(layerCount), staticValid(layerCount, GL_FALSE), holdsDynamic(layerCount, GL_FALSE)
+    {
+        glGenTextures(1, &this->StaticTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->StaticTexture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, resolution, resolution, layerCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        // Never sampled, only blitted from
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &this->staticFBO);
+        glGenFramebuffers(1, &this->shadowFBO);
+        GLuint fbos[] = { this->staticFBO, this->shadowFBO };
+        GLuint textures[] = { this->StaticTexture, this->shadowTexture };
+        for (GLuint i = 0; i < 2; i++)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbos[i]);
+            this->attach(GL_FRAMEBUFFER, textures[i], 0);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::SHADOW_CACHE:: Framebuffer not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~ShadowCache()
+    {
+        glDeleteFramebuffers(1, &this->staticFBO);
+        glDeleteFramebuffers(1, &this->shadowFBO);
+        glDeleteTextures(1, &this->StaticTexture);
+    }
+
+    // Call once per frame. Returns GL_TRUE on the frames the light may update its shadow matrices.
+    GLboolean BeginFrame()
+    {
+        GLuint interval = this->UpdateInterval > 0 ? this->UpdateInterval : 1;
+        this->statsFrames++;
+        return this->frame++ % interval == this->UpdateOffset % interval;
+    }
+
+    // The static casters moved, re-render them on the next Render()
+    void Invalidate()
+    {
+        for (GLuint i = 0; i < this->layerCount; i++)
+            this->staticValid[i] = GL_FALSE;
+    }
+
+    // Brings the shadow map up to date for the given per-layer light matrices.
+    // setupLayer(GLint layer) is called with the layer attached to set the depth shader's matrices,
+    // drawStatic() and drawDynamic() draw the casters. dynamicBounds are the world space bounding spheres of
+    // what drawDynamic() draws (center, radius). Leaves a framebuffer with the shadow map attached bound
+    // and the viewport set to the shadow map resolution.
+    template <typename SetupFunction, typename StaticFunction, typename DynamicFunction>
+    void Render(const std::vector<glm::mat4>& layerMatrices, SetupFunction setupLayer, StaticFunction drawStatic,
+                const std::vector<glm::vec4>& dynamicBounds, DynamicFunction drawDynamic)
+    {
+        std::vector<GLboolean> stale(this->layerCount, GL_FALSE);
+        std::vector<GLboolean> dynamic(this->layerCount, GL_FALSE);
+        GLboolean anyStale = GL_FALSE;
+        for (GLuint i = 0; i < this->layerCount; i++)
+        {
+            stale[i] = !this->staticValid[i] || layerMatrices[i] != this->cachedMatrices[i];
+            anyStale = anyStale || stale[i];
+            for (GLuint j = 0; j < dynamicBounds.size() && !dynamic[i]; j++)
+                dynamic[i] = touches(layerMatrices[i], dynamicBounds[j]);
+        }
+
+        glViewport(0, 0, this->resolution, this->resolution);
+
+        // 1. Static casters, only into the layers whose light matrix changed
+        if (anyStale)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, this->staticFBO);
+            for (GLuint i = 0; i < this->layerCount; i++)
+            {
+                if (!stale[i])
+                    continue;
+                this->attach(GL_FRAMEBUFFER, this->StaticTexture, i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                setupLayer(i);
+                drawStatic();
+                this->cachedMatrices[i] = layerMatrices[i];
+                this->staticValid[i] = GL_TRUE;
+                this->StaticRenders++;
+            }
+        }
+
+        // 2. Restore the shadow map layers that are out of date: a depth blit is far cheaper than redrawing the casters
+        for (GLuint i = 0; i < this->layerCount; i++)
+        {
+            if (!stale[i] && !this->holdsDynamic[i] && !dynamic[i])
+                continue;
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, this->staticFBO);
+            this->attach(GL_READ_FRAMEBUFFER, this->StaticTexture, i);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->shadowFBO);
+            this->attach(GL_DRAW_FRAMEBUFFER, this->shadowTexture, i);
+            glBlitFramebuffer(0, 0, this->resolution, this->resolution, 0, 0, this->resolution, this->resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            this->holdsDynamic[i] = GL_FALSE;
+            this->Copies++;
+        }
+
+        // 3. Dynamic casters on top, in the layers they touch
+        glBindFramebuffer(GL_FRAMEBUFFER, this->shadowFBO);
+        for (GLuint i = 0; i < this->layerCount; i++)
+        {
+            if (!dynamic[i])
+                continue;
+            this->attach(GL_FRAMEBUFFER, this->shadowTexture, i);
+            setupLayer(i);
+            drawDynamic();
+            this->holdsDynamic[i] = GL_TRUE;
+            this->DynamicRenders++;
+        }
+    }
+
+    // Prints the average work per frame since the last call
+    void PrintStats(const std::string& name)
+    {
+        GLfloat frames = this->statsFrames > 0 ? (GLfloat)this->statsFrames : 1.0f;
+        std::cout << "Shadow cache '" << name << "': " << this->StaticRenders / frames << " static, "
+                  << this->DynamicRenders / frames << " dynamic, " << this->Copies / frames << " copied layers per frame" << std::endl;
+        this->StaticRenders = this->DynamicRenders = this->Copies = 0;
+        this->statsFrames = 0;
+    }
+
+    // Video memory used by the static layers in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        return (GLsizeiptr)this->resolution * this->resolution * this->layerCount * 4;
+    }
+
+private:
+    GLuint shadowTexture;
+    GLuint resolution;
+    GLuint layerCount;
+    GLuint staticFBO, shadowFBO;
+    GLuint frame, statsFrames;
+    std::vector<glm::mat4> cachedMatrices; // Matrices the static layers were rendered with
+    std::vector<GLboolean> staticValid;
+    std::vector<GLboolean> holdsDynamic;   // The shadow map layer differs from the static layer
+
+    void attach(GLenum framebuffer, GLuint texture, GLuint layer)
+    {
+        glFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+    }
+
+    // Whether the sphere (center, radius) is inside the side planes of the light's frustum. Near and far are left
+    // out: with depth clamping, casters in front of the near plane still land in the layer.
+    static GLboolean touches(const glm::mat4& lightSpaceMatrix, const glm::vec4& sphere)
+    {
+        glm::vec3 center(sphere);
+        glm::vec4 w(lightSpaceMatrix[0][3], lightSpaceMatrix[1][3], lightSpaceMatrix[2][3], lightSpaceMatrix[3][3]);
+        for (GLint i = 0; i < 2; i++)
+        {
+            glm::vec4 row(lightSpaceMatrix[0][i], lightSpaceMatrix[1][i], lightSpaceMatrix[2][i], lightSpaceMatrix[3][i]);
+            glm::vec4 planes[2] = { w + row, w - row };
+            for (GLint j = 0; j < 2; j++)
+            {
+                glm::vec3 normal(planes[j]);
+                if (glm::dot(normal, center) + planes[j].w < -sphere.w * glm::length(normal))
+                    return GL_FALSE;
+            }
+        }
+        return GL_TRUE;
+    }
+};
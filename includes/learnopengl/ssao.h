@@ -0,0 +1,240 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/screen_quad.h>
+
+// Sample counts of the SSAO kernel
+enum SSAOQuality {
+    SSAO_LOW,    // 8 samples
+    SSAO_MEDIUM, // 16 samples
+    SSAO_HIGH    // 32 samples
+};
+
+// Screen space ambient occlusion (Crytek's normal oriented hemisphere variant) computed at a reduced resolution.
+// Full resolution SSAO is one of the most fill rate hungry passes of a frame, while the occlusion itself is low
+// frequency, so all the heavy work runs at 1/downscale the resolution (1/4 the pixels for the default 2):
+//   1. downsample: the G-buffer depth and normal are reduced to one RGBA16F (normal, linear depth) target
+//   2. ssao:       hemisphere kernel around the normal, rotated per pixel with a tiled 4x4 noise texture
+//   3. blur:       separable bilateral blur that removes the noise pattern without blurring across edges
+//   4. upsample:   depth aware upsampling to the full resolution AOTexture(), see shaders/ssao_upsample.frag
+// Expects a G-buffer as written by shaders/g_buffer.frag (depth texture, octahedron encoded view space normals).
+class SSAORenderer
+{
+public:
+    // SSAO options
+    GLfloat Radius;        // View space radius of the sample hemisphere
+    GLfloat Bias;          // Depth offset against self occlusion on flat surfaces
+    GLfloat Power;         // Contrast of the result
+    GLfloat BlurSharpness; // How quickly blur taps lose their weight across depth differences
+    GLboolean Blur;
+    GLuint Width, Height, Downscale;
+
+    SSAORenderer(GLuint width, GLuint height, SSAOQuality quality = SSAO_MEDIUM, GLuint downscale = 2)
+        : Radius(0.5f), Bias(0.025f), Power(2.0f), BlurSharpness(200.0f), Blur(GL_TRUE), Width(0), Height(0), Downscale(downscale),
+          kernelSize(0), downsampleShader("shaders/bloom_final.vs", "shaders/ssao_downsample.frag"),
+          ssaoShader("shaders/bloom_final.vs", "shaders/ssao.frag"), blurShader("shaders/bloom_final.vs", "shaders/ssao_blur.frag"),
+          upsampleShader("shaders/bloom_final.vs", "shaders/ssao_upsample.frag")
+    {
+        glGenFramebuffers(1, &this->FBO);
+        glGenTextures(1, &this->depthNormalTexture);
+        glGenTextures(2, this->aoTextures);
+        glGenTextures(1, &this->upsampledTexture);
+        this->Resize(width, height);
+
+        // 4x4 random rotations around the z axis (the normal in tangent space), tiled over the screen
+        std::uniform_real_distribution<GLfloat> random(0.0f, 1.0f);
+        std::default_random_engine generator;
+        std::vector<glm::vec3> noise;
+        for (GLuint i = 0; i < 16; i++)
+            noise.push_back(glm::vec3(random(generator) * 2.0f - 1.0f, random(generator) * 2.0f - 1.0f, 0.0f));
+        glGenTextures(1, &this->noiseTexture);
+        glBindTexture(GL_TEXTURE_2D, this->noiseTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 4, 4, 0, GL_RGB, GL_FLOAT, &noise[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        this->downsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->downsampleShader.Program, "gDepth"), 0);
+        glUniform1i(glGetUniformLocation(this->downsampleShader.Program, "gNormal"), 1);
+        this->ssaoShader.Use();
+        glUniform1i(glGetUniformLocation(this->ssaoShader.Program, "depthNormal"), 0);
+        glUniform1i(glGetUniformLocation(this->ssaoShader.Program, "noiseTexture"), 1);
+        this->blurShader.Use();
+        glUniform1i(glGetUniformLocation(this->blurShader.Program, "aoTexture"), 0);
+        glUniform1i(glGetUniformLocation(this->blurShader.Program, "depthNormal"), 1);
+        this->upsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->upsampleShader.Program, "aoTexture"), 0);
+        glUniform1i(glGetUniformLocation(this->upsampleShader.Program, "depthNormal"), 1);
+        glUniform1i(glGetUniformLocation(this->upsampleShader.Program, "gDepth"), 2);
+        glUseProgram(0);
+        this->SetQuality(quality);
+    }
+
+    ~SSAORenderer()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(1, &this->depthNormalTexture);
+        glDeleteTextures(2, this->aoTextures);
+        glDeleteTextures(1, &this->upsampledTexture);
+        glDeleteTextures(1, &this->noiseTexture);
+    }
+
+    // (Re)creates the targets for a new full resolution
+    void Resize(GLuint width, GLuint height)
+    {
+        this->Width = width;
+        this->Height = height;
+        GLuint lowWidth = std::max(width / this->Downscale, 1u), lowHeight = std::max(height / this->Downscale, 1u);
+        this->allocateTarget(this->depthNormalTexture, GL_RGBA16F, GL_RGBA, GL_FLOAT, lowWidth, lowHeight);
+        for (GLuint i = 0; i < 2; i++)
+            this->allocateTarget(this->aoTextures[i], GL_R8, GL_RED, GL_UNSIGNED_BYTE, lowWidth, lowHeight);
+        this->allocateTarget(this->upsampledTexture, GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->depthNormalTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::SSAO:: Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Regenerates the sample kernel for the preset's sample count
+    void SetQuality(SSAOQuality quality)
+    {
+        const GLuint sampleCounts[] = { 8, 16, 32 };
+        this->kernelSize = sampleCounts[quality];
+
+        // Samples in the hemisphere around +z, more of them close to the center where occlusion matters most
+        std::uniform_real_distribution<GLfloat> random(0.0f, 1.0f);
+        std::default_random_engine generator;
+        this->ssaoShader.Use();
+        for (GLuint i = 0; i < this->kernelSize; i++)
+        {
+            glm::vec3 sample(random(generator) * 2.0f - 1.0f, random(generator) * 2.0f - 1.0f, random(generator));
+            sample = glm::normalize(sample) * random(generator);
+            GLfloat scale = (GLfloat)i / this->kernelSize;
+            sample *= 0.1f + 0.9f * scale * scale;
+            glUniform3fv(glGetUniformLocation(this->ssaoShader.Program, ("samples[" + std::to_string(i) + "]").c_str()), 1, &sample[0]);
+        }
+        glUniform1i(glGetUniformLocation(this->ssaoShader.Program, "kernelSize"), this->kernelSize);
+        glUseProgram(0);
+    }
+
+    // Computes the occlusion of the G-buffer rendered with projection. Leaves framebuffer 0 bound, the caller restores its viewport.
+    void Render(GLuint depthTexture, GLuint normalTexture, const glm::mat4& projection, GLfloat nearPlane, GLfloat farPlane)
+    {
+        GLuint lowWidth = std::max(this->Width / this->Downscale, 1u), lowHeight = std::max(this->Height / this->Downscale, 1u);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glDisable(GL_DEPTH_TEST);
+        glViewport(0, 0, lowWidth, lowHeight);
+
+        // 1. Downsample depth and normals
+        this->downsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->downsampleShader.Program, "downscale"), this->Downscale);
+        glUniform1f(glGetUniformLocation(this->downsampleShader.Program, "nearPlane"), nearPlane);
+        glUniform1f(glGetUniformLocation(this->downsampleShader.Program, "farPlane"), farPlane);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->depthNormalTexture, 0);
+        this->bindTextures(depthTexture, normalTexture, 0);
+        RenderScreenQuad();
+
+        // 2. Occlusion
+        this->ssaoShader.Use();
+        glUniform1f(glGetUniformLocation(this->ssaoShader.Program, "radius"), this->Radius);
+        glUniform1f(glGetUniformLocation(this->ssaoShader.Program, "bias"), this->Bias);
+        glUniform1f(glGetUniformLocation(this->ssaoShader.Program, "power"), this->Power);
+        glUniform2f(glGetUniformLocation(this->ssaoShader.Program, "noiseScale"), lowWidth / 4.0f, lowHeight / 4.0f);
+        glUniformMatrix4fv(glGetUniformLocation(this->ssaoShader.Program, "projection"), 1, GL_FALSE, &projection[0][0]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->aoTextures[0], 0);
+        this->bindTextures(this->depthNormalTexture, this->noiseTexture, 0);
+        RenderScreenQuad();
+
+        // 3. Bilateral blur, horizontal into aoTextures[1] and vertical back into aoTextures[0]
+        if (this->Blur)
+        {
+            this->blurShader.Use();
+            glUniform1f(glGetUniformLocation(this->blurShader.Program, "sharpness"), this->BlurSharpness);
+            for (GLuint i = 0; i < 2; i++)
+            {
+                glUniform2i(glGetUniformLocation(this->blurShader.Program, "direction"), i == 0, i == 1);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->aoTextures[1 - i], 0);
+                this->bindTextures(this->aoTextures[i], this->depthNormalTexture, 0);
+                RenderScreenQuad();
+            }
+        }
+
+        // 4. Depth aware upsampling to the full resolution
+        glViewport(0, 0, this->Width, this->Height);
+        this->upsampleShader.Use();
+        glUniform1i(glGetUniformLocation(this->upsampleShader.Program, "downscale"), this->Downscale);
+        glUniform1f(glGetUniformLocation(this->upsampleShader.Program, "nearPlane"), nearPlane);
+        glUniform1f(glGetUniformLocation(this->upsampleShader.Program, "farPlane"), farPlane);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->upsampledTexture, 0);
+        this->bindTextures(this->aoTextures[0], this->depthNormalTexture, depthTexture);
+        RenderScreenQuad();
+
+        glEnable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Full resolution ambient occlusion, 1 for unoccluded
+    GLuint AOTexture() const { return this->upsampledTexture; }
+
+    GLuint KernelSize() const { return this->kernelSize; }
+
+    // Video memory used by the targets in bytes
+    GLsizeiptr MemoryBytes() const
+    {
+        GLsizeiptr lowPixels = (GLsizeiptr)std::max(this->Width / this->Downscale, 1u) * std::max(this->Height / this->Downscale, 1u);
+        return lowPixels * (8 + 1 + 1) + (GLsizeiptr)this->Width * this->Height;
+    }
+
+private:
+    GLuint FBO;
+    GLuint depthNormalTexture;
+    GLuint aoTextures[2];
+    GLuint upsampledTexture;
+    GLuint noiseTexture;
+    GLuint kernelSize;
+    Shader downsampleShader;
+    Shader ssaoShader;
+    Shader blurShader;
+    Shader upsampleShader;
+
+    void allocateTarget(GLuint texture, GLenum internalFormat, GLenum format, GLenum type, GLuint width, GLuint height)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Binds up to three textures to units 0, 1 and 2, 0 skips a unit
+    void bindTextures(GLuint unit0, GLuint unit1, GLuint unit2)
+    {
+        GLuint textures[] = { unit0, unit1, unit2 };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            if (textures[i] == 0)
+                continue;
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+// Std. Includes
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/screen_quad.h>
+
+// Temporal anti-aliasing. Every frame is rendered with the projection shifted by a different sub-pixel offset
+// (Camera::GetJitteredProjectionMatrix), and a resolve pass blends it into a history of the previous frames, so
+// edges and thin geometry converge to a supersampled result at the cost of one full-screen pass.
+//
+// The history is reprojected with a velocity buffer computed from the scene depth and the camera matrices of both
+// frames (shaders/taa_velocity.frag): camera motion only, objects moving on their own are covered by the
+// neighbourhood clamp in the resolve (shaders/taa_resolve.frag) instead of exact reprojection.
+// Resolved frames alternate between two RGB16F targets, OutputTexture() is this frame's result and the history of
+// the next one. The resolve works on the HDR scene, so bloom and tonemapping see the anti-aliased image.
+class TemporalAA
+{
+public:
+    GLfloat Feedback;   // Weight of the history, higher is smoother but slower to react
+    GLuint SampleCount; // Length of the jitter sequence
+    GLuint FrameIndex;
+    GLuint Width, Height;
+
+    TemporalAA(GLuint width, GLuint height)
+        : Feedback(0.9f), SampleCount(8), FrameIndex(0), Width(0), Height(0), FBO(0), current(0), historyValid(GL_FALSE),
+          velocityShader("shaders/bloom_final.vs", "shaders/taa_velocity.frag"),
+          resolveShader("shaders/bloom_final.vs", "shaders/taa_resolve.frag")
+    {
+        glGenFramebuffers(1, &this->FBO);
+        glGenTextures(2, this->history);
+        this->Resize(width, height);
+
+        this->velocityShader.Use();
+        glUniform1i(glGetUniformLocation(this->velocityShader.Program, "depthTexture"), 0);
+        this->resolveShader.Use();
+        glUniform1i(glGetUniformLocation(this->resolveShader.Program, "currentColor"), 0);
+        glUniform1i(glGetUniformLocation(this->resolveShader.Program, "historyColor"), 1);
+        glUniform1i(glGetUniformLocation(this->resolveShader.Program, "velocityTexture"), 2);
+        glUniform1i(glGetUniformLocation(this->resolveShader.Program, "depthTexture"), 3);
+        glUseProgram(0);
+    }
+
+    ~TemporalAA()
+    {
+        glDeleteFramebuffers(1, &this->FBO);
+        glDeleteTextures(2, this->history);
+    }
+
+    // (Re)allocates the history targets, which drops the accumulated history
+    void Resize(GLuint width, GLuint height)
+    {
+        this->Width = width;
+        this->Height = height;
+        for (GLuint i = 0; i < 2; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, this->history[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Reprojected history is sampled between texels
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        this->Reset();
+    }
+
+    // Forgets the history, e.g. after the anti-aliasing was switched off for a while or the camera jumped
+    void Reset()
+    {
+        this->historyValid = GL_FALSE;
+    }
+
+    // Starts a frame: remembers the camera matrices for the velocity pass and returns the jittered projection
+    // the scene has to be rendered with
+    glm::mat4 BeginFrame(Camera& camera, GLfloat nearPlane, GLfloat farPlane)
+    {
+        GLfloat aspect = (GLfloat)this->Width / (GLfloat)this->Height;
+        glm::mat4 view = camera.GetViewMatrix();
+        this->previousViewProjection = this->historyValid ? this->viewProjection : camera.GetProjectionMatrix(aspect, nearPlane, farPlane) * view;
+        this->viewProjection = camera.GetProjectionMatrix(aspect, nearPlane, farPlane) * view;
+        glm::mat4 projection = camera.GetJitteredProjectionMatrix(aspect, nearPlane, farPlane, this->FrameIndex, this->Width, this->Height, this->SampleCount);
+        this->inverseViewProjection = glm::inverse(projection * view);
+        this->FrameIndex++;
+        this->current = 1 - this->current;
+        return projection;
+    }
+
+    // Writes the camera velocity (RG16F is enough) of depthTexture to the bound framebuffer
+    void RenderVelocity(GLuint depthTexture)
+    {
+        glDisable(GL_DEPTH_TEST);
+        this->velocityShader.Use();
+        glUniformMatrix4fv(glGetUniformLocation(this->velocityShader.Program, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(this->inverseViewProjection));
+        glUniformMatrix4fv(glGetUniformLocation(this->velocityShader.Program, "currentViewProjection"), 1, GL_FALSE, glm::value_ptr(this->viewProjection));
+        glUniformMatrix4fv(glGetUniformLocation(this->velocityShader.Program, "previousViewProjection"), 1, GL_FALSE, glm::value_ptr(this->previousViewProjection));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        RenderScreenQuad();
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    // Blends colorTexture into the history and writes the result to OutputTexture(). Leaves framebuffer 0 bound.
+    void Resolve(GLuint colorTexture, GLuint depthTexture, GLuint velocityTexture)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->history[this->current], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::TAA:: Framebuffer not complete!" << std::endl;
+        glViewport(0, 0, this->Width, this->Height);
+        glDisable(GL_DEPTH_TEST);
+        this->resolveShader.Use();
+        glUniform2f(glGetUniformLocation(this->resolveShader.Program, "texelSize"), 1.0f / this->Width, 1.0f / this->Height);
+        glUniform1f(glGetUniformLocation(this->resolveShader.Program, "feedback"), this->Feedback);
+        glUniform1i(glGetUniformLocation(this->resolveShader.Program, "historyValid"), this->historyValid);
+        GLuint textures[4] = { colorTexture, this->history[1 - this->current], velocityTexture, depthTexture };
+        for (GLuint i = 0; i < 4; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        RenderScreenQuad();
+        glEnable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        this->historyValid = GL_TRUE;
+    }
+
+    // This frame's resolved HDR color, valid after Resolve() until the next BeginFrame()
+    GLuint OutputTexture() const { return this->history[this->current]; }
+
+    // Video memory of the two history targets in bytes (RGB16F, usually padded to 8 bytes a pixel)
+    GLsizeiptr MemoryBytes() const { return (GLsizeiptr)this->Width * this->Height * 8 * 2; }
+
+private:
+    GLuint FBO;
+    GLuint history[2];
+    GLuint current;
+    GLboolean historyValid;
+    glm::mat4 viewProjection, previousViewProjection, inverseViewProjection;
+    Shader velocityShader;
+    Shader resolveShader;
+};
@@ -0,0 +1,268 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Other Libs
+#include <SOIL.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/mip_builder.h>
+#include <learnopengl/dxt_compressor.h>
+#include <learnopengl/mapped_file.h>
+
+// Resamples an 8 bit image to width x height, averaging the covered source texels along an axis that shrinks and
+// interpolating linearly along one that grows
+inline void ResampleImage(const unsigned char* source, GLint sourceWidth, GLint sourceHeight, GLint channels,
+                          GLint width, GLint height, std::vector<unsigned char>& destination)
+{
+    struct Axis {
+        // Filters one line of samples, stride apart in both src and dst
+        static void Resample(const GLfloat* src, GLint srcCount, GLfloat* dst, GLint dstCount, GLint stride)
+        {
+            GLfloat scale = (GLfloat)srcCount / dstCount;
+            for (GLint i = 0; i < dstCount; i++)
+            {
+                if (scale > 1.0f)
+                {
+                    GLfloat begin = i * scale, end = begin + scale, sum = 0.0f;
+                    for (GLint s = (GLint)begin; s < end && s < srcCount; s++)
+                        sum += (std::min(end, s + 1.0f) - std::max(begin, (GLfloat)s)) * src[s * stride];
+                    dst[i * stride] = sum / scale;
+                }
+                else
+                {
+                    GLfloat x = std::max((i + 0.5f) * scale - 0.5f, 0.0f);
+                    GLint s0 = std::min((GLint)x, srcCount - 1), s1 = std::min(s0 + 1, srcCount - 1);
+                    GLfloat t = x - s0;
+                    dst[i * stride] = src[s0 * stride] * (1.0f - t) + src[s1 * stride] * t;
+                }
+            }
+        }
+    };
+    // Channels are interleaved, so every channel of a row is a line with a stride of channels
+    std::vector<GLfloat> image(source, source + sourceWidth * sourceHeight * channels);
+    std::vector<GLfloat> rows(width * sourceHeight * channels), result(width * height * channels);
+    for (GLint c = 0; c < channels; c++)
+    {
+        for (GLint y = 0; y < sourceHeight; y++)
+            Axis::Resample(&image[y * sourceWidth * channels + c], sourceWidth, &rows[y * width * channels + c], width, channels);
+        for (GLint x = 0; x < width; x++)
+            Axis::Resample(&rows[x * channels + c], sourceHeight, &result[x * channels + c], height, width * channels);
+    }
+    destination.resize(result.size());
+    for (GLuint i = 0; i < result.size(); i++)
+        destination[i] = (unsigned char)std::min(std::max(result[i] + 0.5f, 0.0f), 255.0f);
+}
+
+// Packs material textures into GL_TEXTURE_2D_ARRAYs, so meshes with different textures can be drawn without
+// rebinding in between (see MaterialBatch). Every texture is resampled to the power of two square nearest its larger
+// side (limited to MinSize ... MaxSize) and becomes a layer of the array of that size, so a handful of arrays hold
+// them all. Layers keep their full mip chain (CPU built, see MipBuilder) and are DXT1 compressed when S3TC is
+// supported (with EXT_texture_sRGB for Gamma arrays); repeat wrapping works as with separate textures.
+// Add() every texture first, then Build() once: decoding, filtering and compression run on all hardware threads.
+class TextureArrays
+{
+public:
+    static const GLuint MAX_ARRAYS = 4; // Samplers the batch shader has
+    GLint MinSize, MaxSize;
+    GLboolean Gamma;
+    std::vector<GLuint> Arrays;    // Texture names, after Build()
+    std::vector<GLint> ArraySizes; // Layer size of each
+
+    TextureArrays(GLint minSize = 64, GLint maxSize = 1024, GLboolean gamma = GL_FALSE)
+        : MinSize(minSize), MaxSize(maxSize), Gamma(gamma), compressed(GL_FALSE), memoryBytes(0)
+    {
+    }
+
+    ~TextureArrays()
+    {
+        if (!this->Arrays.empty())
+            glDeleteTextures(this->Arrays.size(), &this->Arrays[0]);
+    }
+
+    // Queues an image file, returns its index for Slot(). Adding a path again gives the same index.
+    GLuint Add(const std::string& path)
+    {
+        std::map<std::string, GLuint>::iterator found = this->indices.find(path);
+        if (found != this->indices.end())
+            return found->second;
+        this->indices[path] = this->paths.size();
+        this->paths.push_back(path);
+        this->slots.push_back(glm::ivec2(-1, -1));
+        return this->paths.size() - 1;
+    }
+
+    // Where a texture ended up after Build(): x is the array, y the layer. (-1, -1) if it couldn't be loaded.
+    glm::ivec2 Slot(GLuint index) const
+    {
+        return index < this->slots.size() ? this->slots[index] : glm::ivec2(-1, -1);
+    }
+
+    // Decodes every texture added and creates the arrays
+    void Build()
+    {
+        this->compressed = GLEW_EXT_texture_compression_s3tc && (!this->Gamma || GLEW_EXT_texture_sRGB) ? GL_TRUE : GL_FALSE;
+        std::vector<Layer> layers(this->paths.size());
+        this->parallel(&TextureArrays::decodeLayers, layers);
+        // The sizes are known now, so is the array of every layer
+        std::vector<GLint> layerCounts;
+        for (GLuint i = 0; i < layers.size(); i++)
+        {
+            if (layers[i].Image.empty())
+            {
+                std::cout << "ERROR::TEXTURE_ARRAYS:: Failed to load " << this->paths[i] << std::endl;
+                continue;
+            }
+            GLint size = this->layerSize(layers[i].Width, layers[i].Height);
+            GLuint array = std::find(this->ArraySizes.begin(), this->ArraySizes.end(), size) - this->ArraySizes.begin();
+            if (array == this->ArraySizes.size())
+            {
+                if (array == MAX_ARRAYS)
+                    array = MAX_ARRAYS - 1; // Shares the last one, resampled to its size
+                else
+                {
+                    this->ArraySizes.push_back(size);
+                    layerCounts.push_back(0);
+                }
+            }
+            this->slots[i] = glm::ivec2(array, layerCounts[array]++);
+        }
+        this->parallel(&TextureArrays::filterLayers, layers);
+
+        this->Arrays.resize(this->ArraySizes.size());
+        if (!this->Arrays.empty())
+            glGenTextures(this->Arrays.size(), &this->Arrays[0]);
+        this->memoryBytes = 0;
+        for (GLuint array = 0; array < this->Arrays.size(); array++)
+        {
+            GLint size = this->ArraySizes[array], layerCount = layerCounts[array];
+            GLuint levels = MipBuilder::LevelCount(size, size);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, this->Arrays[array]);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (GLuint level = 0; level < levels; level++)
+            {
+                // All layers of a level in one upload
+                GLint levelSize = std::max(size >> level, 1);
+                GLsizei layerBytes = this->compressed ? DXTCompressor::CompressedSize(levelSize, levelSize, GL_FALSE) : levelSize * levelSize * 3;
+                std::vector<unsigned char> data((size_t)layerBytes * layerCount, 0);
+                for (GLuint i = 0; i < layers.size(); i++)
+                    if (this->slots[i].x == (GLint)array)
+                        std::copy(layers[i].Levels[level].Pixels.begin(), layers[i].Levels[level].Pixels.end(), data.begin() + (size_t)layerBytes * this->slots[i].y);
+                if (this->compressed)
+                    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, this->Gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                           levelSize, levelSize, layerCount, 0, data.size(), &data[0]);
+                else
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, this->Gamma ? GL_SRGB8 : GL_RGB8, levelSize, levelSize, layerCount, 0, GL_RGB, GL_UNSIGNED_BYTE, &data[0]);
+                this->memoryBytes += this->compressed ? data.size() : data.size() / 3 * 4;
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    // Binds the arrays to units firstUnit onwards and points shader's materialArrayN samplers at them.
+    // Returns the number of textures bound.
+    GLuint Bind(Shader& shader, GLuint firstUnit) const
+    {
+        for (GLuint i = 0; i < this->Arrays.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, this->Arrays[i]);
+            glUniform1i(glGetUniformLocation(shader.Program, ("materialArray" + std::to_string(i)).c_str()), firstUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        return this->Arrays.size();
+    }
+
+    GLuint TextureCount() const { return this->paths.size(); }
+
+    // Video memory of all arrays in bytes (uncompressed RGB counted as 4 bytes a texel)
+    GLsizeiptr MemoryBytes() const { return this->memoryBytes; }
+
+private:
+    struct Layer {
+        GLint Width, Height;
+        std::vector<unsigned char> Image; // Decoded RGB, until filterLayers() replaces it by Levels
+        std::vector<MipLevel> Levels;
+    };
+
+    GLboolean compressed;
+    GLsizeiptr memoryBytes;
+    std::vector<std::string> paths;
+    std::vector<glm::ivec2> slots;
+    std::map<std::string, GLuint> indices;
+
+    GLint layerSize(GLint width, GLint height) const
+    {
+        GLint side = std::max(width, height), size = 1;
+        while (size * 3 / 2 < side) // Nearest power of two, rounding up from 1.5x
+            size *= 2;
+        return std::min(std::max(size, this->MinSize), this->MaxSize);
+    }
+
+    // Runs step over the layers on all hardware threads, the calling one included
+    void parallel(void (TextureArrays::*step)(GLuint, GLuint, std::vector<Layer>*) const, std::vector<Layer>& layers) const
+    {
+        GLuint threads = std::max(std::min(std::thread::hardware_concurrency(), (GLuint)layers.size()), 1u);
+        std::vector<std::thread> workers;
+        for (GLuint t = 1; t < threads; t++)
+            workers.push_back(std::thread(step, this, t, threads, &layers));
+        (this->*step)(0, threads, &layers);
+        for (GLuint i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    // Decodes every threads-th layer starting at first
+    void decodeLayers(GLuint first, GLuint threads, std::vector<Layer>* layers) const
+    {
+        for (GLuint i = first; i < layers->size(); i += threads)
+        {
+            Layer& layer = (*layers)[i];
+            unsigned char* image = LoadImageMapped(this->paths[i], &layer.Width, &layer.Height, 0, SOIL_LOAD_RGB);
+            if (!image)
+                continue;
+            layer.Image.assign(image, image + layer.Width * layer.Height * 3);
+            SOIL_free_image_data(image);
+        }
+    }
+
+    // Resamples to the array's size, builds the mip chain and compresses it, for every threads-th layer starting at first
+    void filterLayers(GLuint first, GLuint threads, std::vector<Layer>* layers) const
+    {
+        DXTCompressor compressor(DXT_QUALITY_NORMAL, 1);
+        MipBuilder mips(MIP_FILTER_KAISER, this->Gamma, 0.0f, 1);
+        std::vector<unsigned char> resampled, blocks;
+        for (GLuint i = first; i < layers->size(); i += threads)
+        {
+            Layer& layer = (*layers)[i];
+            if (layer.Image.empty())
+                continue;
+            GLint size = this->ArraySizes[this->slots[i].x];
+            ResampleImage(&layer.Image[0], layer.Width, layer.Height, 3, size, size, resampled);
+            std::vector<unsigned char>().swap(layer.Image);
+            mips.Build(&resampled[0], size, size, 3, layer.Levels);
+            if (this->compressed)
+                for (GLuint level = 0; level < layer.Levels.size(); level++)
+                {
+                    compressor.Compress(&layer.Levels[level].Pixels[0], layer.Levels[level].Width, layer.Levels[level].Height, 3, GL_FALSE, blocks);
+                    layer.Levels[level].Pixels.swap(blocks);
+                }
+        }
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Other Libs
+#include <SOIL.h>
+#include <image_DXT.h>
+
+#include <learnopengl/dxt_compressor.h>
+#include <learnopengl/mip_builder.h>
+#include <learnopengl/mapped_file.h>
+
+// Texture baking: PNG/JPG sources are converted once into DDS files holding DXT1 (RGB) or DXT5 (RGBA) blocks with
+// the complete mip chain, so loading is reading the file and handing every level to glCompressedTexImage2D.
+// Compared to the decoded image with glGenerateMipmap that is 1/6 (DXT1 against the usual 4 byte texel) or 1/4 of
+// the video memory and no decoding or filtering at load time.
+//
+// Baked files live next to their source ("wood.png" -> "wood.png.dds") and are rebuilt on first use or whenever
+// the source is newer or the mip settings changed, so baking happens on the first run without a separate build step.
+// Mips are built on the CPU with a Kaiser filter, in linear space for sRGB textures and with the alpha test coverage
+// of the base level kept for cut out textures (see MipBuilder).
+// SOIL's own DDS loader isn't used as it detects DXT support through glGetString(GL_EXTENSIONS), which core
+// profiles don't support.
+
+// Path of the baked version of a source image
+inline std::string BakedTexturePath(const std::string& source)
+{
+    return source + ".dds";
+}
+
+// Identifies the format (DXT5 with alpha, DXT1 without) and mip settings a file was baked with (kept in the first
+// reserved word of the DDS header), so changing them rebakes like a newer source does
+inline GLuint BakeParameters(const MipBuilder& mips, GLboolean alpha)
+{
+    const GLuint version = 1;
+    return (version << 24) | ((GLuint)(mips.AlphaCutoff * 255.0f + 0.5f) << 8) | (alpha ? 4 : 0) | (mips.SRGB ? 2 : 0)
+         | (mips.Filter == MIP_FILTER_KAISER ? 1 : 0);
+}
+
+// True if the baked file exists, is at least as new as its source and was baked with the given parameters
+inline bool BakedTextureUpToDate(const std::string& source, GLuint parameters)
+{
+    struct stat sourceInfo, bakedInfo;
+    std::string baked = BakedTexturePath(source);
+    if (stat(baked.c_str(), &bakedInfo) != 0)
+        return false;
+    if (stat(source.c_str(), &sourceInfo) == 0 && bakedInfo.st_mtime < sourceInfo.st_mtime)
+        return false;
+    FILE* file = fopen(baked.c_str(), "rb");
+    if (!file)
+        return false;
+    DDS_header header;
+    bool read = fread(&header, sizeof(DDS_header), 1, file) == 1;
+    fclose(file);
+    return read && header.dwReserved1[0] == parameters;
+}
+
+// Converts source into a DDS file at destination: DXT5 if alpha is set, DXT1 otherwise, with all mip levels down to 1x1
+// filtered by mips. Returns false if the source can't be read or the destination written.
+inline bool BakeTexture(const std::string& source, const std::string& destination, GLboolean alpha,
+                        const MipBuilder& mips = MipBuilder(MIP_FILTER_KAISER), const DXTCompressor& compressor = DXTCompressor())
+{
+    GLint width, height;
+    GLint channels = alpha ? 4 : 3;
+    unsigned char* image = LoadImageMapped(source, &width, &height, 0, alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+    if (!image)
+    {
+        std::cout << "ERROR::TEXTURE_BAKER:: Failed to load " << source << std::endl;
+        return false;
+    }
+    std::vector<MipLevel> levels;
+    mips.Build(image, width, height, channels, levels);
+    SOIL_free_image_data(image);
+
+    // Compress every level of the chain
+    std::vector<unsigned char> blocks, compressed;
+    GLint baseSize = 0;
+    for (GLuint i = 0; i < levels.size(); i++)
+    {
+        compressor.Compress(&levels[i].Pixels[0], levels[i].Width, levels[i].Height, channels, alpha, compressed);
+        blocks.insert(blocks.end(), compressed.begin(), compressed.end());
+        if (i == 0)
+            baseSize = compressed.size();
+    }
+
+    DDS_header header;
+    memset(&header, 0, sizeof(DDS_header));
+    header.dwMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
+    header.dwSize = 124;
+    header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | DDSD_MIPMAPCOUNT;
+    header.dwWidth = width;
+    header.dwHeight = height;
+    header.dwPitchOrLinearSize = baseSize;
+    header.dwMipMapCount = levels.size();
+    header.dwReserved1[0] = BakeParameters(mips, alpha);
+    header.sPixelFormat.dwSize = 32;
+    header.sPixelFormat.dwFlags = DDPF_FOURCC;
+    header.sPixelFormat.dwFourCC = ('D' << 0) | ('X' << 8) | ('T' << 16) | ((alpha ? '5' : '1') << 24);
+    header.sCaps.dwCaps1 = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    FILE* file = fopen(destination.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_BAKER:: Failed to write " << destination << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(DDS_header), 1, file) == 1 && fwrite(&blocks[0], 1, blocks.size(), file) == blocks.size();
+    fclose(file);
+    if (!written)
+        remove(destination.c_str());
+    return written;
+}
+
+// Reads a DDS file written by BakeTexture() into one MipLevel of DXT blocks per level, dxt5 is set for DXT5 files.
+// A truncated file gives the levels present. Returns false if the file can't be read or holds no complete level.
+// Doesn't touch GL, so it can run on any thread.
+inline bool ReadBakedTexture(const std::string& path, GLboolean& dxt5, std::vector<MipLevel>& levels)
+{
+    levels.clear();
+    MappedFile file(path);
+    if (!file.Data)
+        return false;
+    // Levels are copied straight out of the mapping
+    DDS_header header;
+    memset(&header, 0, sizeof(DDS_header));
+    const unsigned char* blocks = file.Data + sizeof(DDS_header);
+    size_t blockBytes = 0;
+    if (file.Size > sizeof(DDS_header))
+    {
+        memcpy(&header, file.Data, sizeof(DDS_header));
+        blockBytes = file.Size - sizeof(DDS_header);
+    }
+
+    GLuint dxt1Code = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('1' << 24);
+    GLuint dxt5Code = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('5' << 24);
+    GLuint fourCC = header.sPixelFormat.dwFourCC;
+    if (blockBytes == 0 || header.dwMagic != (GLuint)(('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24)) || (fourCC != dxt1Code && fourCC != dxt5Code))
+    {
+        std::cout << "ERROR::TEXTURE_BAKER:: " << path << " is not a DXT1/DXT5 DDS file" << std::endl;
+        return false;
+    }
+    dxt5 = fourCC == dxt5Code;
+    GLuint levelCount = (header.dwFlags & DDSD_MIPMAPCOUNT) ? std::max(header.dwMipMapCount, 1u) : 1;
+    GLint width = header.dwWidth, height = header.dwHeight;
+    size_t offset = 0;
+    for (GLuint level = 0; level < levelCount; level++)
+    {
+        GLsizei levelSize = DXTCompressor::CompressedSize(width, height, dxt5);
+        if (offset + levelSize > blockBytes)
+            break;
+        MipLevel mip;
+        mip.Width = width;
+        mip.Height = height;
+        mip.Pixels.assign(blocks + offset, blocks + offset + levelSize);
+        levels.push_back(mip);
+        offset += levelSize;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    if (levels.empty())
+    {
+        std::cout << "ERROR::TEXTURE_BAKER:: " << path << " is truncated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Whether baked textures can be uploaded: S3TC, and for sRGB textures its sRGB formats from EXT_texture_sRGB
+inline bool BakedTexturesSupported(bool gamma)
+{
+    return GLEW_EXT_texture_compression_s3tc && (!gamma || GLEW_EXT_texture_sRGB);
+}
+
+// Compressed internal format of baked DXT1/DXT5 data
+inline GLenum BakedTextureFormat(GLboolean dxt5, bool gamma)
+{
+    if (dxt5)
+        return gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    return gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+// Creates a texture from a DDS file written by BakeTexture(), sRGB if gamma is set. Returns 0 if the file
+// can't be read or its format isn't supported (see BakedTexturesSupported()).
+inline GLuint LoadBakedTexture(const std::string& path, bool gamma = false)
+{
+    if (!BakedTexturesSupported(gamma))
+        return 0;
+    GLboolean dxt5;
+    std::vector<MipLevel> levels;
+    if (!ReadBakedTexture(path, dxt5, levels))
+        return 0;
+    GLenum format = BakedTextureFormat(dxt5, gamma);
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    for (GLuint level = 0; level < levels.size(); level++)
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, levels[level].Width, levels[level].Height, 0, levels[level].Pixels.size(), &levels[level].Pixels[0]);
+    // A truncated file still gives a complete texture when sampling stops at the last level present
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return textureID;
+}
+
+// Loads source through its baked DDS, baking it first if needed. alphaCutoff is the alpha test threshold the texture
+// is drawn with, if any. Returns 0 if that fails, so the caller can fall back to loading the source uncompressed.
+// Wrap modes are left to the caller.
+inline GLuint LoadTextureBaked(const std::string& source, bool gamma = false, GLboolean alpha = GL_FALSE, GLfloat alphaCutoff = 0.0f)
+{
+    if (!BakedTexturesSupported(gamma))
+        return 0;
+    std::string baked = BakedTexturePath(source);
+    MipBuilder mips(MIP_FILTER_KAISER, gamma, alpha ? alphaCutoff : 0.0f);
+    if (!BakedTextureUpToDate(source, BakeParameters(mips, alpha)) && !BakeTexture(source, baked, alpha, mips))
+        return 0;
+    return LoadBakedTexture(baked, gamma);
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/texture_streamer.h>
+
+// Keeps the mip levels resident that the current view needs, within a video memory budget.
+// Every frame the meshes using a texture report their bounding sphere (Touch()). Its projected size and how often
+// the texture repeats across the mesh give the texel density needed on screen, and so the finest level worth having.
+// Update() streams finer levels in through the TextureStreamer. When that would go over Budget it first frees levels
+// of the least recently used textures, so levels the view no longer needs stay resident as a cache until the memory
+// is wanted for something else. The levels no larger than MinResidentSize are loaded first and never freed.
+// Textures that share the budget without being managed here (always fully resident) are set aside in ReservedBytes.
+class TextureResidency
+{
+public:
+    GLsizeiptr Budget;      // Bytes of video memory for the textures managed here and ReservedBytes
+    GLsizeiptr ReservedBytes; // Part of Budget held by textures loaded elsewhere, never freed here
+    GLint MinResidentSize;  // Levels up to this size stay resident
+    GLfloat LodBias;        // Added to the estimated level, positive trades sharpness for memory
+    GLsizeiptr ResidentBytes, RequestedBytes; // Resident and on their way, as of the last Update()
+    // Work done since the last PrintStats()
+    GLuint StreamRequests, Evictions;
+
+    TextureResidency(TextureStreamer& streamer, GLsizeiptr budget, GLint minResidentSize = 128)
+        : Budget(budget), ReservedBytes(0), MinResidentSize(minResidentSize), LodBias(0.0f), ResidentBytes(0),
+          RequestedBytes(0), StreamRequests(0), Evictions(0), streamer(streamer), frame(0), pixelsPerUnit(1.0f)
+    {
+    }
+
+    // Creates a texture managed here, with the levels up to MinResidentSize on their way. Arguments as TextureStreamer::Load().
+    GLuint Load(const std::string& path, bool gamma = false, GLboolean alpha = GL_FALSE, GLfloat alphaCutoff = 0.0f)
+    {
+        GLuint texture = this->streamer.Load(path, gamma, alpha, alphaCutoff, this->MinResidentSize);
+        Entry entry = { path, gamma, alpha, alphaCutoff, 0, 0, -1, 0 };
+        this->entries[texture] = entry;
+        return texture;
+    }
+
+    // Starts collecting the textures the frame rendered with this camera uses
+    void BeginFrame(const glm::mat4& view, const glm::mat4& projection, GLfloat viewportHeight)
+    {
+        this->frame++;
+        this->view = view;
+        this->pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f; // Pixels covered by a unit at distance 1
+    }
+
+    // Reports a mesh drawn with texture this frame: its world space bounding sphere and how many times the texture
+    // repeats across it (the texture coordinate range of the mesh)
+    void Touch(GLuint texture, const glm::vec3& center, GLfloat radius, GLfloat repeats)
+    {
+        std::map<GLuint, Entry>::iterator found = this->entries.find(texture);
+        if (found == this->entries.end())
+            return;
+        Entry& entry = found->second;
+        GLfloat depth = -(this->view * glm::vec4(center, 1.0f)).z;
+        if (depth + radius < 0.0f)
+            return; // Behind the camera
+        const TextureStreamer::StreamedTexture* info = this->streamer.Info(texture);
+        GLint wanted = 0;
+        if (info && info->LevelCount > 0)
+        {
+            // Projected diameter from the nearest point of the sphere against the texels across it at level 0
+            GLfloat pixels = 2.0f * radius * this->pixelsPerUnit / std::max(depth - radius, 0.1f);
+            GLfloat texels = std::max(info->Width, info->Height) * std::max(repeats, 0.001f);
+            GLfloat level = std::log(texels / std::max(pixels, 1.0f)) / std::log(2.0f) + this->LodBias;
+            wanted = std::min(std::max((GLint)std::floor(level), 0), info->LevelCount - 1);
+        }
+        if (entry.UsedFrame != this->frame)
+        {
+            entry.UsedFrame = this->frame;
+            entry.Wanted = wanted;
+        }
+        else
+            entry.Wanted = std::min(entry.Wanted, wanted);
+    }
+
+    // Streams in what this frame's Touch() calls asked for and frees what doesn't fit the budget. Call once per
+    // frame after the scene was drawn.
+    void Update()
+    {
+        // Least recently used first
+        std::vector<std::pair<GLuint, GLuint> > order;
+        GLsizeiptr used = this->ReservedBytes;
+        for (std::map<GLuint, Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it)
+        {
+            const TextureStreamer::StreamedTexture* info = this->streamer.Info(it->first);
+            if (!info || info->LevelCount == 0)
+                continue;
+            Entry& entry = it->second;
+            GLint minLevel = this->minLevel(*info);
+            if (entry.Requested < 0)
+                entry.Requested = minLevel; // What Load() asked for
+            entry.Target = entry.UsedFrame == this->frame ? std::min(entry.Wanted, minLevel) : minLevel;
+            used += info->ResidentBytes + this->requestedBytes(entry, *info);
+            order.push_back(std::make_pair(entry.UsedFrame, it->first));
+        }
+        std::sort(order.begin(), order.end());
+
+        this->makeRoom(order, used, 0);
+        // Most recently used first, only what was drawn this frame
+        for (GLint i = (GLint)order.size() - 1; i >= 0 && order[i].first == this->frame; i--)
+        {
+            GLuint texture = order[i].second;
+            Entry& entry = this->entries[texture];
+            const TextureStreamer::StreamedTexture& info = *this->streamer.Info(texture);
+            GLint level = entry.Target;
+            if (level >= entry.Requested)
+                continue;
+            this->makeRoom(order, used, this->levelBytes(info, level, entry.Requested));
+            // Settle for a coarser level if the budget is still short
+            while (level < entry.Requested && used + this->levelBytes(info, level, entry.Requested) > this->Budget)
+                level++;
+            if (level == entry.Requested)
+                continue;
+            used += this->levelBytes(info, level, entry.Requested);
+            this->streamer.Stream(texture, entry.Path, entry.Gamma, entry.Alpha, entry.AlphaCutoff, level, entry.Requested - 1);
+            entry.Requested = level;
+            this->StreamRequests++;
+        }
+
+        this->ResidentBytes = 0;
+        this->RequestedBytes = 0;
+        for (std::map<GLuint, Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it)
+        {
+            const TextureStreamer::StreamedTexture* info = this->streamer.Info(it->first);
+            if (!info || info->LevelCount == 0)
+                continue;
+            this->ResidentBytes += info->ResidentBytes;
+            this->RequestedBytes += this->requestedBytes(it->second, *info);
+        }
+    }
+
+    // Prints the memory use against the budget and the work since the last call
+    void PrintStats()
+    {
+        std::cout << "Texture residency: " << this->ResidentBytes / (1024.0f * 1024.0f) << " MB resident, "
+                  << this->RequestedBytes / (1024.0f * 1024.0f) << " MB on the way, " << this->ReservedBytes / (1024.0f * 1024.0f)
+                  << " MB reserved, budget " << this->Budget / (1024.0f * 1024.0f)
+                  << " MB, " << this->entries.size() << " textures, " << this->StreamRequests << " stream requests, "
+                  << this->Evictions << " evictions" << std::endl;
+        this->StreamRequests = this->Evictions = 0;
+    }
+
+private:
+    struct Entry {
+        std::string Path;
+        bool Gamma;
+        GLboolean Alpha;
+        GLfloat AlphaCutoff;
+        GLint Wanted, Target;
+        GLint Requested;  // Finest level resident or on its way, -1 until the texture's size is known
+        GLuint UsedFrame; // Last frame it was touched
+    };
+
+    TextureStreamer& streamer;
+    std::map<GLuint, Entry> entries;
+    GLuint frame;
+    glm::mat4 view;
+    GLfloat pixelsPerUnit;
+
+    // Finest level that always stays resident
+    GLint minLevel(const TextureStreamer::StreamedTexture& info) const
+    {
+        GLint level = 0;
+        while (level < info.LevelCount - 1 && std::max(info.Width >> level, info.Height >> level) > this->MinResidentSize)
+            level++;
+        return level;
+    }
+
+    // Bytes of levels [first, last)
+    GLsizeiptr levelBytes(const TextureStreamer::StreamedTexture& info, GLint first, GLint last) const
+    {
+        GLsizeiptr bytes = 0;
+        for (GLint level = first; level < last; level++)
+            bytes += TextureStreamer::LevelBytes(info, level);
+        return bytes;
+    }
+
+    // Bytes requested that haven't arrived yet
+    GLsizeiptr requestedBytes(const Entry& entry, const TextureStreamer::StreamedTexture& info) const
+    {
+        GLsizeiptr bytes = 0;
+        for (GLint level = std::max(entry.Requested, 0); level < info.BaseLevel; level++)
+            if (!(info.PresentLevels & (1u << level)))
+                bytes += TextureStreamer::LevelBytes(info, level);
+        return bytes;
+    }
+
+    // Frees the levels of textures finer than their target, least recently used first, until needed more bytes fit
+    void makeRoom(const std::vector<std::pair<GLuint, GLuint> >& order, GLsizeiptr& used, GLsizeiptr needed)
+    {
+        for (GLuint i = 0; i < order.size() && used + needed > this->Budget; i++)
+        {
+            Entry& entry = this->entries[order[i].second];
+            if (entry.Requested >= entry.Target)
+                continue;
+            const TextureStreamer::StreamedTexture& info = *this->streamer.Info(order[i].second);
+            GLsizeiptr before = info.ResidentBytes + this->requestedBytes(entry, info);
+            this->streamer.Evict(order[i].second, entry.Target);
+            entry.Requested = entry.Target;
+            used -= before - (info.ResidentBytes + this->requestedBytes(entry, info));
+            this->Evictions++;
+        }
+    }
+};
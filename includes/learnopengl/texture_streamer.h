@@ -0,0 +1,549 @@
+#pragma once
+
+// Std. Includes
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <utility>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Other Libs
+#include <SOIL.h>
+
+#include <learnopengl/mip_builder.h>
+#include <learnopengl/texture_baker.h>
+
+// Streams textures in without blocking the render thread. Load() returns the texture name at once and queues the
+// file for the worker threads, which decode it (the baked DXT file if S3TC is supported, the image with CPU built
+// mips otherwise) and stage its levels in a ring of pixel unpack buffer memory. Update(), called once per frame on
+// the GL thread, turns staged levels into texture uploads from the buffer, at most BytesPerFrame a frame, so the
+// copy to video memory is done by the driver asynchronously and a burst of loads is spread over several frames.
+//
+// Levels are staged coarsest first and GL_TEXTURE_BASE_LEVEL follows the finest level present, so a texture shows
+// up blurry after its first few bytes and sharpens as the rest arrives. Until then it is incomplete (samples black).
+//
+// Ring memory is reused once the upload reading it is done, which a fence placed after every upload tells. With
+// ARB_buffer_storage the ring is persistently mapped and the workers copy into it themselves; without it the copy
+// happens in Update() through an unsynchronized mapping of the range (the fences make that safe as well).
+// Levels larger than the whole ring are uploaded from client memory.
+//
+// Load() with a maxSize, Stream() and Evict() keep only part of a chain resident; TextureResidency decides which.
+class TextureStreamer
+{
+public:
+    // What is resident of a streamed texture, kept on the GL thread
+    struct StreamedTexture {
+        GLint Width, Height, LevelCount;  // 0 until its first level arrived
+        GLint BaseLevel;                  // Finest level of the complete chain resident, LevelCount if none
+        GLint Floor;                      // Levels finer than this are dropped when they arrive (see Evict())
+        GLuint PresentLevels;             // Bit per level uploaded
+        GLenum InternalFormat, Format;
+        GLsizeiptr ResidentBytes;
+    };
+
+    GLsizeiptr RingSize;      // Bytes of staging memory
+    GLsizeiptr BytesPerFrame; // Upload budget of one Update(), at least one level is uploaded per frame
+    // Work done since the last PrintStats()
+    GLuint Uploads, Stalls;   // Stalls: levels that had to wait for ring space
+    GLsizeiptr UploadedBytes;
+    GLuint Frames;
+
+    // threadCount decoding threads, 0 uses all but one hardware thread
+    TextureStreamer(GLsizeiptr ringSize = 32 << 20, GLsizeiptr bytesPerFrame = 4 << 20, GLuint threadCount = 0)
+        : RingSize(ringSize), BytesPerFrame(bytesPerFrame), Uploads(0), Stalls(0), UploadedBytes(0), Frames(0),
+          PBO(0), mapped(NULL), firstRegion(0), head(0), requested(0), completed(0), failed(0), stopping(false), residentBytes(0)
+    {
+        this->compressed = BakedTexturesSupported(false) ? GL_TRUE : GL_FALSE;
+        this->compressedSRGB = BakedTexturesSupported(true) ? GL_TRUE : GL_FALSE;
+        glGenBuffers(1, &this->PBO);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->PBO);
+        if (GLEW_ARB_buffer_storage)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, this->RingSize, NULL, flags);
+            this->mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, this->RingSize, flags);
+        }
+        else
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, this->RingSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (threadCount == 0)
+            threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        for (GLuint i = 0; i < threadCount; i++)
+            this->workers.push_back(std::thread(&TextureStreamer::work, this));
+    }
+
+    ~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->requestAdded.notify_all();
+        this->spaceFreed.notify_all();
+        for (GLuint i = 0; i < this->workers.size(); i++)
+            this->workers[i].join();
+        for (GLuint i = 0; i < this->regions.size(); i++)
+            if (this->regions[i].Fence)
+                glDeleteSync(this->regions[i].Fence);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->PBO);
+        if (this->mapped)
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &this->PBO);
+    }
+
+    // Creates a texture and queues path to be streamed into it, sRGB if gamma is set. alpha loads RGBA,
+    // alphaCutoff is the alpha test threshold it's drawn with, if any (see MipBuilder). maxSize > 0 streams only the
+    // levels no larger than that, finer ones can follow with Stream(). Wrap modes are left to the caller.
+    GLuint Load(const std::string& path, bool gamma = false, GLboolean alpha = GL_FALSE, GLfloat alphaCutoff = 0.0f, GLint maxSize = 0)
+    {
+        GLuint textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        StreamedTexture info = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        this->textures[textureID] = info;
+        Request request = { textureID, path, gamma, alpha, alpha ? alphaCutoff : 0.0f, 0, -1, maxSize };
+        this->queue(request);
+        return textureID;
+    }
+
+    // Queues levels finestLevel to coarsestLevel (-1: the last) of a texture made by Load(), which has to be given
+    // the same file and settings
+    void Stream(GLuint texture, const std::string& path, bool gamma, GLboolean alpha, GLfloat alphaCutoff, GLint finestLevel, GLint coarsestLevel = -1)
+    {
+        StreamedTexture& info = this->textures[texture];
+        info.Floor = std::min(info.Floor, finestLevel);
+        Request request = { texture, path, gamma, alpha, alpha ? alphaCutoff : 0.0f, finestLevel, coarsestLevel, 0 };
+        this->queue(request);
+    }
+
+    // Frees the levels of texture finer than finestLevel; ones still on their way are dropped when they arrive
+    void Evict(GLuint texture, GLint finestLevel)
+    {
+        StreamedTexture& info = this->textures[texture];
+        info.Floor = finestLevel;
+        if (info.LevelCount == 0 || finestLevel <= 0)
+            return;
+        finestLevel = std::min(finestLevel, info.LevelCount - 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (info.BaseLevel < finestLevel)
+        {
+            info.BaseLevel = finestLevel;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, finestLevel);
+        }
+        // Redefining a level as empty lets the driver release its memory
+        for (GLint level = 0; level < finestLevel; level++)
+        {
+            if (!(info.PresentLevels & (1u << level)))
+                continue;
+            if (info.Format == 0)
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, info.InternalFormat, 0, 0, 0, 0, NULL);
+            else
+                glTexImage2D(GL_TEXTURE_2D, level, info.InternalFormat, 0, 0, 0, info.Format, GL_UNSIGNED_BYTE, NULL);
+            info.PresentLevels &= ~(1u << level);
+            info.ResidentBytes -= LevelBytes(info, level);
+            this->residentBytes -= LevelBytes(info, level);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Residency of a texture made by Load(), NULL for others
+    const StreamedTexture* Info(GLuint texture) const
+    {
+        std::map<GLuint, StreamedTexture>::const_iterator found = this->textures.find(texture);
+        return found != this->textures.end() ? &found->second : NULL;
+    }
+
+    // Video memory of one level (uncompressed texels count as 4 bytes, as drivers store RGB padded)
+    static GLsizeiptr LevelBytes(const StreamedTexture& info, GLint level)
+    {
+        GLint width = std::max(info.Width >> level, 1), height = std::max(info.Height >> level, 1);
+        if (info.Format != 0)
+            return (GLsizeiptr)width * height * 4;
+        GLboolean dxt5 = info.InternalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || info.InternalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        return DXTCompressor::CompressedSize(width, height, dxt5);
+    }
+
+    // Video memory of all levels resident
+    GLsizeiptr ResidentBytes() const { return this->residentBytes; }
+
+    // Recycles ring memory of finished uploads and uploads staged levels within the frame's budget
+    void Update()
+    {
+        this->Frames++;
+        this->retire();
+        GLsizeiptr budget = this->BytesPerFrame;
+        bool first = true;
+        while (first || budget > 0)
+        {
+            Upload upload;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (this->staged.empty())
+                    break;
+                Upload& next = this->staged.front();
+                // Without a persistent mapping the copy into the ring happens here, if there is room
+                if (!this->mapped && next.Region < 0 && next.Size <= this->RingSize && !this->allocate(next.Size, next.Region))
+                {
+                    this->Stalls++;
+                    break;
+                }
+                upload = std::move(next);
+                this->staged.pop_front();
+            }
+            this->upload(upload);
+            budget -= upload.Size;
+            first = false;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // Textures requested that aren't completely uploaded yet
+    GLuint Pending()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->requested - this->completed - this->failed;
+    }
+
+    // Prints the average work per frame since the last call
+    void PrintStats()
+    {
+        GLfloat frames = this->Frames > 0 ? (GLfloat)this->Frames : 1.0f;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        GLsizeiptr used = this->usedBytes();
+        std::cout << "Texture streaming: " << this->requested - this->completed - this->failed << " requests pending, "
+                  << this->residentBytes / (1024.0f * 1024.0f) << " MB resident, " << this->Uploads / frames << " uploads, "
+                  << this->UploadedBytes / frames / 1024.0f << " KB per frame, " << this->Stalls << " stalls, ring "
+                  << 100.0f * used / this->RingSize << "% used (" << (this->mapped ? "persistent" : "mapped per upload") << ")" << std::endl;
+        this->Uploads = this->Stalls = 0;
+        this->UploadedBytes = 0;
+        this->Frames = 0;
+    }
+
+private:
+    struct Request {
+        GLuint Texture;
+        std::string Path;
+        bool Gamma;
+        GLboolean Alpha;
+        GLfloat AlphaCutoff;
+        GLint FinestLevel, CoarsestLevel, MaxSize;
+    };
+    // One mip level ready to go to its texture
+    struct Upload {
+        GLuint Texture;
+        GLint Level, LevelCount, Width, Height, BaseWidth, BaseHeight;
+        GLenum InternalFormat, Format; // Format is 0 for compressed data
+        GLboolean Last;                // Finest level of its request
+        GLsizeiptr Size;
+        GLint Region;                  // Index in regions of its ring memory, -1 if not staged (yet)
+        std::vector<unsigned char> Pixels; // The data while not in the ring
+    };
+    // Ring memory in use, in allocation order
+    struct Region {
+        GLsizeiptr Offset, Size;
+        GLsync Fence; // Placed after the upload reading it, 0 until then
+        GLboolean Done;
+    };
+
+    GLuint PBO;
+    unsigned char* mapped;
+    GLboolean compressed, compressedSRGB; // Baked DXT uploads are supported, for linear and sRGB textures
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable requestAdded, spaceFreed, bakeFinished;
+    std::set<std::string> baking; // Baked files a worker is writing or reading, one worker per file at a time
+    std::deque<Request> requests;
+    std::deque<Upload> staged;
+    std::deque<Region> regions;
+    GLint firstRegion;  // Region index of regions.front(), indices keep counting up as the front is retired
+    GLsizeiptr head;    // Offset of the next allocation
+    GLuint requested, completed, failed;
+    bool stopping;
+    std::map<GLuint, StreamedTexture> textures; // GL thread only
+    GLsizeiptr residentBytes;
+
+    void queue(const Request& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->requests.push_back(request);
+            this->requested++;
+        }
+        this->requestAdded.notify_one();
+    }
+
+    GLsizeiptr usedBytes() const
+    {
+        if (this->regions.empty())
+            return 0;
+        GLsizeiptr tail = this->regions.front().Offset;
+        return this->head > tail ? this->head - tail : this->RingSize - tail + this->head;
+    }
+
+    // Reserves size bytes at the head of the ring, wrapping to the start if the end is too short. Needs the lock.
+    bool allocate(GLsizeiptr size, GLint& region)
+    {
+        size = (size + 255) & ~(GLsizeiptr)255; // Keeps every level's start aligned for the copies
+        GLsizeiptr offset = this->head;
+        if (this->regions.empty())
+            offset = 0;
+        else
+        {
+            GLsizeiptr tail = this->regions.front().Offset;
+            if (this->head > tail)
+            {
+                // Free: [head, RingSize) and [0, tail)
+                if (this->head + size > this->RingSize)
+                {
+                    if (size > tail)
+                        return false;
+                    offset = 0;
+                }
+            }
+            else if (this->head + size > tail) // Wrapped, free is [head, tail)
+                return false;
+        }
+        if (this->regions.empty())
+            this->firstRegion = 0;
+        Region allocation = { offset, size, 0, GL_FALSE };
+        this->regions.push_back(allocation);
+        region = this->firstRegion + (GLint)this->regions.size() - 1;
+        this->head = offset + size;
+        if (this->head == this->RingSize)
+            this->head = 0;
+        return true;
+    }
+
+    // Frees the ring memory at the front whose uploads the GPU has finished
+    void retire()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        bool freed = false;
+        while (!this->regions.empty() && this->regions.front().Done)
+        {
+            GLenum status = glClientWaitSync(this->regions.front().Fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(this->regions.front().Fence);
+            this->regions.pop_front();
+            this->firstRegion++;
+            freed = true;
+        }
+        if (freed)
+            this->spaceFreed.notify_all();
+    }
+
+    void upload(Upload& upload)
+    {
+        StreamedTexture& info = this->textures[upload.Texture];
+        bool dropped = upload.Level < info.Floor; // Evicted while on its way
+        const GLvoid* data = upload.Pixels.empty() ? NULL : &upload.Pixels[0];
+        Region* region = NULL;
+        if (upload.Region >= 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                region = &this->regions[upload.Region - this->firstRegion];
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->PBO);
+            if (!this->mapped && !dropped)
+            {
+                // Unsynchronized: nothing in flight reads this range any more, its fence was checked before reuse
+                void* memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, region->Offset, upload.Size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                if (memory)
+                    memcpy(memory, data, upload.Size);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            data = (const GLvoid*)region->Offset;
+        }
+        else
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (!dropped)
+        {
+            glBindTexture(GL_TEXTURE_2D, upload.Texture);
+            if (info.LevelCount == 0)
+            {
+                info.Width = upload.BaseWidth;
+                info.Height = upload.BaseHeight;
+                info.LevelCount = info.BaseLevel = upload.LevelCount;
+                info.InternalFormat = upload.InternalFormat;
+                info.Format = upload.Format;
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, upload.LevelCount - 1);
+            }
+            if (upload.Format == 0)
+                glCompressedTexImage2D(GL_TEXTURE_2D, upload.Level, upload.InternalFormat, upload.Width, upload.Height, 0, upload.Size, data);
+            else
+            {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glTexImage2D(GL_TEXTURE_2D, upload.Level, upload.InternalFormat, upload.Width, upload.Height, 0, upload.Format, GL_UNSIGNED_BYTE, data);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+            if (!(info.PresentLevels & (1u << upload.Level)))
+            {
+                info.PresentLevels |= 1u << upload.Level;
+                info.ResidentBytes += LevelBytes(info, upload.Level);
+                this->residentBytes += LevelBytes(info, upload.Level);
+            }
+            // Sample only the complete part of the chain, from the coarsest level down to the first one missing
+            GLint base = info.BaseLevel;
+            while (base > 0 && (info.PresentLevels & (1u << (base - 1))))
+                base--;
+            if (base != info.BaseLevel)
+            {
+                info.BaseLevel = base;
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base);
+            }
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (region)
+        {
+            region->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            region->Done = GL_TRUE;
+        }
+        if (upload.Last)
+            this->completed++;
+        if (!dropped)
+        {
+            this->Uploads++;
+            this->UploadedBytes += upload.Size;
+        }
+    }
+
+    // Decodes a request into the uploads of its levels, coarsest first; false if the file can't be loaded
+    bool decode(const Request& request, std::vector<Upload>& uploads)
+    {
+        std::vector<MipLevel> levels;
+        GLenum internalFormat, format = 0;
+        GLboolean dxt5 = GL_FALSE;
+        bool loaded = false;
+        if (request.Gamma ? this->compressedSRGB : this->compressed)
+        {
+            MipBuilder mips(MIP_FILTER_KAISER, request.Gamma, request.AlphaCutoff);
+            std::string baked = BakedTexturePath(request.Path);
+            // The same file requested twice is baked once: the second worker waits and then finds it up to date
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                while (this->baking.count(baked))
+                    this->bakeFinished.wait(lock);
+                this->baking.insert(baked);
+            }
+            if (BakedTextureUpToDate(request.Path, BakeParameters(mips, request.Alpha)) || BakeTexture(request.Path, baked, request.Alpha, mips))
+                loaded = ReadBakedTexture(baked, dxt5, levels);
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->baking.erase(baked);
+            }
+            this->bakeFinished.notify_all();
+            internalFormat = BakedTextureFormat(dxt5, request.Gamma);
+        }
+        if (!loaded)
+        {
+            GLint width, height, channels = request.Alpha ? 4 : 3;
+            unsigned char* image = LoadImageMapped(request.Path, &width, &height, 0, request.Alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+            if (!image)
+                return false;
+            MipBuilder(MIP_FILTER_BOX, request.Gamma, request.AlphaCutoff, 1).Build(image, width, height, channels, levels);
+            SOIL_free_image_data(image);
+            format = request.Alpha ? GL_RGBA : GL_RGB;
+            if (request.Gamma)
+                internalFormat = request.Alpha ? GL_SRGB_ALPHA : GL_SRGB;
+            else
+                internalFormat = format;
+        }
+        // The requested range, never empty
+        GLint coarsest = request.CoarsestLevel < 0 ? (GLint)levels.size() - 1 : std::min(request.CoarsestLevel, (GLint)levels.size() - 1);
+        GLint finest = std::min(request.FinestLevel, coarsest);
+        while (request.MaxSize > 0 && finest < coarsest && std::max(levels[finest].Width, levels[finest].Height) > request.MaxSize)
+            finest++;
+        for (GLint level = coarsest; level >= finest; level--)
+        {
+            Upload upload;
+            upload.Texture = request.Texture;
+            upload.Level = level;
+            upload.LevelCount = levels.size();
+            upload.Width = levels[level].Width;
+            upload.Height = levels[level].Height;
+            upload.BaseWidth = levels[0].Width;
+            upload.BaseHeight = levels[0].Height;
+            upload.Last = level == finest;
+            upload.InternalFormat = internalFormat;
+            upload.Format = format;
+            upload.Size = levels[level].Pixels.size();
+            upload.Region = -1;
+            upload.Pixels.swap(levels[level].Pixels);
+            uploads.push_back(std::move(upload));
+        }
+        return true;
+    }
+
+    // Worker thread: decodes requests and stages their levels
+    void work()
+    {
+        while (true)
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                while (!this->stopping && this->requests.empty())
+                    this->requestAdded.wait(lock);
+                if (this->stopping)
+                    return;
+                request = this->requests.front();
+                this->requests.pop_front();
+            }
+            std::vector<Upload> uploads;
+            if (!this->decode(request, uploads))
+            {
+                std::cout << "ERROR::TEXTURE_STREAMER:: Failed to load " << request.Path << std::endl;
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->failed++;
+                continue;
+            }
+            for (GLuint i = 0; i < uploads.size(); i++)
+            {
+                Upload& upload = uploads[i];
+                if (this->mapped && upload.Size <= this->RingSize)
+                {
+                    // Copy into the persistently mapped ring as soon as the GPU is done with enough of it
+                    unsigned char* memory;
+                    {
+                        std::unique_lock<std::mutex> lock(this->mutex);
+                        if (!this->allocate(upload.Size, upload.Region))
+                        {
+                            this->Stalls++;
+                            while (!this->stopping && !this->allocate(upload.Size, upload.Region))
+                                this->spaceFreed.wait(lock);
+                        }
+                        if (this->stopping)
+                            return;
+                        memory = this->mapped + this->regions[upload.Region - this->firstRegion].Offset;
+                    }
+                    memcpy(memory, &upload.Pixels[0], upload.Size);
+                    std::vector<unsigned char>().swap(upload.Pixels);
+                }
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->staged.push_back(std::move(upload));
+            }
+        }
+    }
+};
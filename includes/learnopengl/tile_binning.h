@@ -0,0 +1,294 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILE_BINNING_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Screen space light binning for tiled deferred shading, entirely on the CPU so it doesn't need a GL context.
+// The screen is cut into TileSize x TileSize pixel tiles; every tile is a small frustum bounded by its four side
+// planes and the closest and farthest surface in it (from the depth buffer). A light goes into a tile's list when its
+// sphere of influence lies on the inner side of all six planes.
+//
+// The side planes pass through the camera, so the top and bottom plane are the same for a whole row of tiles. Bin()
+// first reduces the lights to the ones touching a row, then tests those against each tile's left/right planes and
+// depth range, four lights at a time with SSE. Rows are split over ThreadCount threads; each thread keeps its lists
+// in its own buffer and they are concatenated in row order afterwards.
+class TileBinner
+{
+public:
+    GLuint TileSize;
+    GLuint TilesX, TilesY;
+    GLuint ThreadCount;
+    GLboolean UseSIMD;  // Falls back to the scalar kernel when false or when SSE2 isn't available
+    // Result of the last Bin(): (first index, light count) per tile, row by row from the bottom of the screen,
+    // and the light indices of all tiles back to back
+    std::vector<GLuint> Grid;
+    std::vector<GLushort> Indices;
+    GLuint MaxTileLights;
+
+    TileBinner(GLuint screenWidth, GLuint screenHeight, GLuint tileSize = 16, GLuint threadCount = 0)
+        : TileSize(tileSize), TilesX((screenWidth + tileSize - 1) / tileSize), TilesY((screenHeight + tileSize - 1) / tileSize),
+          ThreadCount(threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())), UseSIMD(GL_TRUE),
+          MaxTileLights(0), screenSize(screenWidth, screenHeight)
+    {
+        this->Grid.resize(this->TilesX * this->TilesY * 2);
+        this->columnPlanes.resize(this->TilesX * 4);
+        this->rowPlanes.resize(this->TilesY * 4);
+    }
+
+    // Rebuilds the tile planes, needed whenever the projection changes
+    void SetProjection(const glm::mat4& projection)
+    {
+        // A view space point p is right of the NDC line x = x0 when clip.x >= x0 * clip.w, with clip.w = -p.z:
+        // p.x * P[0][0] + p.z * (P[2][0] + x0) >= 0. That's a plane through the origin, normalized so that the
+        // dot product is the signed distance. Likewise for the other sides and y.
+        for (GLuint x = 0; x < this->TilesX; x++)
+        {
+            GLfloat x0 = this->toNDC(x * this->TileSize, this->screenSize.x);
+            GLfloat x1 = this->toNDC(std::min((x + 1) * this->TileSize, (GLuint)this->screenSize.x), this->screenSize.x);
+            glm::vec2 left = glm::normalize(glm::vec2(projection[0][0], projection[2][0] + x0));
+            glm::vec2 right = glm::normalize(glm::vec2(-projection[0][0], -projection[2][0] - x1));
+            GLfloat* planes = &this->columnPlanes[x * 4];
+            planes[0] = left.x; planes[1] = left.y; planes[2] = right.x; planes[3] = right.y;
+        }
+        for (GLuint y = 0; y < this->TilesY; y++)
+        {
+            GLfloat y0 = this->toNDC(y * this->TileSize, this->screenSize.y);
+            GLfloat y1 = this->toNDC(std::min((y + 1) * this->TileSize, (GLuint)this->screenSize.y), this->screenSize.y);
+            glm::vec2 bottom = glm::normalize(glm::vec2(projection[1][1], projection[2][1] + y0));
+            glm::vec2 top = glm::normalize(glm::vec2(-projection[1][1], -projection[2][1] - y1));
+            GLfloat* planes = &this->rowPlanes[y * 4];
+            planes[0] = bottom.x; planes[1] = bottom.y; planes[2] = top.x; planes[3] = top.y;
+        }
+    }
+
+    // Bins the lights, given as view space (center, radius), into the tiles. depthBounds holds the view space distance
+    // of the closest and farthest surface of every tile, in the order of Grid; tiles without geometry have min > max.
+    // At most 65536 lights are binned.
+    void Bin(const std::vector<glm::vec4>& lights, const GLfloat* depthBounds)
+    {
+        // Transpose to structure of arrays, padded to a multiple of 4 with lights that never pass
+        GLuint lightCount = std::min((GLuint)lights.size(), 65536u);
+        GLuint paddedCount = (lightCount + 3) & ~3u;
+        if (paddedCount == 0)
+        {
+            std::fill(this->Grid.begin(), this->Grid.end(), 0);
+            this->Indices.resize(1);
+            this->MaxTileLights = 0;
+            return;
+        }
+        this->lightData.resize(paddedCount * 4);
+        GLfloat* centerX = &this->lightData[0];
+        GLfloat* centerY = centerX + paddedCount;
+        GLfloat* centerZ = centerY + paddedCount;
+        GLfloat* radius = centerZ + paddedCount;
+        for (GLuint i = 0; i < paddedCount; i++)
+        {
+            glm::vec4 light = i < lightCount ? lights[i] : glm::vec4(0.0f, 0.0f, 0.0f, -1e30f);
+            centerX[i] = light.x; centerY[i] = light.y; centerZ[i] = light.z; radius[i] = light.w;
+        }
+
+        GLuint threadCount = std::min(this->ThreadCount, this->TilesY);
+        this->workers.resize(threadCount);
+        std::vector<std::thread> threads;
+        for (GLuint t = 1; t < threadCount; t++)
+            threads.push_back(std::thread(&TileBinner::binRows, this, t, threadCount, paddedCount, depthBounds));
+        this->binRows(0, threadCount, paddedCount, depthBounds);
+        for (GLuint t = 0; t < threads.size(); t++)
+            threads[t].join();
+
+        // The threads own consecutive rows, so their lists concatenate in tile order
+        GLuint offset = 0;
+        this->MaxTileLights = 0;
+        for (GLuint tile = 0; tile < this->TilesX * this->TilesY; tile++)
+        {
+            this->Grid[tile * 2] = offset;
+            offset += this->Grid[tile * 2 + 1];
+            this->MaxTileLights = std::max(this->MaxTileLights, this->Grid[tile * 2 + 1]);
+        }
+        this->Indices.resize(offset > 0 ? offset : 1);
+        offset = 0;
+        for (GLuint t = 0; t < threadCount; t++)
+        {
+            const std::vector<GLushort>& indices = this->workers[t].Indices;
+            if (!indices.empty())
+                memcpy(&this->Indices[offset], &indices[0], indices.size() * sizeof(GLushort));
+            offset += indices.size();
+        }
+    }
+
+    // Number of light indices of the last Bin(), summed over all tiles
+    GLuint IndexCount() const
+    {
+        return this->TilesX * this->TilesY > 0 ? this->Grid[this->Grid.size() - 2] + this->Grid[this->Grid.size() - 1] : 0;
+    }
+
+private:
+    // Per thread scratch: the lights touching the current row and the thread's light lists
+    struct Worker
+    {
+        std::vector<GLfloat> Candidates; // x, y, z, radius arrays of CandidateCapacity each
+        std::vector<GLushort> CandidateIndices;
+        std::vector<GLushort> Indices;
+    };
+
+    glm::vec2 screenSize;
+    std::vector<GLfloat> columnPlanes; // Per tile column (left.x, left.z, right.x, right.z)
+    std::vector<GLfloat> rowPlanes;    // Per tile row (bottom.y, bottom.z, top.y, top.z)
+    std::vector<GLfloat> lightData;    // x, y, z, radius arrays of the padded light count each
+    std::vector<Worker> workers;
+
+    static GLfloat toNDC(GLuint pixel, GLfloat size)
+    {
+        return pixel / size * 2.0f - 1.0f;
+    }
+
+    void binRows(GLuint thread, GLuint threadCount, GLuint lightCount, const GLfloat* depthBounds)
+    {
+        Worker& worker = this->workers[thread];
+        worker.Indices.clear();
+        worker.Candidates.resize(lightCount * 4);
+        worker.CandidateIndices.resize(lightCount);
+        const GLfloat* lights = &this->lightData[0];
+        GLuint firstRow = this->TilesY * thread / threadCount;
+        GLuint lastRow = this->TilesY * (thread + 1) / threadCount;
+        for (GLuint y = firstRow; y < lastRow; y++)
+        {
+            const GLfloat* rowPlanes = &this->rowPlanes[y * 4];
+            GLuint tileOffset = y * this->TilesX;
+            // Depth range of the whole row, lights outside it can be skipped for all its tiles
+            GLfloat rowMin = 1e30f, rowMax = -1e30f;
+            for (GLuint x = 0; x < this->TilesX; x++)
+            {
+                rowMin = std::min(rowMin, depthBounds[(tileOffset + x) * 2]);
+                rowMax = std::max(rowMax, depthBounds[(tileOffset + x) * 2 + 1]);
+            }
+            GLuint candidates = rowMin <= rowMax ? this->gatherRow(worker, lights, lightCount, rowPlanes, rowMin, rowMax) : 0;
+            for (GLuint x = 0; x < this->TilesX; x++)
+            {
+                GLuint tile = tileOffset + x;
+                GLuint before = worker.Indices.size();
+                if (candidates > 0 && depthBounds[tile * 2] <= depthBounds[tile * 2 + 1])
+                    this->binTile(worker, candidates, &this->columnPlanes[x * 4], depthBounds[tile * 2], depthBounds[tile * 2 + 1]);
+                this->Grid[tile * 2 + 1] = worker.Indices.size() - before;
+            }
+        }
+    }
+
+    // Copies the lights touching the row's slab (between its bottom and top plane and inside its depth range)
+    // to the worker's candidate arrays, padded to a multiple of 4. Returns the padded candidate count.
+    GLuint gatherRow(Worker& worker, const GLfloat* lights, GLuint lightCount, const GLfloat* planes, GLfloat minDepth, GLfloat maxDepth)
+    {
+        const GLfloat* centerY = lights + lightCount;
+        const GLfloat* centerZ = lights + lightCount * 2;
+        const GLfloat* radius = lights + lightCount * 3;
+        GLuint count = 0;
+#ifdef TILE_BINNING_SSE
+        if (this->UseSIMD)
+        {
+            __m128 bottomY = _mm_set1_ps(planes[0]), bottomZ = _mm_set1_ps(planes[1]);
+            __m128 topY = _mm_set1_ps(planes[2]), topZ = _mm_set1_ps(planes[3]);
+            __m128 nearDepth = _mm_set1_ps(-minDepth), farDepth = _mm_set1_ps(-maxDepth);
+            for (GLuint i = 0; i < lightCount; i += 4)
+            {
+                __m128 y = _mm_loadu_ps(centerY + i), z = _mm_loadu_ps(centerZ + i), r = _mm_loadu_ps(radius + i);
+                __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(bottomY, y), _mm_mul_ps(bottomZ, z)), negR);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(topY, y), _mm_mul_ps(topZ, z)), negR));
+                // View space z is negative in front of the camera: z - r <= -minDepth and z + r >= -maxDepth
+                inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(z, r), nearDepth));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(z, r), farDepth));
+                GLint mask = _mm_movemask_ps(inside);
+                while (mask)
+                {
+                    GLuint lane = this->lowestBit(mask);
+                    this->addCandidate(worker, lights, lightCount, i + lane, count++);
+                    mask &= mask - 1;
+                }
+            }
+        }
+        else
+#endif
+        {
+            for (GLuint i = 0; i < lightCount; i++)
+            {
+                GLfloat y = centerY[i], z = centerZ[i], r = radius[i];
+                if (planes[0] * y + planes[1] * z >= -r && planes[2] * y + planes[3] * z >= -r && z - r <= -minDepth && z + r >= -maxDepth)
+                    this->addCandidate(worker, lights, lightCount, i, count++);
+            }
+        }
+        GLuint padded = (count + 3) & ~3u;
+        GLuint capacity = lightCount;
+        for (GLuint i = count; i < padded; i++)
+        {
+            worker.Candidates[i] = worker.Candidates[capacity + i] = worker.Candidates[capacity * 2 + i] = 0.0f;
+            worker.Candidates[capacity * 3 + i] = -1e30f;
+        }
+        return padded;
+    }
+
+    void addCandidate(Worker& worker, const GLfloat* lights, GLuint lightCount, GLuint light, GLuint slot)
+    {
+        for (GLuint c = 0; c < 4; c++)
+            worker.Candidates[lightCount * c + slot] = lights[lightCount * c + light];
+        worker.CandidateIndices[slot] = (GLushort)light;
+    }
+
+    // Tests the row's candidates against one tile's left and right planes and its depth range
+    void binTile(Worker& worker, GLuint candidateCount, const GLfloat* planes, GLfloat minDepth, GLfloat maxDepth)
+    {
+        GLuint capacity = worker.CandidateIndices.size();
+        const GLfloat* centerX = &worker.Candidates[0];
+        const GLfloat* centerZ = centerX + capacity * 2;
+        const GLfloat* radius = centerX + capacity * 3;
+#ifdef TILE_BINNING_SSE
+        if (this->UseSIMD)
+        {
+            __m128 leftX = _mm_set1_ps(planes[0]), leftZ = _mm_set1_ps(planes[1]);
+            __m128 rightX = _mm_set1_ps(planes[2]), rightZ = _mm_set1_ps(planes[3]);
+            __m128 nearDepth = _mm_set1_ps(-minDepth), farDepth = _mm_set1_ps(-maxDepth);
+            for (GLuint i = 0; i < candidateCount; i += 4)
+            {
+                __m128 x = _mm_loadu_ps(centerX + i), z = _mm_loadu_ps(centerZ + i), r = _mm_loadu_ps(radius + i);
+                __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(leftX, x), _mm_mul_ps(leftZ, z)), negR);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(rightX, x), _mm_mul_ps(rightZ, z)), negR));
+                inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(z, r), nearDepth));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(z, r), farDepth));
+                GLint mask = _mm_movemask_ps(inside);
+                while (mask)
+                {
+                    worker.Indices.push_back(worker.CandidateIndices[i + this->lowestBit(mask)]);
+                    mask &= mask - 1;
+                }
+            }
+            return;
+        }
+#endif
+        for (GLuint i = 0; i < candidateCount; i++)
+        {
+            GLfloat x = centerX[i], z = centerZ[i], r = radius[i];
+            if (planes[0] * x + planes[1] * z >= -r && planes[2] * x + planes[3] * z >= -r && z - r <= -minDepth && z + r >= -maxDepth)
+                worker.Indices.push_back(worker.CandidateIndices[i]);
+        }
+    }
+
+    static GLuint lowestBit(GLint mask)
+    {
+        // 4 bit masks only
+        static const GLubyte lowest[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+        return lowest[mask & 15];
+    }
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+// Std. Includes
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/screen_quad.h>
+#include <learnopengl/tile_binning.h>
+
+// Tiled deferred shading with the light culling on the CPU, which works on OpenGL 3.3 without compute shaders.
+// After the geometry pass the G-buffer depth is reduced to the closest and farthest surface of every
+// TileSize x TileSize tile (shaders/tile_depth_bounds.frag) and read back, the lights are binned against those tiles
+// by a TileBinner and the lists are uploaded through buffer textures. A single full-screen pass
+// (shaders/deferred_tiled.frag) then shades every pixel with the lights of its tile, reading the G-buffer once
+// instead of once per light volume.
+//
+// The readback is synchronous and so waits for the geometry pass; the reduced buffer is small (3600 texels at 720p),
+// but the wait is part of ReadbackMs. Buffer textures as in ClusteredLights:
+//   - tileLights:       two RGBA32F texels per light, (view space position, radius) and (color, 0)
+//   - tileGrid:         one RG32UI texel per tile, (first index, light count)
+//   - tileLightIndices: R16UI light indices, the lists of all tiles back to back
+class TiledLights
+{
+public:
+    TileBinner Binner;
+    GLuint LightCount;
+    // CPU time of the last Update() in milliseconds
+    GLdouble ReadbackMs, BinningMs;
+
+    TiledLights(GLuint screenWidth, GLuint screenHeight, GLuint tileSize = 16, GLuint threadCount = 0)
+        : Binner(screenWidth, screenHeight, tileSize, threadCount), LightCount(0), ReadbackMs(0.0), BinningMs(0.0),
+          depthBoundsShader("shaders/bloom_final.vs", "shaders/tile_depth_bounds.frag")
+    {
+        this->depthBounds.resize(this->Binner.TilesX * this->Binner.TilesY * 2);
+
+        glGenFramebuffers(1, &this->depthBoundsFBO);
+        glGenTextures(1, &this->depthBoundsTexture);
+        glBindTexture(GL_TEXTURE_2D, this->depthBoundsTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, this->Binner.TilesX, this->Binner.TilesY, 0, GL_RG, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->depthBoundsFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->depthBoundsTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::TILEDLIGHTS:: Depth bounds framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glGenBuffers(3, this->buffers);
+        glGenTextures(3, this->textures);
+        GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], this->buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        this->depthBoundsShader.Use();
+        glUniform1i(glGetUniformLocation(this->depthBoundsShader.Program, "gDepth"), 0);
+        glUniform1i(glGetUniformLocation(this->depthBoundsShader.Program, "tileSize"), this->Binner.TileSize);
+        glUseProgram(0);
+    }
+
+    ~TiledLights()
+    {
+        glDeleteFramebuffers(1, &this->depthBoundsFBO);
+        glDeleteTextures(1, &this->depthBoundsTexture);
+        glDeleteTextures(3, this->textures);
+        glDeleteBuffers(3, this->buffers);
+    }
+
+    // Reduces depthTexture (the G-buffer depth of the frame rendered with view and projection) to per tile depth
+    // bounds, bins the lights against them and uploads the lists. Leaves the default framebuffer bound.
+    void Update(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& colors, const std::vector<GLfloat>& radii,
+                const glm::mat4& view, const glm::mat4& projection, GLuint depthTexture, GLfloat nearPlane, GLfloat farPlane)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        glBindFramebuffer(GL_FRAMEBUFFER, this->depthBoundsFBO);
+        glViewport(0, 0, this->Binner.TilesX, this->Binner.TilesY);
+        glDisable(GL_DEPTH_TEST);
+        this->depthBoundsShader.Use();
+        glUniform1f(glGetUniformLocation(this->depthBoundsShader.Program, "nearPlane"), nearPlane);
+        glUniform1f(glGetUniformLocation(this->depthBoundsShader.Program, "farPlane"), farPlane);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        RenderScreenQuad();
+        glReadPixels(0, 0, this->Binner.TilesX, this->Binner.TilesY, GL_RG, GL_FLOAT, &this->depthBounds[0]);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glEnable(GL_DEPTH_TEST);
+        std::chrono::high_resolution_clock::time_point readback = std::chrono::high_resolution_clock::now();
+
+        if (projection != this->cachedProjection)
+        {
+            this->Binner.SetProjection(projection);
+            this->cachedProjection = projection;
+        }
+        this->LightCount = std::min((GLuint)positions.size(), 65536u);
+        this->viewLights.resize(this->LightCount);
+        this->lightData.resize(this->LightCount * 2);
+        for (GLuint l = 0; l < this->LightCount; l++)
+        {
+            this->viewLights[l] = glm::vec4(glm::vec3(view * glm::vec4(positions[l], 1.0f)), radii[l]);
+            this->lightData[l * 2] = this->viewLights[l];
+            this->lightData[l * 2 + 1] = glm::vec4(colors[l], 0.0f);
+        }
+        this->Binner.Bin(this->viewLights, &this->depthBounds[0]);
+        std::chrono::high_resolution_clock::time_point binned = std::chrono::high_resolution_clock::now();
+
+        this->upload(0, this->lightData.size() * sizeof(glm::vec4), this->lightData.empty() ? NULL : &this->lightData[0]);
+        this->upload(1, this->Binner.Grid.size() * sizeof(GLuint), &this->Binner.Grid[0]);
+        this->upload(2, this->Binner.Indices.size() * sizeof(GLushort), &this->Binner.Indices[0]);
+
+        this->ReadbackMs = std::chrono::duration<GLdouble, std::milli>(readback - start).count();
+        this->BinningMs = std::chrono::duration<GLdouble, std::milli>(binned - readback).count();
+    }
+
+    // Binds the buffer textures to textureUnit, textureUnit + 1 and textureUnit + 2 and sets the tile uniforms
+    void SetUniforms(Shader& shader, GLuint textureUnit)
+    {
+        const GLchar* names[] = { "tileLights", "tileGrid", "tileLightIndices" };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + textureUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glUniform1i(glGetUniformLocation(shader.Program, names[i]), textureUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(shader.Program, "tileSize"), this->Binner.TileSize);
+        glUniform1i(glGetUniformLocation(shader.Program, "tilesX"), this->Binner.TilesX);
+    }
+
+    void PrintStats() const
+    {
+        GLuint tiles = this->Binner.TilesX * this->Binner.TilesY;
+        std::cout << "Tiled lights: " << this->LightCount << " lights in " << this->Binner.TilesX << "x" << this->Binner.TilesY
+                  << " tiles, " << this->Binner.IndexCount() / (GLfloat)tiles << " per tile on average, " << this->Binner.MaxTileLights
+                  << " at most; depth readback " << this->ReadbackMs << " ms, binning " << this->BinningMs << " ms on "
+                  << this->Binner.ThreadCount << " threads" << std::endl;
+    }
+
+private:
+    Shader depthBoundsShader;
+    GLuint depthBoundsFBO;
+    GLuint depthBoundsTexture;
+    GLuint buffers[3];
+    GLuint textures[3];
+    glm::mat4 cachedProjection;
+    std::vector<GLfloat> depthBounds;
+    std::vector<glm::vec4> viewLights;
+    std::vector<glm::vec4> lightData;
+
+    // Orphans the buffer and refills it, so the driver doesn't wait for last frame's draws still reading it
+    void upload(GLuint buffer, GLsizeiptr size, const GLvoid* data)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, size > 0 ? size : 16, NULL, GL_STREAM_DRAW);
+        if (size > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
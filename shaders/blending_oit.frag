@@ -0,0 +1,63 @@
+#version 330 core
+layout (location = 0) out vec4 AccumColor;
+layout (location = 1) out float AccumWeight;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+} fs_in;
+
+uniform sampler2D texture1;
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform bool unlit; // Plain texture color without lighting and fog, for blending_sorted's windows
+
+const vec3 fogColor = vec3(0.5, 0.5,0.5);
+const float FogDensity = 0.10;
+
+// Depth weight of McGuire & Bavoil (eq. 10): closer and more opaque fragments dominate the average
+float OitWeight(float alpha)
+{
+    float depthWeight = pow(1.0 - gl_FragCoord.z * 0.9, 3.0);
+    return clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * depthWeight, 1e-2, 3e3);
+}
+
+void main()
+{
+    vec4 texColor = texture(texture1, fs_in.TexCoords);
+    // Fully transparent texels contribute nothing, skip the blending bandwidth
+    if(texColor.a < 0.01)
+        discard;
+
+    vec3 result = texColor.rgb;
+    if(!unlit)
+    {
+        vec3 color = texColor.rgb;
+        vec3 normal = normalize(fs_in.Normal);
+        vec3 lightColor = vec3(1.0);
+        // Ambient
+        vec3 ambient = 0.3 * color;
+        // Diffuse
+        vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+        float diff = max(dot(lightDir, normal), 0.0);
+        vec3 diffuse = diff * lightColor;
+        // Specular
+        vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+        vec3 specular = spec * lightColor;
+        vec3 lighting = (ambient + diffuse + specular) * color;
+
+        float dist = gl_FragCoord.z / gl_FragCoord.w;
+        float fogFactor = 1.0 /exp( (dist * FogDensity)* (dist * FogDensity));
+        fogFactor = clamp( fogFactor, 0.0, 1.0 );
+        result = mix(fogColor, lighting, fogFactor);
+    }
+
+    float w = OitWeight(texColor.a);
+    AccumColor = vec4(result * texColor.a * w, texColor.a);
+    AccumWeight = texColor.a * w;
+}
@@ -8,14 +8,44 @@ in VS_OUT {
     vec2 TexCoords;
 } fs_in;
 
-struct Light {
-    vec3 Position;
-    vec3 Color;
-};
-
-uniform Light lights[4];
 uniform sampler2D diffuseTexture;
 uniform vec3 viewPos;
+uniform mat4 view;
+
+// Point lights sorted into view frustum clusters, see includes/learnopengl/clustered_lights.h
+uniform samplerBuffer clusterLights;        // (position, radius), (color, 0) per light
+uniform usamplerBuffer clusterGrid;         // (first index, light count) per cluster
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterDims;
+uniform float clusterTileSize;
+uniform vec2 clusterDepthParams;            // slice = log(depth) * x - y
+
+vec3 ClusteredLighting(vec3 color, vec3 normal)
+{
+    // Find the fragment's cluster from its pixel and view space depth
+    float depth = -(view * vec4(fs_in.FragPos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize), int(log(max(depth, 1e-4)) * clusterDepthParams.x - clusterDepthParams.y));
+    cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+    uvec2 range = texelFetch(clusterGrid, (cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x).xy;
+
+    vec3 lighting = vec3(0.0);
+    for(uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 lightColor = texelFetch(clusterLights, light * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - fs_in.FragPos;
+        float distance = length(toLight);
+        if(distance > positionRadius.w)
+            continue;
+        // Diffuse
+        float diff = max(dot(toLight / distance, normal), 0.0);
+        // Attenuation (use quadratic as we have gamma correction), windowed to reach zero at the light's radius
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        lighting += lightColor * diff * color * window * window / (distance * distance);
+    }
+    return lighting;
+}
 
 void main()
 {
@@ -24,20 +54,7 @@ void main()
     // Ambient
     vec3 ambient = 0.0 * color;
     // Lighting
-    vec3 lighting = vec3(0.0f);
-    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
-    for(int i = 0; i < 4; i++)
-    {
-        // Diffuse
-        vec3 lightDir = normalize(lights[i].Position - fs_in.FragPos);
-        float diff = max(dot(lightDir, normal), 0.0);
-        vec3 result = lights[i].Color * diff * color;
-        // Attenuation (use quadratic as we have gamma correction)
-        float distance = length(fs_in.FragPos - lights[i].Position);
-        result *= 1.0 / (distance * distance);
-        lighting += result;
-
-    }
+    vec3 lighting = ClusteredLighting(color, normal);
     vec3 result = ambient + lighting;
     // Check whether result is higher than some threshold, if so, output as bloom threshold color
     float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
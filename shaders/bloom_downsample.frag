@@ -0,0 +1,86 @@
+#version 330 core
+layout (location = 0) out vec3 FragColor;
+layout (location = 1) out float LogLuminance; // Only bound for the first pass
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform vec2 srcResolution;
+
+// First pass only: threshold the HDR scene and remove fireflies
+uniform bool prefilter;
+uniform float threshold;
+uniform float knee;
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Soft-knee threshold, fades pixels in around 'threshold' instead of cutting them off
+vec3 Threshold(vec3 color)
+{
+    float brightness = Luminance(color);
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 1e-5);
+    float contribution = max(soft, brightness - threshold) / max(brightness, 1e-5);
+    return color * contribution;
+}
+
+// Karis average: adds a 2x2 box weighted by its inverse luminance, so single very bright texels don't flicker.
+// The sum is divided by weightSum afterwards, which keeps the HDR range for the threshold.
+void KarisBox(vec3 a, vec3 b, vec3 c, vec3 d, float boxWeight, inout vec3 sum, inout float weightSum)
+{
+    vec3 box = (a + b + c + d) * 0.25;
+    float weight = boxWeight / (1.0 + Luminance(box));
+    sum += box * weight;
+    weightSum += weight;
+}
+
+void main()
+{
+    vec2 texel = 1.0 / srcResolution;
+
+    // 13 bilinear taps around the destination texel (Jimenez 2014):
+    // a - b - c
+    // - j - k -
+    // d - e - f
+    // - l - m -
+    // g - h - i
+    vec3 a = texture(srcTexture, TexCoords + texel * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + texel * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + texel * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + texel * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + texel * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + texel * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + texel * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + texel * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(srcTexture, TexCoords + texel * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(srcTexture, TexCoords + texel * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(srcTexture, TexCoords + texel * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(srcTexture, TexCoords + texel * vec2( 1.0, -1.0)).rgb;
+
+    // Plain weighted average, the downsampled source for the next level
+    vec3 average  = e * 0.125;
+    average += (a + c + g + i) * 0.03125;
+    average += (b + d + f + h) * 0.0625;
+    average += (j + k + l + m) * 0.125;
+
+    vec3 result = average;
+    if(prefilter)
+    {
+        // Same 0.5 / 0.125 box weights as above, but every box is luminance weighted
+        vec3 sum = vec3(0.0);
+        float weightSum = 0.0;
+        KarisBox(j, k, l, m, 0.5, sum, weightSum);
+        KarisBox(a, b, d, e, 0.125, sum, weightSum);
+        KarisBox(b, c, e, f, 0.125, sum, weightSum);
+        KarisBox(d, e, g, h, 0.125, sum, weightSum);
+        KarisBox(e, f, h, i, 0.125, sum, weightSum);
+        result = Threshold(sum / weightSum);
+        // Log luminance of the unthresholded scene for auto exposure, mipmapped afterwards into geometric means
+        LogLuminance = log2(max(Luminance(average), 1e-5));
+    }
+    // Keep the chain free of negative/NaN values that would spread over the whole screen
+    FragColor = max(result, vec3(0.0001));
+}
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D gDepth;
+uniform sampler2D gAlbedoSpec;
+uniform vec3 ambient;
+
+void main()
+{
+    // Background pixels stay black
+    if(texture(gDepth, TexCoords).r == 1.0)
+        discard;
+    FragColor = vec4(texture(gAlbedoSpec, TexCoords).rgb * ambient, 1.0);
+}
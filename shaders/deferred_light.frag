@@ -0,0 +1,50 @@
+#version 330 core
+out vec4 FragColor;
+
+// G-buffer, see includes/learnopengl/gbuffer.h
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform mat4 inverseProjection;
+uniform vec2 screenSize;
+
+// The light of this volume, in view space
+uniform vec3 lightPosition;
+uniform vec3 lightColor;
+uniform float lightRadius;
+
+vec3 DecodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+// View space position of the surface at the given texture coordinates
+vec3 ReconstructPosition(vec2 texCoords)
+{
+    float depth = texture(gDepth, texCoords).r;
+    vec4 position = inverseProjection * vec4(vec3(texCoords, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    vec2 texCoords = gl_FragCoord.xy / screenSize;
+    vec3 fragPos = ReconstructPosition(texCoords);
+    vec3 normal = DecodeNormal(texture(gNormal, texCoords).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, texCoords);
+
+    vec3 toLight = lightPosition - fragPos;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    // Diffuse
+    vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedoSpec.rgb * lightColor;
+    // Specular, the camera sits at the origin of view space
+    vec3 halfwayDir = normalize(lightDir - normalize(fragPos));
+    vec3 specular = pow(max(dot(normal, halfwayDir), 0.0), 16.0) * albedoSpec.a * lightColor;
+    // Quadratic attenuation, windowed to reach zero at the edge of the light volume
+    float window = clamp(1.0 - pow(distance / lightRadius, 4.0), 0.0, 1.0);
+    FragColor = vec4((diffuse + specular) * window * window / (distance * distance), 1.0);
+}
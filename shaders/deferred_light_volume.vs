@@ -1,8 +1,5 @@
 #version 330 core
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec2 texCoords;
-
-out vec2 TexCoords;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -11,5 +8,4 @@ uniform mat4 projection;
 void main()
 {
     gl_Position = projection * view * model * vec4(position, 1.0f);
-    TexCoords = texCoords;
-}
\ No newline at end of file
+}
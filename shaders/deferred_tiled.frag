@@ -0,0 +1,61 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// G-buffer, see includes/learnopengl/gbuffer.h
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform mat4 inverseProjection;
+uniform vec3 ambient;
+
+// Light lists per screen tile, see includes/learnopengl/tiled_lights.h
+uniform samplerBuffer tileLights;        // 2 texels per light: (view space position, radius), (color, 0)
+uniform usamplerBuffer tileGrid;         // Per tile: (first index, light count)
+uniform usamplerBuffer tileLightIndices;
+uniform int tileSize;
+uniform int tilesX;
+
+vec3 DecodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    float depth = texture(gDepth, TexCoords).r;
+    // Background pixels stay black
+    if(depth == 1.0)
+        discard;
+    vec4 position = inverseProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+    vec3 normal = DecodeNormal(texture(gNormal, TexCoords).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, TexCoords);
+    vec3 viewDir = normalize(-fragPos);
+
+    vec3 lighting = albedoSpec.rgb * ambient;
+    ivec2 tile = ivec2(gl_FragCoord.xy) / tileSize;
+    uvec2 list = texelFetch(tileGrid, tile.y * tilesX + tile.x).rg;
+    for(uint i = 0u; i < list.y; ++i)
+    {
+        int light = int(texelFetch(tileLightIndices, int(list.x + i)).r);
+        vec4 positionRadius = texelFetch(tileLights, light * 2);
+        vec3 lightColor = texelFetch(tileLights, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        if(distance >= positionRadius.w)
+            continue;
+        vec3 lightDir = toLight / distance;
+        // Same Blinn-Phong and windowed attenuation as shaders/deferred_light.frag
+        vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedoSpec.rgb * lightColor;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        vec3 specular = pow(max(dot(normal, halfwayDir), 0.0), 16.0) * albedoSpec.a * lightColor;
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        lighting += (diffuse + specular) * window * window / (distance * distance);
+    }
+    FragColor = vec4(lighting, 1.0);
+}
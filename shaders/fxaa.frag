@@ -0,0 +1,136 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture; // Tonemapped and gamma corrected, bilinear filtered
+uniform vec2 inverseScreenSize;
+uniform float edgeThresholdMin = 0.0312; // Skips dark edges below this contrast
+uniform float edgeThresholdMax = 0.125;  // Minimum contrast relative to the local maximum
+uniform float subpixelQuality = 0.75;    // Amount of subpixel aliasing removal
+
+// Steps along the edge, growing further out
+const int ITERATIONS = 12;
+const float QUALITY[ITERATIONS] = float[ITERATIONS](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+// The input is already gamma corrected, so this is perceptual luma
+float Luma(vec2 texCoords)
+{
+    return dot(textureLod(screenTexture, texCoords, 0.0).rgb, vec3(0.299, 0.587, 0.114));
+}
+
+float LumaOffset(vec2 offset)
+{
+    return Luma(TexCoords + offset * inverseScreenSize);
+}
+
+// Fast approximate anti-aliasing (Lottes, FXAA 3.11 quality): detects edges from luma contrast, follows each edge to
+// both of its ends to find where on it this pixel lies and blends with the neighbour across the edge accordingly
+void main()
+{
+    vec3 colorCenter = textureLod(screenTexture, TexCoords, 0.0).rgb;
+    float lumaCenter = dot(colorCenter, vec3(0.299, 0.587, 0.114));
+    float lumaDown = LumaOffset(vec2(0.0, -1.0));
+    float lumaUp = LumaOffset(vec2(0.0, 1.0));
+    float lumaLeft = LumaOffset(vec2(-1.0, 0.0));
+    float lumaRight = LumaOffset(vec2(1.0, 0.0));
+
+    // Early out on pixels without enough local contrast, the bulk of the screen
+    float lumaMin = min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+    float lumaMax = max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+    float lumaRange = lumaMax - lumaMin;
+    if(lumaRange < max(edgeThresholdMin, lumaMax * edgeThresholdMax))
+    {
+        FragColor = vec4(colorCenter, 1.0);
+        return;
+    }
+
+    float lumaDownLeft = LumaOffset(vec2(-1.0, -1.0));
+    float lumaUpRight = LumaOffset(vec2(1.0, 1.0));
+    float lumaUpLeft = LumaOffset(vec2(-1.0, 1.0));
+    float lumaDownRight = LumaOffset(vec2(1.0, -1.0));
+
+    // Horizontal or vertical edge, from the second derivatives over the 3x3 neighbourhood
+    float lumaDownUp = lumaDown + lumaUp;
+    float lumaLeftRight = lumaLeft + lumaRight;
+    float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+    float lumaDownCorners = lumaDownLeft + lumaDownRight;
+    float lumaRightCorners = lumaDownRight + lumaUpRight;
+    float lumaUpCorners = lumaUpRight + lumaUpLeft;
+    float edgeHorizontal = abs(-2.0 * lumaLeft + lumaLeftCorners) + abs(-2.0 * lumaCenter + lumaDownUp) * 2.0 + abs(-2.0 * lumaRight + lumaRightCorners);
+    float edgeVertical = abs(-2.0 * lumaUp + lumaUpCorners) + abs(-2.0 * lumaCenter + lumaLeftRight) * 2.0 + abs(-2.0 * lumaDown + lumaDownCorners);
+    bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+    // Which side of the pixel the edge lies on: the neighbour with the steepest gradient
+    float luma1 = isHorizontal ? lumaDown : lumaLeft;
+    float luma2 = isHorizontal ? lumaUp : lumaRight;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool is1Steepest = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+    float stepLength = isHorizontal ? inverseScreenSize.y : inverseScreenSize.x;
+    float lumaLocalAverage;
+    if(is1Steepest)
+    {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+    }
+    else
+        lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+
+    // Walk along the edge (half a pixel towards it) in both directions until the luma leaves the edge's average
+    vec2 edgeUV = TexCoords;
+    if(isHorizontal)
+        edgeUV.y += stepLength * 0.5;
+    else
+        edgeUV.x += stepLength * 0.5;
+    vec2 offset = isHorizontal ? vec2(inverseScreenSize.x, 0.0) : vec2(0.0, inverseScreenSize.y);
+    vec2 uv1 = edgeUV - offset * QUALITY[0];
+    vec2 uv2 = edgeUV + offset * QUALITY[0];
+    float lumaEnd1 = Luma(uv1) - lumaLocalAverage;
+    float lumaEnd2 = Luma(uv2) - lumaLocalAverage;
+    bool reached1 = abs(lumaEnd1) >= gradientScaled;
+    bool reached2 = abs(lumaEnd2) >= gradientScaled;
+    if(!reached1)
+        uv1 -= offset * QUALITY[1];
+    if(!reached2)
+        uv2 += offset * QUALITY[1];
+    for(int i = 2; i < ITERATIONS && !(reached1 && reached2); ++i)
+    {
+        if(!reached1)
+            lumaEnd1 = Luma(uv1) - lumaLocalAverage;
+        if(!reached2)
+            lumaEnd2 = Luma(uv2) - lumaLocalAverage;
+        reached1 = abs(lumaEnd1) >= gradientScaled;
+        reached2 = abs(lumaEnd2) >= gradientScaled;
+        if(!reached1)
+            uv1 -= offset * QUALITY[i];
+        if(!reached2)
+            uv2 += offset * QUALITY[i];
+    }
+
+    // Offset towards the edge from the position between its two ends, only if the end closest to this pixel
+    // varies in the same direction as the pixel
+    float distance1 = isHorizontal ? (TexCoords.x - uv1.x) : (TexCoords.y - uv1.y);
+    float distance2 = isHorizontal ? (uv2.x - TexCoords.x) : (uv2.y - TexCoords.y);
+    bool isDirection1 = distance1 < distance2;
+    float distanceFinal = min(distance1, distance2);
+    float edgeThickness = distance1 + distance2;
+    float pixelOffset = -distanceFinal / edgeThickness + 0.5;
+    bool isLumaCenterSmaller = lumaCenter < lumaLocalAverage;
+    bool correctVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0) != isLumaCenterSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // Subpixel aliasing: offset by how much the pixel differs from the average of its 3x3 neighbourhood
+    float lumaAverage = (1.0 / 12.0) * (2.0 * (lumaDownUp + lumaLeftRight) + lumaLeftCorners + lumaRightCorners);
+    float subPixelOffset1 = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+    float subPixelOffset2 = (-2.0 * subPixelOffset1 + 3.0) * subPixelOffset1 * subPixelOffset1;
+    finalOffset = max(finalOffset, subPixelOffset2 * subPixelOffset2 * subpixelQuality);
+
+    // One bilinear fetch blends with the neighbour across the edge
+    vec2 finalUV = TexCoords;
+    if(isHorizontal)
+        finalUV.y += finalOffset * stepLength;
+    else
+        finalUV.x += finalOffset * stepLength;
+    FragColor = vec4(textureLod(screenTexture, finalUV, 0.0).rgb, 1.0);
+}
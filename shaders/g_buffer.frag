@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+
+in VS_OUT {
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_specular1;
+
+// Octahedron normal encoding (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors"):
+// the unit sphere is projected onto an octahedron and its lower half folded over the upper one, two channels suffice
+vec2 EncodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if(n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+void main()
+{
+    // Only the surface attributes, position comes back from the depth buffer
+    gNormal = EncodeNormal(normalize(fs_in.Normal));
+    gAlbedoSpec.rgb = texture(texture_diffuse1, fs_in.TexCoords).rgb;
+    gAlbedoSpec.a = texture(texture_specular1, fs_in.TexCoords).r;
+}
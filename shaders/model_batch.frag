@@ -0,0 +1,110 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+    flat ivec2 Material;
+} fs_in;
+
+// The texture arrays of MaterialBatch (see TextureArrays::Bind), GLSL 3.30 can't index an array of them dynamically
+uniform sampler2DArray materialArray0;
+uniform sampler2DArray materialArray1;
+uniform sampler2DArray materialArray2;
+uniform sampler2DArray materialArray3;
+uniform sampler2D shadowMap;
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+
+uniform bool shadows;
+
+const vec3 fogColor = vec3(0.5, 0.5,0.5);
+const float FogDensity = 0.10;
+
+
+float ShadowCalculation(vec4 fragPosLightSpace)
+{
+    // perform perspective divide
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    // Transform to [0,1] range
+    projCoords = projCoords * 0.5 + 0.5;
+    // Get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
+    float closestDepth = texture(shadowMap, projCoords.xy).r;
+    // Get depth of current fragment from light's perspective
+    float currentDepth = projCoords.z;
+    // Calculate bias (based on depth map resolution and slope)
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    // Check whether current frag pos is in shadow
+    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+    // PCF
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+            shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
+    if(projCoords.z > 1.0)
+        shadow = 0.0;
+
+    return shadow;
+}
+
+// The mesh's diffuse texture. The gradients are taken outside the branches, where they are well defined.
+vec3 MaterialColor()
+{
+    vec2 dx = dFdx(fs_in.TexCoords);
+    vec2 dy = dFdy(fs_in.TexCoords);
+    vec3 coords = vec3(fs_in.TexCoords, fs_in.Material.y);
+    if (fs_in.Material.x == 0)
+        return textureGrad(materialArray0, coords, dx, dy).rgb;
+    if (fs_in.Material.x == 1)
+        return textureGrad(materialArray1, coords, dx, dy).rgb;
+    if (fs_in.Material.x == 2)
+        return textureGrad(materialArray2, coords, dx, dy).rgb;
+    if (fs_in.Material.x == 3)
+        return textureGrad(materialArray3, coords, dx, dy).rgb;
+    return vec3(1.0);
+}
+
+void main()
+{
+    vec3 color = MaterialColor();
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 lightColor = vec3(1.0);
+    // Ambient
+    vec3 ambient = 0.3 * color;
+    // Diffuse
+    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * lightColor;
+    // Specular
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = 0.0;
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+    vec3 specular = spec * lightColor;
+    // Calculate shadow
+    float shadow = shadows ? ShadowCalculation(fs_in.FragPosLightSpace) : 0.0;
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
+
+    float dist = gl_FragCoord.z / gl_FragCoord.w;
+    float fogFactor = 1.0 /exp( (dist * FogDensity)* (dist * FogDensity));
+    fogFactor = clamp( fogFactor, 0.0, 1.0 );
+
+    FragColor = mix(vec4(fogColor,1.0), vec4(lighting,1.0), fogFactor);
+
+    //FragColor = vec4(lighting, 1.0f);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+layout (location = 3) in ivec2 material;
+
+// As model_shader.vs for meshes merged by MaterialBatch: positions and normals are in world space already and
+// material is the texture array and layer of the mesh's diffuse texture
+
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+    flat ivec2 Material;
+} vs_out;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+
+void main()
+{
+    gl_Position = projection * view * vec4(position, 1.0f);
+    vs_out.FragPos = position;
+    vs_out.Normal = normal;
+    vs_out.TexCoords = texCoords;
+    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    vs_out.Material = material;
+}
@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D accumTexture;  // rgb: sum(premultiplied color * weight), a: revealage
+uniform sampler2D weightTexture; // r: sum(alpha * weight)
+
+void main()
+{
+    ivec2 coords = ivec2(gl_FragCoord.xy);
+    vec4 accum = texelFetch(accumTexture, coords, 0);
+    float revealage = accum.a;
+    // Nothing transparent covered this pixel, keep the opaque color untouched
+    if(revealage >= 0.9999)
+        discard;
+    float weightSum = texelFetch(weightTexture, coords, 0).r;
+    // Weighted average of the transparent colors, blended over the opaque image with (1 - revealage) coverage
+    vec3 averageColor = accum.rgb / max(weightSum, 1e-5);
+    FragColor = vec4(averageColor, 1.0 - revealage);
+}
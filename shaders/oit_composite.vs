@@ -4,12 +4,8 @@ layout (location = 1) in vec2 texCoords;
 
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_Position = vec4(position, 1.0f);
     TexCoords = texCoords;
-}
\ No newline at end of file
+}
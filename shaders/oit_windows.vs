@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texCoords;
+layout (location = 2) in vec3 offset; // Per-instance window position
+
+// The interface of shaders/blending_oit.frag, which draws the windows unlit
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+} vs_out;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vs_out.FragPos = position + offset;
+    vs_out.Normal = vec3(0.0, 0.0, 1.0);
+    vs_out.TexCoords = texCoords;
+    vs_out.FragPosLightSpace = vec4(0.0);
+    gl_Position = projection * view * vec4(vs_out.FragPos, 1.0f);
+}
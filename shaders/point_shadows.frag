@@ -0,0 +1,110 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+uniform sampler2D diffuseTexture;
+uniform sampler2DShadow pointShadowMap; // Shadow atlas, see includes/learnopengl/point_shadows.h
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+
+uniform float far_plane;
+uniform float pointShadowNear;
+uniform vec4 pointShadowTiles[6]; // Atlas tile of every face: xy = offset, z = size, w = texel size at unit distance
+uniform bool shadows;
+
+
+// array of offset direction for sampling
+vec3 gridSamplingDisk[20] = vec3[]
+(
+   vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1), 
+   vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+   vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+   vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+   vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
+// 1.0 if the point at fragToLight from the light is lit. Picks the cube face like a cube map lookup would and
+// compares against the depth of that face's 90 degree perspective projection.
+float ShadowSample(vec3 fragToLight)
+{
+    vec3 absDir = abs(fragToLight);
+    int face;
+    float majorAxis;
+    vec2 faceCoords;
+    if(absDir.x >= absDir.y && absDir.x >= absDir.z)
+    {
+        majorAxis = absDir.x;
+        face = fragToLight.x > 0.0 ? 0 : 1;
+        faceCoords = vec2(fragToLight.x > 0.0 ? -fragToLight.z : fragToLight.z, -fragToLight.y);
+    }
+    else if(absDir.y >= absDir.z)
+    {
+        majorAxis = absDir.y;
+        face = fragToLight.y > 0.0 ? 2 : 3;
+        faceCoords = vec2(fragToLight.x, fragToLight.y > 0.0 ? fragToLight.z : -fragToLight.z);
+    }
+    else
+    {
+        majorAxis = absDir.z;
+        face = fragToLight.z > 0.0 ? 4 : 5;
+        faceCoords = vec2(fragToLight.z > 0.0 ? fragToLight.x : -fragToLight.x, -fragToLight.y);
+    }
+    // Stay a texel inside the face's tile so filtering never reads the neighbouring tiles
+    vec4 tile = pointShadowTiles[face];
+    vec2 uv = clamp(faceCoords / majorAxis * 0.5 + 0.5, tile.w * 0.5, 1.0 - tile.w * 0.5);
+    uv = tile.xy + uv * tile.z;
+    float depth = ((far_plane + pointShadowNear) / (far_plane - pointShadowNear)
+                   - 2.0 * far_plane * pointShadowNear / ((far_plane - pointShadowNear) * majorAxis)) * 0.5 + 0.5;
+    return texture(pointShadowMap, vec3(uv, depth));
+}
+
+float ShadowCalculation(vec3 fragPos, vec3 normal)
+{
+    // The light got no room in the atlas
+    if(pointShadowTiles[0].w == 0.0)
+        return 0.0;
+    // Get vector between fragment position and light position
+    vec3 fragToLight = fragPos - lightPos;
+    // Normal offset of about a texel at the fragment's distance from the light
+    fragToLight += normal * pointShadowTiles[0].w * length(fragToLight) * 1.5;
+    // PCF over a disk that grows with the view distance
+    float shadow = 0.0;
+    int samples = 20;
+    float viewDistance = length(viewPos - fragPos);
+    float diskRadius = (1.0 + (viewDistance / far_plane)) / 25.0;
+    for(int i = 0; i < samples; ++i)
+        shadow += 1.0 - ShadowSample(fragToLight + gridSamplingDisk[i] * diskRadius);
+    shadow /= float(samples);
+    return shadow;
+}
+
+void main()
+{           
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 lightColor = vec3(0.3);
+    // Ambient
+    vec3 ambient = 0.3 * color;
+    // Diffuse
+    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * lightColor;
+    // Specular
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = 0.0;
+    vec3 halfwayDir = normalize(lightDir + viewDir);  
+    spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+    vec3 specular = spec * lightColor;    
+    // Calculate shadow
+    float shadow = shadows ? ShadowCalculation(fs_in.FragPos, normal) : 0.0;                      
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+    
+    FragColor = vec4(lighting, 1.0f);
+}
\ No newline at end of file
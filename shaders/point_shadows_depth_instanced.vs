@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+// One instance per point light cube face the object touches, see includes/learnopengl/point_shadows.h
+uniform mat4 faceMatrices[16];
+uniform vec4 faceTiles[16]; // Atlas tile of the face in normalized device coordinates: xy = center, zw = half size
+uniform mat4 model;
+
+void main()
+{
+    vec4 clipPos = faceMatrices[gl_InstanceID] * model * vec4(position, 1.0f);
+    // Clip against the face's frustum sides here, the rasterizer only clips against the whole atlas
+    gl_ClipDistance[0] = clipPos.w + clipPos.x;
+    gl_ClipDistance[1] = clipPos.w - clipPos.x;
+    gl_ClipDistance[2] = clipPos.w + clipPos.y;
+    gl_ClipDistance[3] = clipPos.w - clipPos.y;
+    // Then squeeze the face into its tile
+    vec4 tile = faceTiles[gl_InstanceID];
+    gl_Position = vec4(clipPos.xy * tile.zw + tile.xy * clipPos.w, clipPos.zw);
+}
@@ -5,53 +5,158 @@ in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    float ViewDepth;
 } fs_in;
 
+const int MAX_CASCADES = 4;
+const int MAX_POINT_LIGHTS = 8;
+
 uniform sampler2D diffuseTexture;
-uniform sampler2D shadowMap;
+uniform sampler2DArrayShadow shadowMap;
+uniform sampler2DShadow pointShadowMap;
+
+// Cascaded shadow maps, see includes/learnopengl/cascaded_shadows.h
+uniform int cascadeCount;
+uniform float cascadeSplits[MAX_CASCADES];      // View space far distance of every cascade
+uniform float cascadeTexelSizes[MAX_CASCADES];  // World space size of a shadow map texel
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+
+// Point lights sorted into view frustum clusters, see includes/learnopengl/clustered_lights.h
+uniform samplerBuffer clusterLights;        // (position, radius), (color, 0) per light
+uniform usamplerBuffer clusterGrid;         // (first index, light count) per cluster
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterDims;
+uniform float clusterTileSize;
+uniform vec2 clusterDepthParams;            // slice = log(depth) * x - y
+
+// Shadows of the first pointShadowCount point lights, see includes/learnopengl/point_shadows.h.
+// A light's radius is also the far plane of its shadow.
+uniform int pointShadowCount;
+uniform float pointShadowNear;
+// Atlas tile of every light's faces (light * 6 + face): xy = offset, z = size in texture coordinates,
+// w = size of a tile texel at unit distance from the light, 0 if the light got no room in the atlas
+uniform vec4 pointShadowTiles[MAX_POINT_LIGHTS * 6];
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
 uniform bool shadows;
+uniform bool showCascades = false;
 
-float ShadowCalculation(vec4 fragPosLightSpace)
+// First cascade whose slice contains the fragment, cascadeCount when it is beyond the shadow distance
+int SelectCascade()
 {
+    for(int i = 0; i < cascadeCount; ++i)
+        if(fs_in.ViewDepth < cascadeSplits[i])
+            return i;
+    return cascadeCount;
+}
+
+float ShadowCalculation(int cascade)
+{
+    // No shadows beyond the last cascade
+    if(cascade >= cascadeCount)
+        return 0.0;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+    // Normal offset: push the lookup position out of the surface by about a texel of this cascade,
+    // more at grazing angles, so the bias follows the cascade resolution
+    float texelSize = cascadeTexelSizes[cascade];
+    vec3 offsetPos = fs_in.FragPos + normal * texelSize * 1.5 * (1.0 - max(dot(normal, lightDir), 0.0));
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(offsetPos, 1.0);
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // Transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
-    // Get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
-    // Get depth of current fragment from light's perspective
-    float currentDepth = projCoords.z;
-    // Calculate bias (based on depth map resolution and slope)
-    vec3 normal = normalize(fs_in.Normal);
-    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
-    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
-    // Check whether current frag pos is in shadow
-    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
-    // PCF
+    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
+    if(projCoords.z > 1.0)
+        return 0.0;
+    float currentDepth = projCoords.z - 0.0005;
+    // PCF, every lookup is already a filtered 2x2 comparison
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    vec2 mapTexelSize = 1.0 / vec2(textureSize(shadowMap, 0));
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-            shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;        
+            shadow += 1.0 - texture(shadowMap, vec4(projCoords.xy + vec2(x, y) * mapTexelSize, cascade, currentDepth));
         }    
     }
     shadow /= 9.0;
-    
-    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
-    if(projCoords.z > 1.0)
-        shadow = 0.0;
         
     return shadow;
 }
 
+float PointShadowCalculation(int light, vec3 lightPos, float farPlane, vec3 normal)
+{
+    // All faces of a light have the same tile size
+    float texelSize = pointShadowTiles[light * 6].w;
+    if(texelSize == 0.0)
+        return 0.0;
+    vec3 fragToLight = fs_in.FragPos - lightPos;
+    // Normal offset of about a texel at the fragment's distance from the light
+    fragToLight += normal * texelSize * length(fragToLight) * 1.5;
+    // Cube map face selection, every face has its own tile in the atlas
+    vec3 absDir = abs(fragToLight);
+    int face;
+    float majorAxis;
+    vec2 faceCoords;
+    if(absDir.x >= absDir.y && absDir.x >= absDir.z)
+    {
+        majorAxis = absDir.x;
+        face = fragToLight.x > 0.0 ? 0 : 1;
+        faceCoords = vec2(fragToLight.x > 0.0 ? -fragToLight.z : fragToLight.z, -fragToLight.y);
+    }
+    else if(absDir.y >= absDir.z)
+    {
+        majorAxis = absDir.y;
+        face = fragToLight.y > 0.0 ? 2 : 3;
+        faceCoords = vec2(fragToLight.x, fragToLight.y > 0.0 ? fragToLight.z : -fragToLight.z);
+    }
+    else
+    {
+        majorAxis = absDir.z;
+        face = fragToLight.z > 0.0 ? 4 : 5;
+        faceCoords = vec2(fragToLight.z > 0.0 ? fragToLight.x : -fragToLight.x, -fragToLight.y);
+    }
+    // Stay a texel inside the tile so filtering never reads the neighbouring tiles
+    vec4 tile = pointShadowTiles[light * 6 + face];
+    vec2 uv = clamp(faceCoords / majorAxis * 0.5 + 0.5, texelSize * 0.5, 1.0 - texelSize * 0.5);
+    uv = tile.xy + uv * tile.z;
+    // Depth the face's 90 degree perspective projection gives a point at majorAxis along the face axis
+    float nearPlane = pointShadowNear;
+    float depth = ((farPlane + nearPlane) / (farPlane - nearPlane) - 2.0 * farPlane * nearPlane / ((farPlane - nearPlane) * majorAxis)) * 0.5 + 0.5;
+    return 1.0 - texture(pointShadowMap, vec3(uv, depth));
+}
+
+vec3 PointLighting(vec3 color, vec3 normal)
+{
+    // Find the fragment's cluster from its pixel and view space depth
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize), int(log(max(fs_in.ViewDepth, 1e-4)) * clusterDepthParams.x - clusterDepthParams.y));
+    cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+    uvec2 range = texelFetch(clusterGrid, (cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x).xy;
+
+    vec3 lighting = vec3(0.0);
+    for(uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 lightColor = texelFetch(clusterLights, light * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - fs_in.FragPos;
+        float distance = length(toLight);
+        if(distance > positionRadius.w)
+            continue;
+        float diff = max(dot(toLight / distance, normal), 0.0);
+        // Quadratic attenuation, windowed to reach zero at the light's radius
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        vec3 result = lightColor * diff * color * window * window / (distance * distance);
+        if(shadows && diff > 0.0 && light < pointShadowCount)
+            result *= 1.0 - PointShadowCalculation(light, positionRadius.xyz, positionRadius.w, normal);
+        lighting += result;
+    }
+    return lighting;
+}
+
 void main()
 {           
     vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
@@ -71,8 +176,15 @@ void main()
     spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
     vec3 specular = spec * lightColor;    
     // Calculate shadow
-    float shadow = shadows ? ShadowCalculation(fs_in.FragPosLightSpace) : 0.0;                      
+    int cascade = SelectCascade();
+    float shadow = shadows ? ShadowCalculation(cascade) : 0.0;                      
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+    lighting += PointLighting(color, normal);
+    if(showCascades && cascade < cascadeCount)
+    {
+        const vec3 cascadeColors[MAX_CASCADES] = vec3[](vec3(1.0, 0.3, 0.3), vec3(0.3, 1.0, 0.3), vec3(0.3, 0.3, 1.0), vec3(1.0, 1.0, 0.3));
+        lighting *= cascadeColors[cascade];
+    }
 
     FragColor = vec4(lighting, 1.0f);
 }
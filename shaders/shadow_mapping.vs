@@ -9,19 +9,21 @@ out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    float ViewDepth; // Distance along the view direction, selects the shadow cascade
 } vs_out;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
-uniform mat4 lightSpaceMatrix;
+
+uniform bool reverse_normals; // For cubes seen from the inside, like the rooms
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
+    vec4 viewPos = view * model * vec4(position, 1.0f);
+    gl_Position = projection * viewPos;
     vs_out.FragPos = vec3(model * vec4(position, 1.0));
-    vs_out.Normal = transpose(inverse(mat3(model))) * normal;
+    vs_out.Normal = transpose(inverse(mat3(model))) * (reverse_normals ? -normal : normal);
     vs_out.TexCoords = texCoords;
-    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
-}
\ No newline at end of file
+    vs_out.ViewDepth = -viewPos.z;
+}
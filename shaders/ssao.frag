@@ -0,0 +1,50 @@
+#version 330 core
+out float FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D depthNormal; // (view space normal, linear depth) at the AO resolution
+uniform sampler2D noiseTexture;
+
+uniform vec3 samples[64];
+uniform int kernelSize;
+uniform float radius;
+uniform float bias;
+uniform float power;
+uniform vec2 noiseScale; // AO resolution / noise texture size, tiles the noise over the screen
+uniform mat4 projection;
+
+// View space position of the surface at the given texture coordinates with the given linear depth
+vec3 ViewPosition(vec2 texCoords, float depth)
+{
+    vec2 ndc = texCoords * 2.0 - 1.0;
+    vec2 ray = (ndc + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]);
+    return vec3(ray * depth, -depth);
+}
+
+void main()
+{
+    vec4 center = texture(depthNormal, TexCoords);
+    vec3 fragPos = ViewPosition(TexCoords, center.w);
+    vec3 normal = center.xyz;
+
+    // Tangent space basis around the normal, rotated by the tiled noise so neighbouring pixels use different kernels.
+    // The blur pass afterwards removes the resulting pattern.
+    vec3 randomVec = vec3(texture(noiseTexture, TexCoords * noiseScale).xy, 0.0);
+    vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 TBN = mat3(tangent, bitangent, normal);
+
+    float occlusion = 0.0;
+    for(int i = 0; i < kernelSize; ++i)
+    {
+        // Sample position in view space, then where it lands on screen
+        vec3 samplePos = fragPos + TBN * samples[i] * radius;
+        vec4 offset = projection * vec4(samplePos, 1.0);
+        offset.xy = offset.xy / offset.w * 0.5 + 0.5;
+        float sampleDepth = texture(depthNormal, offset.xy).w;
+        // Occluded when the surface there is in front of the sample, faded out for surfaces far outside the radius
+        float rangeCheck = smoothstep(0.0, 1.0, radius / abs(center.w - sampleDepth));
+        occlusion += (sampleDepth <= -samplePos.z - bias ? 1.0 : 0.0) * rangeCheck;
+    }
+    FragColor = pow(1.0 - occlusion / kernelSize, power);
+}
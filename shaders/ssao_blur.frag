@@ -0,0 +1,30 @@
+#version 330 core
+out float FragColor;
+
+uniform sampler2D aoTexture;
+uniform sampler2D depthNormal;
+uniform ivec2 direction;    // (1, 0) horizontal or (0, 1) vertical pass
+uniform float sharpness;
+
+const int BLUR_RADIUS = 4;
+
+// Separable bilateral blur: a Gaussian whose taps lose their weight with the relative depth difference to the
+// center, so occlusion doesn't bleed across silhouettes
+void main()
+{
+    ivec2 size = textureSize(aoTexture, 0);
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    float centerDepth = texelFetch(depthNormal, center, 0).w;
+    float result = 0.0;
+    float totalWeight = 0.0;
+    for(int i = -BLUR_RADIUS; i <= BLUR_RADIUS; ++i)
+    {
+        ivec2 texel = clamp(center + direction * i, ivec2(0), size - 1);
+        float depth = texelFetch(depthNormal, texel, 0).w;
+        float depthDifference = abs(depth - centerDepth) / centerDepth;
+        float weight = exp(-float(i * i) / (2.0 * BLUR_RADIUS)) * exp(-depthDifference * depthDifference * sharpness);
+        result += texelFetch(aoTexture, texel, 0).r * weight;
+        totalWeight += weight;
+    }
+    FragColor = result / totalWeight;
+}
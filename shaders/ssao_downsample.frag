@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform int downscale;
+uniform float nearPlane;
+uniform float farPlane;
+
+float LinearizeDepth(float depth)
+{
+    float z = depth * 2.0 - 1.0; // Back to NDC
+    return (2.0 * nearPlane * farPlane) / (farPlane + nearPlane - z * (farPlane - nearPlane));
+}
+
+vec3 DecodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+// Reduces the G-buffer to (view space normal, linear depth) at the AO resolution. Of the covered pixels the closest
+// one is kept as a whole, averaging depths or normals across an edge would create surfaces that don't exist.
+void main()
+{
+    ivec2 size = textureSize(gDepth, 0);
+    ivec2 origin = ivec2(gl_FragCoord.xy) * downscale;
+    ivec2 closest = origin;
+    float closestDepth = 1.0;
+    for(int y = 0; y < downscale; ++y)
+        for(int x = 0; x < downscale; ++x)
+        {
+            ivec2 texel = min(origin + ivec2(x, y), size - 1);
+            float depth = texelFetch(gDepth, texel, 0).r;
+            if(depth <= closestDepth)
+            {
+                closestDepth = depth;
+                closest = texel;
+            }
+        }
+    FragColor = vec4(DecodeNormal(texelFetch(gNormal, closest, 0).rg), LinearizeDepth(closestDepth));
+}
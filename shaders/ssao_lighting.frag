@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// G-buffer, see includes/learnopengl/gbuffer.h
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D ssao;
+uniform mat4 inverseProjection;
+
+uniform vec3 lightPosition; // View space
+uniform vec3 lightColor;
+uniform bool useAO;
+
+vec3 DecodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    float depth = texture(gDepth, TexCoords).r;
+    if(depth == 1.0)
+        discard;
+    vec4 position = inverseProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+    vec3 normal = DecodeNormal(texture(gNormal, TexCoords).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, TexCoords);
+    float occlusion = useAO ? texture(ssao, TexCoords).r : 1.0;
+
+    // Ambient, occluded
+    vec3 ambient = 0.3 * albedoSpec.rgb * occlusion;
+    // Diffuse
+    vec3 toLight = lightPosition - fragPos;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedoSpec.rgb * lightColor;
+    // Specular, the camera sits at the origin of view space
+    vec3 halfwayDir = normalize(lightDir - normalize(fragPos));
+    vec3 specular = pow(max(dot(normal, halfwayDir), 0.0), 8.0) * albedoSpec.a * lightColor;
+    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+    FragColor = vec4(ambient + (diffuse + specular) * attenuation, 1.0);
+}
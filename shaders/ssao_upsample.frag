@@ -0,0 +1,38 @@
+#version 330 core
+out float FragColor;
+
+uniform sampler2D aoTexture;   // Low resolution AO
+uniform sampler2D depthNormal; // Low resolution (normal, linear depth)
+uniform sampler2D gDepth;      // Full resolution depth
+uniform int downscale;
+uniform float nearPlane;
+uniform float farPlane;
+
+float LinearizeDepth(float depth)
+{
+    float z = depth * 2.0 - 1.0; // Back to NDC
+    return (2.0 * nearPlane * farPlane) / (farPlane + nearPlane - z * (farPlane - nearPlane));
+}
+
+// Joint bilateral upsampling: the four nearest low resolution texels are blended with their bilinear weights,
+// scaled down by how far their depth is from this pixel's, so edges take the AO of the surface they belong to
+void main()
+{
+    ivec2 size = textureSize(aoTexture, 0);
+    float depth = LinearizeDepth(texelFetch(gDepth, ivec2(gl_FragCoord.xy), 0).r);
+    vec2 position = gl_FragCoord.xy / float(downscale) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+    float bilinear[4] = float[4]((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+    float result = 0.0;
+    float totalWeight = 0.0;
+    for(int i = 0; i < 4; ++i)
+    {
+        ivec2 texel = clamp(base + ivec2(i & 1, i >> 1), ivec2(0), size - 1);
+        float weight = bilinear[i] / (abs(texelFetch(depthNormal, texel, 0).w - depth) / depth + 0.001);
+        result += texelFetch(aoTexture, texel, 0).r * weight;
+        totalWeight += weight;
+    }
+    FragColor = result / max(totalWeight, 1e-5);
+}
@@ -0,0 +1,57 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D currentColor;    // This frame's HDR color, rendered with a jittered projection
+uniform sampler2D historyColor;    // Last frame's resolved HDR color
+uniform sampler2D velocityTexture; // Current minus previous texture coordinates
+uniform sampler2D depthTexture;
+uniform vec2 texelSize;
+uniform float feedback = 0.9;      // Weight of the history once it is clamped
+uniform bool historyValid;
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Temporal anti-aliasing resolve: blends the jittered current frame with the reprojected history, so over a few
+// frames every pixel integrates the samples of the whole jitter pattern. History that doesn't belong to the
+// surface any more (disocclusion, lighting changes) is clamped to the color range of the current 3x3 neighbourhood.
+void main()
+{
+    // Neighbourhood bounds and the closest depth; edges take the motion of the foreground surface so
+    // the silhouette of a moving object doesn't drag its background's history along
+    vec3 current = texture(currentColor, TexCoords).rgb;
+    vec3 colorMin = current;
+    vec3 colorMax = current;
+    float closestDepth = texture(depthTexture, TexCoords).r;
+    vec2 closestOffset = vec2(0.0);
+    for(int y = -1; y <= 1; ++y)
+        for(int x = -1; x <= 1; ++x)
+        {
+            vec2 offset = vec2(x, y) * texelSize;
+            vec3 color = texture(currentColor, TexCoords + offset).rgb;
+            colorMin = min(colorMin, color);
+            colorMax = max(colorMax, color);
+            float depth = texture(depthTexture, TexCoords + offset).r;
+            if(depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestOffset = offset;
+            }
+        }
+
+    vec2 historyCoords = TexCoords - texture(velocityTexture, TexCoords + closestOffset).rg;
+    if(!historyValid || any(lessThan(historyCoords, vec2(0.0))) || any(greaterThan(historyCoords, vec2(1.0))))
+    {
+        FragColor = vec4(current, 1.0);
+        return;
+    }
+    vec3 history = clamp(texture(historyColor, historyCoords).rgb, colorMin, colorMax);
+
+    // Weighted by inverse luminance so single bright samples (specular highlights, light boxes) don't flicker
+    float currentWeight = (1.0 - feedback) / (1.0 + Luminance(current));
+    float historyWeight = feedback / (1.0 + Luminance(history));
+    FragColor = vec4((current * currentWeight + history * historyWeight) / (currentWeight + historyWeight), 1.0);
+}
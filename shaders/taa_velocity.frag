@@ -0,0 +1,22 @@
+#version 330 core
+out vec2 Velocity;
+in vec2 TexCoords;
+
+uniform sampler2D depthTexture;
+uniform mat4 inverseViewProjection;  // Of this frame as rendered, jitter included
+uniform mat4 currentViewProjection;  // Of this frame without the jitter
+uniform mat4 previousViewProjection; // Of the last frame without the jitter
+
+// Screen space motion of the surface under every pixel caused by the camera since the last frame: the position is
+// reconstructed from the depth buffer and projected with both frames' matrices. The jitter is left out of both
+// projections so a still camera gives zero motion. Velocity is current minus previous texture coordinates.
+void main()
+{
+    float depth = texture(depthTexture, TexCoords).r;
+    vec4 position = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    position /= position.w;
+
+    vec4 current = currentViewProjection * position;
+    vec4 previous = previousViewProjection * position;
+    Velocity = (current.xy / current.w - previous.xy / previous.w) * 0.5;
+}
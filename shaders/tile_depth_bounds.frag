@@ -0,0 +1,37 @@
+#version 330 core
+out vec2 FragColor;
+
+uniform sampler2D gDepth;
+uniform int tileSize;
+uniform float nearPlane;
+uniform float farPlane;
+
+float LinearizeDepth(float depth)
+{
+    float z = depth * 2.0 - 1.0; // Back to NDC
+    return (2.0 * nearPlane * farPlane) / (farPlane + nearPlane - z * (farPlane - nearPlane));
+}
+
+// One fragment per tile: view space distance of the closest and farthest surface in the tile, background ignored.
+// Tiles without any geometry get min > max.
+void main()
+{
+    ivec2 origin = ivec2(gl_FragCoord.xy) * tileSize;
+    ivec2 end = min(origin + ivec2(tileSize), textureSize(gDepth, 0));
+    float minDepth = 1.0;
+    float maxDepth = 0.0;
+    for(int y = origin.y; y < end.y; ++y)
+        for(int x = origin.x; x < end.x; ++x)
+        {
+            float depth = texelFetch(gDepth, ivec2(x, y), 0).r;
+            if(depth < 1.0)
+            {
+                minDepth = min(minDepth, depth);
+                maxDepth = max(maxDepth, depth);
+            }
+        }
+    if(minDepth > maxDepth)
+        FragColor = vec2(farPlane, 0.0);
+    else
+        FragColor = vec2(LinearizeDepth(minDepth), LinearizeDepth(maxDepth));
+}
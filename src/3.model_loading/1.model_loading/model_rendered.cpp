@@ -8,8 +8,10 @@
 #include <GLFW/glfw3.h>
 
 // GL includes
+#include <learnopengl/benchmark.h> // First, so the GL calls of the other headers are counted in benchmark builds
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/input_recorder.h>
 #include <learnopengl/model.h>
 
 // GLM Mathemtics
@@ -39,7 +41,7 @@ GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
 // The MAIN function, from here we start our application and run our Game loop
-int main()
+int main(int argc, char* argv[])
 {
     // Init GLFW
     glfwInit();
@@ -49,6 +51,12 @@ int main()
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+    // Built as a frame time benchmark the window is hidden and the camera follows a path, see FrameBenchmark
+    FrameBenchmark benchmark("model_loading", argc, argv);
+    benchmark.WindowHints();
+    // Live, recorded or replayed input and clock, see InputRecorder
+    InputRecorder input(argc, argv);
+    benchmark.Attach(input);
     GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "LearnOpenGL", nullptr, nullptr); // Windowed
     glfwMakeContextCurrent(window);
 
@@ -56,6 +64,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    input.Attach(window);
 
     // Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -63,6 +72,7 @@ int main()
     // Initialize GLEW to setup the OpenGL Function pointers
     glewExperimental = GL_TRUE;
     glewInit();
+    benchmark.Start(window);
 
     // Define the viewport dimensions
     glViewport(0, 0, screenWidth, screenHeight);
@@ -81,16 +91,17 @@ int main()
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     // Game loop
-    while(!glfwWindowShouldClose(window))
+    while(!glfwWindowShouldClose(window) && benchmark.Running() && !input.Finished())
     {
-        // Set frame time
-        GLfloat currentFrame = glfwGetTime();
+        // Check and call events, live or replayed
+        input.PollEvents();
+
+        // Set frame time, on the recorder's clock
+        GLfloat currentFrame = input.Time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-
-        // Check and call events
-        glfwPollEvents();
         Do_Movement();
+        benchmark.PlaceCamera(camera);
 
         // Clear the colorbuffer
         glClearColor(1.00f, 1.00f, 1.00f, 1.0f);
@@ -112,7 +123,9 @@ int main()
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame();
     }
+    benchmark.Report();
 
     glfwTerminate();
     return 0;
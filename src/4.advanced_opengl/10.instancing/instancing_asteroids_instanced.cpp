@@ -5,8 +5,10 @@
 #include <GLFW/glfw3.h>
 
 // GL includes
+#include <learnopengl/benchmark.h> // First, so the GL calls of the other headers are counted in benchmark builds
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/input_recorder.h>
 #include <learnopengl/model.h>
 
 // GLM Mathemtics
@@ -32,7 +34,7 @@ GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
 // The MAIN function, from here we start our application and run our Game loop
-int main()
+int main(int argc, char* argv[])
 {
     // Init GLFW
     glfwInit();
@@ -42,12 +44,19 @@ int main()
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+    // Built as a frame time benchmark the window is hidden and the camera follows a path, see FrameBenchmark
+    FrameBenchmark benchmark("instancing", argc, argv);
+    benchmark.WindowHints();
+    // Live, recorded or replayed input and clock, see InputRecorder
+    InputRecorder input(argc, argv);
+    benchmark.Attach(input);
     GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "LearnOpenGL", nullptr, nullptr); // Windowed
     glfwMakeContextCurrent(window);
 
     // Set the required callback functions
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    input.Attach(window);
 
     // Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);	
@@ -55,6 +64,7 @@ int main()
     // Initialize GLEW to setup the OpenGL Function pointers
     glewExperimental = GL_TRUE;
     glewInit();
+    benchmark.Start(window);
 
     // Define the viewport dimensions
     glViewport(0, 0, screenWidth, screenHeight);
@@ -82,7 +92,7 @@ int main()
     GLuint amount = 10;
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
-    srand(glfwGetTime()); // initialize random seed	
+    srand(input.Seed()); // initialize random seed
     GLfloat radius = 150.0f;
     GLfloat offset = 25.0f;
     for(GLuint i = 0; i < amount; i++)
@@ -140,16 +150,17 @@ int main()
     }
 
     // Game loop
-    while(!glfwWindowShouldClose(window))
+    while(!glfwWindowShouldClose(window) && benchmark.Running() && !input.Finished())
     {
-        // Set frame time
-        GLfloat currentFrame = glfwGetTime();
+        // Check and call events, live or replayed
+        input.PollEvents();
+
+        // Set frame time, on the recorder's clock
+        GLfloat currentFrame = input.Time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-
-        // Check and call events
-        glfwPollEvents();
         Do_Movement();
+        benchmark.PlaceCamera(camera);
 
         // Clear buffers
         glClearColor(0.03f, 0.03f, 0.03f, 1.0f);
@@ -181,7 +192,9 @@ int main()
         
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame();
     }
+    benchmark.Report();
 
     delete[] modelMatrices;
 
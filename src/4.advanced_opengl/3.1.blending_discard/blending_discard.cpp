@@ -10,6 +10,7 @@
 // GL includes
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/mip_builder.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -27,7 +28,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void Do_Movement();
-GLuint loadTexture(GLchar* path, GLboolean alpha = false);
+GLuint loadTexture(GLchar* path, GLboolean alpha = false, GLfloat alphaCutoff = 0.0f);
 
 // Camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -179,7 +180,7 @@ int main()
     // Load textures
     GLuint cubeTexture = loadTexture("resources/textures/wood.png");
     GLuint floorTexture = loadTexture("resources/textures/metal.png");
-    GLuint transparentTexture = loadTexture("resources/textures/grass.png", true);
+    GLuint transparentTexture = loadTexture("resources/textures/grass.png", true, 0.1f); // blending_discard.frag discards below 0.1
 #pragma endregion
 
     std::vector<glm::vec3> vegetation;
@@ -252,17 +253,19 @@ int main()
 // This function loads a texture from file. Note: texture loading functions like these are usually
 // managed by a 'Resource Manager' that manages all resources (like textures, models, audio).
 // For learning purposes we'll just define it as a utility function.
-GLuint loadTexture(GLchar* path, GLboolean alpha)
+// alphaCutoff is the alpha test threshold of textures drawn with discard, their mips keep the same coverage.
+GLuint loadTexture(GLchar* path, GLboolean alpha, GLfloat alphaCutoff)
 {
     //Generate texture ID and load texture data
     GLuint textureID;
     glGenTextures(1, &textureID);
     int width,height;
     unsigned char* image = SOIL_load_image(path, &width, &height, 0, alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+    std::vector<MipLevel> levels;
+    MipBuilder(MIP_FILTER_BOX, GL_FALSE, alpha ? alphaCutoff : 0.0f).Build(image, width, height, alpha ? 4 : 3, levels);
     // Assign texture to ID
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, alpha ? GL_RGBA : GL_RGB, width, height, 0, alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(levels, alpha ? GL_RGBA : GL_RGB, alpha ? GL_RGBA : GL_RGB);
 
     // Parameters
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT );	// Use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes value from next repeat
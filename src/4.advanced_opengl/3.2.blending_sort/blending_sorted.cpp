@@ -11,6 +11,7 @@
 // GL includes
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/oit.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -39,6 +40,10 @@ bool firstMouse = true;
 GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
+// Options
+GLboolean oitTransparency = true; // Change with 'O': weighted blended OIT vs. CPU sorted back-to-front drawing
+bool keysPressed[1024];
+
 // The MAIN function, from here we start our application and run our Game loop
 int main()
 {
@@ -74,7 +79,9 @@ int main()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Setup and compile our shaders
-    Shader shader("blending_sorted.vs", "blending_sorted.frag");
+    Shader shader("shaders/blending_sorted.vs", "shaders/blending_sorted.frag");
+    Shader oitShader("shaders/oit_windows.vs", "shaders/blending_oit.frag");
+    Shader oitCompositeShader("shaders/oit_composite.vs", "shaders/oit_composite.frag");
 
 #pragma region "object_initialization"
     // Set the object data (buffers, vertex attributes)
@@ -180,9 +187,9 @@ int main()
     glBindVertexArray(0);
 
     // Load textures
-    GLuint cubeTexture = loadTexture("../../../resources/textures/marble.jpg");
-    GLuint floorTexture = loadTexture("../../../resources/textures/metal.png");
-    GLuint transparentTexture = loadTexture("../../../resources/textures/window.png", true);
+    GLuint cubeTexture = loadTexture("resources/textures/marble.jpg");
+    GLuint floorTexture = loadTexture("resources/textures/metal.png");
+    GLuint transparentTexture = loadTexture("resources/textures/window.png", true);
 #pragma endregion
 
     std::vector<glm::vec3> windows;
@@ -192,6 +199,35 @@ int main()
     windows.push_back(glm::vec3(-0.3f,  0.0f, -2.3f));
     windows.push_back(glm::vec3( 0.5f,  0.0f, -0.6f));
 
+    // Per-instance window offsets for the unsorted OIT batch
+    GLuint windowInstanceVBO;
+    glGenBuffers(1, &windowInstanceVBO);
+    glBindVertexArray(transparentVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, windowInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, windows.size() * sizeof(glm::vec3), &windows[0], GL_STATIC_DRAW);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+
+    // The OIT targets need to share a depth buffer with the opaque pass, so the opaque scene is rendered offscreen
+    // and blitted to the window afterwards.
+    GLuint opaqueFBO, opaqueColor, opaqueDepth;
+    glGenFramebuffers(1, &opaqueFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+    glGenRenderbuffers(1, &opaqueColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, opaqueColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, screenWidth, screenHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, opaqueColor);
+    glGenRenderbuffers(1, &opaqueDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, opaqueDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, screenWidth, screenHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, opaqueDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    WeightedBlendedOIT oit(screenWidth, screenHeight, opaqueDepth);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
@@ -205,17 +241,11 @@ int main()
         Do_Movement();
 
         // Clear the colorbuffer
+        glBindFramebuffer(GL_FRAMEBUFFER, oitTransparency ? opaqueFBO : 0);
+        glViewport(0, 0, screenWidth, screenHeight);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Sort windows
-        std::map<GLfloat, glm::vec3> sorted;
-        for (GLuint i = 0; i < windows.size(); i++)
-        {
-            GLfloat distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
-        }
-
         // Draw objects
         shader.Use();
         glm::mat4 model;
@@ -239,17 +269,51 @@ int main()
         model = glm::mat4();
         glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        // Render windows (from furthest to nearest)
-        glBindVertexArray(transparentVAO);
-        glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+        if (oitTransparency)
         {
-            model = glm::mat4();
-            model = glm::translate(model, it->second);
-            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            // Render all windows in one unsorted instanced draw, order doesn't matter for the weighted blend
+            oit.BeginTransparent();
+            oitShader.Use();
+            glUniformMatrix4fv(glGetUniformLocation(oitShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(oitShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniform1i(glGetUniformLocation(oitShader.Program, "unlit"), GL_TRUE);
+            glBindVertexArray(transparentVAO);
+            glBindTexture(GL_TEXTURE_2D, transparentTexture);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, windows.size());
+            glBindVertexArray(0);
+            oit.EndTransparent();
+
+            // Resolve over the opaque image and present it
+            glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+            oit.Composite(oitCompositeShader);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, opaqueFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        else
+        {
+            // Sort windows
+            std::map<GLfloat, glm::vec3> sorted;
+            for (GLuint i = 0; i < windows.size(); i++)
+            {
+                GLfloat distance = glm::length(camera.Position - windows[i]);
+                sorted[distance] = windows[i];
+            }
+            // Render windows (from furthest to nearest)
+            glBindVertexArray(transparentVAO);
+            glBindTexture(GL_TEXTURE_2D, transparentTexture);
+            for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+            {
+                model = glm::mat4();
+                model = glm::translate(model, it->second);
+                glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            glBindVertexArray(0);
         }
-        glBindVertexArray(0);
 
 
         // Swap the buffers
@@ -300,6 +364,12 @@ void Do_Movement()
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (keys[GLFW_KEY_D])
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (keys[GLFW_KEY_O] && !keysPressed[GLFW_KEY_O])
+    {
+        oitTransparency = !oitTransparency;
+        keysPressed[GLFW_KEY_O] = true;
+    }
 }
 
 // Is called whenever a key is pressed/released via GLFW
@@ -312,7 +382,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         if (action == GLFW_PRESS)
             keys[key] = true;
         else if (action == GLFW_RELEASE)
+        {
             keys[key] = false;
+            keysPressed[key] = false;
+        }
     }
 }
 
@@ -12,6 +12,8 @@ using namespace std;
 // GL includes
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/post_process.h>
+#include <learnopengl/screen_quad.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -28,9 +30,9 @@ GLuint screenWidth = 800, screenHeight = 600;
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void Do_Movement();
 GLuint loadTexture(GLchar* path, GLboolean alpha = false);
-GLuint generateAttachmentTexture(GLboolean depth, GLboolean stencil);
 
 // Camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -49,7 +51,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
     GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "LearnOpenGL", nullptr, nullptr); // Windowed
@@ -59,6 +61,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     // Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);	
@@ -133,16 +136,6 @@ int main()
         -5.0f, -0.5f, -5.0f,  0.0f, 2.0f,
         5.0f,  -0.5f, -5.0f,  2.0f, 2.0f								
     };
-    GLfloat quadVertices[] = {   // Vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
-        // Positions   // TexCoords
-        -1.0f,  1.0f,  0.0f, 1.0f,
-        -1.0f, -1.0f,  0.0f, 0.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-
-        -1.0f,  1.0f,  0.0f, 1.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-         1.0f,  1.0f,  1.0f, 1.0f
-    };	
 
     // Setup cube VAO
     GLuint cubeVAO, cubeVBO;
@@ -168,18 +161,6 @@ int main()
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
     glBindVertexArray(0);
-    // Setup screen VAO
-    GLuint quadVAO, quadVBO;
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
-    glBindVertexArray(0);
 
     // Load textures
     GLuint cubeTexture = loadTexture("../../../resources/textures/container.jpg");
@@ -187,23 +168,36 @@ int main()
     #pragma endregion
 
     // Framebuffers
+    // The offscreen targets come from a pool that reallocates them whenever the window is resized
+    RenderTargetPool renderTargets(screenWidth, screenHeight);
     GLuint framebuffer;
     glGenFramebuffers(1, &framebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);  
     // Create a color attachment texture
-    GLuint textureColorbuffer = generateAttachmentTexture(false, false);
+    GLuint textureColorbuffer = renderTargets.Acquire(RenderTargetDesc(GL_RGB8));
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-    // Create a renderbuffer object for depth and stencil attachment (we won't be sampling these)
-    GLuint rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo); 
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, screenWidth, screenHeight); // Use a single renderbuffer object for both a depth AND stencil buffer.
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo); // Now actually attach it
+    // Use a single texture for both a depth AND stencil buffer
+    GLuint depthStencilBuffer = renderTargets.Acquire(RenderTargetDesc(GL_DEPTH24_STENCIL8, 1.0f, GL_NEAREST));
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthStencilBuffer, 0);
     // Now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Post-processing: a single pass drawing the quad plane with the attached screen texture
+    PostProcessChain postProcess(renderTargets);
+    postProcess.Import("scene", textureColorbuffer, screenWidth, screenHeight);
+    postProcess.AddPass("screen", { "scene" }, "", [&](const PostProcessContext& pass) {
+        // Clear all relevant buffers
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not really necessery actually, since we won't be able to see behind the quad anyways)
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_DEPTH_TEST); // We don't care about depth information when rendering a single quad
+
+        // Draw Screen
+        screenShader.Use();
+        glBindTexture(GL_TEXTURE_2D, pass.Inputs[0]);	// Use the color attachment texture as the texture of the quad plane
+        RenderScreenQuad();
+    });
     
 
     // Draw as wireframe
@@ -221,12 +215,19 @@ int main()
         glfwPollEvents();
         Do_Movement();
 
+        // Follow the window size, texture names stay the same so the framebuffer keeps its attachments
+        if (renderTargets.Width != screenWidth || renderTargets.Height != screenHeight)
+        {
+            renderTargets.Resize(screenWidth, screenHeight);
+            postProcess.Import("scene", textureColorbuffer, screenWidth, screenHeight);
+        }
         
         /////////////////////////////////////////////////////
         // Bind to framebuffer and draw to color texture 
         // as we normally would.
         // //////////////////////////////////////////////////
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, screenWidth, screenHeight);
         // Clear all attached buffers        
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // We're not using stencil buffer so why bother with clearing?
@@ -263,18 +264,7 @@ int main()
         // Bind to default framebuffer again and draw the 
         // quad plane with attched screen texture.
         // //////////////////////////////////////////////////
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        // Clear all relevant buffers
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not really necessery actually, since we won't be able to see behind the quad anyways)
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST); // We don't care about depth information when rendering a single quad
-
-        // Draw Screen
-        screenShader.Use();
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);	// Use the color attachment texture as the texture of the quad plane
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        postProcess.Execute();
 
 
         // Swap the buffers
@@ -313,33 +303,6 @@ GLuint loadTexture(GLchar* path, GLboolean alpha)
     return textureID;
 }
 
-// Generates a texture that is suited for attachments to a framebuffer
-GLuint generateAttachmentTexture(GLboolean depth, GLboolean stencil)
-{
-    // What enum to use?
-    GLenum attachment_type;
-    if(!depth && !stencil)
-        attachment_type = GL_RGB;
-    else if(depth && !stencil)
-        attachment_type = GL_DEPTH_COMPONENT;
-    else if(!depth && stencil)
-        attachment_type = GL_STENCIL_INDEX;
-
-    //Generate texture ID and load texture data 
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    if(!depth && !stencil)
-        glTexImage2D(GL_TEXTURE_2D, 0, attachment_type, screenWidth, screenHeight, 0, attachment_type, GL_UNSIGNED_BYTE, NULL);
-    else // Using both a stencil and depth test, needs special format arguments
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, screenWidth, screenHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return textureID;
-}
-
 #pragma region "User input"
 
 // Moves/alters the camera positions based on user input
@@ -391,4 +354,14 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(yoffset);
 }
 
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // Minimized windows report a 0x0 framebuffer, keep the last size
+    if (width > 0 && height > 0)
+    {
+        screenWidth = width;
+        screenHeight = height;
+    }
+}
+
 #pragma endregion
@@ -5,9 +5,24 @@
 #include <GLFW/glfw3.h>
 
 // GL includes
+#include <learnopengl/benchmark.h> // First, so the GL calls of the other headers are counted in benchmark builds
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/input_recorder.h>
 #include <learnopengl/model.h>
+#include <learnopengl/texture_streamer.h>
+#include <learnopengl/texture_residency.h>
+#include <learnopengl/material_batch.h>
+#include <learnopengl/oit.h>
+#include <learnopengl/bloom.h>
+#include <learnopengl/auto_exposure.h>
+#include <learnopengl/taa.h>
+#include <learnopengl/post_process.h>
+#include <learnopengl/render_graph.h>
+#include <learnopengl/cascaded_shadows.h>
+#include <learnopengl/shadow_cache.h>
+#include <learnopengl/point_shadows.h>
+#include <learnopengl/clustered_lights.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -30,13 +45,19 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void Do_Movement();
-GLuint loadTexture(string path, GLboolean alpha = false);
+GLuint loadTexture(string path, GLboolean alpha = false, GLfloat alphaCutoff = 0.0f);
 void RenderScene(Shader &shader);
-void RenderCube();
+const std::vector<glm::mat4>& SceneCubeModels();
+glm::mat4 ElevatorModel();
+PointShadowCaster CubeCaster(const glm::mat4& model, GLboolean dynamic);
+void RenderCube(GLsizei instances = 1);
 void RenderQuad();
 
 void RenderFloor1(Shader&);
 void RenderModels(Shader &);
+std::vector<std::pair<Model*, glm::mat4> > StaticModelInstances();
+glm::mat4 WellModel();
+void RenderElevator(Shader &);
 void RenderGrass(Shader &);
 void RenderFlame(Shader &);
 void initFloor1();
@@ -141,12 +162,31 @@ Model* wheel;
 
 Model* logicCube;
 
+TextureStreamer* textureStreamer;
+TextureResidency* textureResidency; // Mip levels of the model textures by screen size, within TEXTURE_BUDGET with the batch's arrays
+const GLsizeiptr TEXTURE_BUDGET = 24 << 20;
+MaterialBatch* staticModels; // The models that never move, in one draw call
+InputRecorder* inputRecorder; // Live, recorded or replayed input and the clock the scene animates on
+
 vector<glm::vec3> fences;
 
 
 // Options
 GLboolean bloom = true; // Change with 'Space'
 GLfloat exposure = 1.0f; // Change with Q and E
+GLfloat exposureCompensation = 0.0f; // Stops added to the auto exposure, change with Q and E while it is on
+GLboolean autoExposureEnabled = true; // Change with 'X'
+GLboolean oitTransparency = true; // Change with 'O'
+enum AntiAliasing { AA_NONE, AA_FXAA, AA_TAA };
+GLuint antiAliasing = AA_FXAA; // FXAA on the tonemapped image or temporal AA on the HDR scene, cycle with 'F'
+GLboolean printTimings = false; // Print the render graph timings with 'T'
+GLboolean manyLights = false; // Add a thousand small unshadowed lights with 'L'
+GLboolean batchModels = true; // Draw the static models as one batch or one by one, toggle with 'M'
+
+// Camera matrices, computed once per frame and shared by every pass
+glm::mat4 cameraProjection;
+glm::mat4 cameraCullProjection; // Without the TAA jitter, for the CPU side: culling, light clusters, texture residency
+glm::mat4 cameraView;
 
 glm::vec3 teleport_room_position(7.81814,  0.520741 , -0.166235);
 glm::vec3 positions_to_teleport[]={glm::vec3(-0.173773  ,0.515819 , -1.0192),
@@ -158,7 +198,7 @@ Camera camera(teleport_room_position);
 
 
 bool enableCollision=false;
-int main()
+int main(int argc, char* argv[])
 {
     // Init GLFW
     glfwInit();
@@ -168,6 +208,12 @@ int main()
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+    // Built as a frame time benchmark the window is hidden and the camera follows a path, see FrameBenchmark
+    FrameBenchmark benchmark("shadow_mapping", argc, argv);
+    benchmark.WindowHints();
+    // Live, recorded or replayed input and clock, see InputRecorder
+    inputRecorder = new InputRecorder(argc, argv);
+    benchmark.Attach(*inputRecorder);
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", nullptr, nullptr); // Windowed
     glfwMakeContextCurrent(window);
 
@@ -175,6 +221,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    inputRecorder->Attach(window);
 
     // Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -182,6 +229,7 @@ int main()
     // Initialize GLEW to setup the OpenGL Function pointers
     glewExperimental = GL_TRUE;
     glewInit();
+    benchmark.Start(window);
 
     // Define the viewport dimensions
     glViewport(0, 0, SCR_WIDTH*2, SCR_HEIGHT*2);
@@ -189,6 +237,10 @@ int main()
     // Setup some OpenGL options
     glEnable(GL_DEPTH_TEST);
 
+    // Scene textures are streamed in by loadTexture(), at most 4 MB a frame
+    textureStreamer = new TextureStreamer(32 << 20, 4 << 20);
+    textureResidency = new TextureResidency(*textureStreamer, TEXTURE_BUDGET);
+
     // Setup and compile our shaders
     Shader shader1("shaders/bloom.vs", "shaders/bloom.frag");
 
@@ -200,6 +252,8 @@ int main()
     Shader floor1_shader("shaders/depth_testing.vs", "shaders/depth_testing.frag");
     Shader model_shader("shaders/model_shader.vs", "shaders/model_shader.frag");
     Shader grass_shader("shaders/blending_discard.vs", "shaders/blending_discard.frag");
+    Shader grass_oit_shader("shaders/blending_discard.vs", "shaders/blending_oit.frag");
+    Shader oitCompositeShader("shaders/oit_composite.vs", "shaders/oit_composite.frag");
     Shader flame_shader("shaders/flame.vs", "shaders/flame.frag");
     Shader particle_shader("shaders/fire.vs", "shaders/fire.frag");
 
@@ -207,8 +261,8 @@ int main()
     // Setup and compile our shaders
     Shader shader("shaders/bloom.vs", "shaders/bloom.frag");
     Shader shaderLight("shaders/bloom.vs", "shaders/light_box.frag");
-    Shader shaderBlur("shaders/blur.vs", "shaders/blur.frag");
     Shader shaderBloomFinal("shaders/bloom_final.vs", "shaders/bloom_final.frag");
+    Shader shaderFXAA("shaders/bloom_final.vs", "shaders/fxaa.frag");
 
     // Set texture samples
     shaderShadow.Use();
@@ -247,42 +301,27 @@ int main()
     // Load textures
     woodTexture = loadTexture("resources/textures/wood.png");
 
-    // Configure depth map FBO
-    const GLuint SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-    GLuint depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
-    // - Create depth texture
-    GLuint depthMap;
-    glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Cascaded shadow maps: 4 cascades of 2048x2048 covering the view up to SHADOW_DISTANCE
+    const GLfloat SHADOW_DISTANCE = 50.0f;
+    CascadedShadowMap shadowCascades(2048, 4);
+    // Only the elevator platform moves: cache the rest of the casters and let the light's shadow follow it every 4th frame
+    ShadowCache shadowCache(shadowCascades.DepthArray, shadowCascades.Resolution, shadowCascades.CascadeCount,
+                            CascadedShadowMap::DEPTH_FORMAT, 4);
+    glm::vec3 shadowLightDirection = -lightPos;
 
     glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
 
     /*-------------------Load models--------------------*/
 
     //    monster = new Model("resources/objects/nanosuit/nanosuit.obj");
-    floor1 = new Model("resources/objects/floor1/house.obj");
+    floor1 = new Model("resources/objects/floor1/house.obj", false, textureResidency);
     logicFloor1 =new Model("resources/objects/floor1/house_base.obj");
-    grass = new Model("resources/objects/grass/Grass-small.obj");
-    fence = new Model("resources/objects/fence/fence.obj");
+    grass = new Model("resources/objects/grass/Grass-small.obj", false, NULL, 0.1f); // blending_discard.frag discards below 0.1
+    fence = new Model("resources/objects/fence/fence.obj", false, textureResidency);
     moon = new Model("resources/objects/floor1/moon.obj");
-    tree = new Model("resources/objects/grass/tree.obj");
-    well = new Model("resources/objects/elevator/well.obj");
-    wheel = new Model("resources/objects/elevator/wheel.obj");
+    tree = new Model("resources/objects/grass/tree.obj", false, textureResidency);
+    well = new Model("resources/objects/elevator/well.obj", false, textureResidency);
+    wheel = new Model("resources/objects/elevator/wheel.obj", false, textureResidency);
     logicCube = new Model("resources/objects/cube/cube.obj");
 
     /*--------------------------------------------------*/
@@ -301,6 +340,14 @@ int main()
     fences.push_back(glm::vec3(7.0f, FLOOR1_Y - 1.0, 16.0f));
     fences.push_back(glm::vec3(4.0f, FLOOR1_Y - 1.0, 10.5f));
 
+    staticModels = new MaterialBatch();
+    std::vector<std::pair<Model*, glm::mat4> > staticInstances = StaticModelInstances();
+    for (GLuint i = 0; i < staticInstances.size(); i++)
+        staticModels->Add(*staticInstances[i].first, staticInstances[i].second);
+    staticModels->Build();
+    // The arrays stay fully resident, so they come out of the texture budget before anything is streamed
+    textureResidency->ReservedBytes = staticModels->Arrays.MemoryBytes();
+
 
 
     //_______
@@ -331,86 +378,140 @@ int main()
     lightColors.push_back(glm::vec3(0.0f, 0.0f, 50.5f));
     lightColors.push_back(glm::vec3(0.0f, 51.5f, 0.0f));
 
+    // Omnidirectional shadows for all the point lights in one 4096x4096 atlas, every light's cube faces get
+    // between 64x64 and 1024x1024 texels depending on how large the light is on screen
+    const GLfloat POINT_LIGHT_RADIUS = 12.0f;
+    std::vector<GLfloat> lightRadii(lightPositions.size(), POINT_LIGHT_RADIUS);
+    PointShadowAtlas pointShadows(4096, lightPositions.size(), 64, 1024);
+    pointShadows.SetLightCount(lightPositions.size());
+    for (GLuint i = 0; i < lightPositions.size(); i++)
+        pointShadows.SetLight(i, lightPositions[i], lightRadii[i]);
+
+    // All point lights go through clustered forward shading, so fragments only loop over the lights near them.
+    // The shadowed lights come first, followed by 1024 small lights scattered through the rooms when enabled.
+    ClusteredLights clusteredLights(SCR_WIDTH, SCR_HEIGHT, 0.1f, 100.0f);
+    std::vector<glm::vec3> smallLightPositions, smallLightColors;
+    std::vector<GLfloat> smallLightRadii;
+    for (GLuint i = 0; i < 1024; i++)
+    {
+        GLfloat x = -5.0f + 20.0f * (rand() % 1000) / 1000.0f;
+        GLfloat y = 0.2f + 4.3f * (rand() % 1000) / 1000.0f;
+        GLfloat z = -20.0f + 44.0f * (rand() % 1000) / 1000.0f;
+        glm::vec3 color = glm::vec3((rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f) * 0.4f + 0.1f;
+        smallLightPositions.push_back(glm::vec3(x, y, z));
+        smallLightColors.push_back(color);
+        smallLightRadii.push_back(ClusteredLights::LightRadius(color));
+    }
+    std::vector<glm::vec3> clusterPositions, clusterColors;
+    std::vector<GLfloat> clusterRadii;
+
+    // Screen sized render targets all come from one pool so post-process passes can share their memory
+    RenderTargetPool renderTargets(SCR_WIDTH, SCR_HEIGHT);
 
     // Set up floating point framebuffer to render scene to
     GLuint hdrFBO;
     glGenFramebuffers(1, &hdrFBO);
     glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    // - Floating point color buffer, held for the whole run. The bloom chain thresholds it itself so no separate brightness buffer is needed
+    GLuint colorBuffer = renderTargets.Acquire(RenderTargetDesc(GL_RGB16F));
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
 
-    //glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    // - Create 2 floating point color buffers (1 for normal rendering, other for brightness treshold values)
-    GLuint colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (GLuint i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // We clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-
-    // - Create and attach depth buffer (renderbuffer)
-    GLuint rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // - Tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
+    // - Depth buffer as a texture, the temporal anti-aliasing reprojects the history with it
+    GLuint depthBuffer = renderTargets.Acquire(RenderTargetDesc(GL_DEPTH_COMPONENT24, 1.0f, GL_NEAREST));
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthBuffer, 0);
     // - Finally check if framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // Ping pong framebuffer for blurring
-    GLuint pingpongFBO[2];
-    GLuint pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (GLuint i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // We clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // Also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
-
-
+    // Downsample/upsample chain for the bloom (1/2 ... 1/64 of the HDR resolution)
+    BloomRenderer bloomRenderer(SCR_WIDTH, SCR_HEIGHT);
+    // Exposure adapted to the luminance the bloom chain measures
+    AutoExposure autoExposure;
+
+    // Accumulation targets for the order-independent transparency pass, depth tested against the HDR scene depth
+    WeightedBlendedOIT oit(SCR_WIDTH, SCR_HEIGHT, depthBuffer, GL_TEXTURE_2D);
+    // History targets of the temporal anti-aliasing
+    TemporalAA temporalAA(SCR_WIDTH, SCR_HEIGHT);
+
+    // Post-processing: HDR scene -> bloom -> tonemapped to the screen, or with FXAA tonemapped to an LDR target
+    // that is anti-aliased to the screen. FXAA works on the final colors, so the HDR targets stay single sampled
+    // instead of 4x MSAA float buffers (4x the memory and bandwidth of every HDR attachment).
+    // With TAA the HDR scene is resolved against its history first and everything after works on the result.
+    PostProcessChain postProcess(renderTargets);
+    postProcess.Import("scene", colorBuffer, SCR_WIDTH, SCR_HEIGHT);
+    postProcess.Import("depth", depthBuffer, SCR_WIDTH, SCR_HEIGHT);
+    postProcess.Import("bloom", bloomRenderer.BloomTexture(), SCR_WIDTH / 2, SCR_HEIGHT / 2);
+    // 1. Camera motion of every pixel, then blend the jittered scene into the reprojected history.
+    // "taa" is imported again every frame as its target alternates.
+    postProcess.AddPass("velocity", { "depth" }, "velocity", RenderTargetDesc(GL_RG16F, 1.0f, GL_NEAREST), [&](const PostProcessContext& pass) {
+        temporalAA.RenderVelocity(pass.Inputs[0]);
+    });
+    postProcess.AddPass("taa", { "scene", "depth", "velocity" }, "taa", [&](const PostProcessContext& pass) {
+        temporalAA.Resolve(pass.Inputs[0], pass.Inputs[1], pass.Inputs[2]);
+    });
+    // 2. Threshold and blur bright fragments through the downsample/upsample chain, which also measures the
+    // scene luminance for the auto exposure
+    postProcess.AddPass("bloom", { "taa" }, "bloom", [&](const PostProcessContext& pass) {
+        bloomRenderer.Render(pass.Inputs[0], SCR_WIDTH, SCR_HEIGHT);
+        if (autoExposureEnabled)
+        {
+            autoExposure.Compensation = exposureCompensation;
+            autoExposure.Update(bloomRenderer.LuminanceTexture(), SCR_WIDTH / 2, SCR_HEIGHT / 2, deltaTime);
+        }
+    });
+    // 3. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
+    PostProcessChain::PassFunction tonemap = [&](const PostProcessContext& pass) {
+        shaderBloomFinal.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, pass.Inputs[0]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, pass.Inputs[1]);
+        glUniform1i(glGetUniformLocation(shaderBloomFinal.Program, "bloom"), bloom);
+        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "exposure"), autoExposureEnabled ? autoExposure.Exposure : exposure);
+        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "bloomIntensity"), bloomRenderer.CompositeWeight());
+        RenderQuad();
+    };
+    postProcess.AddPass("tonemap", { "taa", "bloom" }, "", tonemap);
+    postProcess.AddPass("tonemap-ldr", { "taa", "bloom" }, "ldr", RenderTargetDesc(GL_RGBA8), tonemap);
+    // 4. Anti-alias the tonemapped image to the screen
+    postProcess.AddPass("fxaa", { "ldr" }, "", [&](const PostProcessContext& pass) {
+        shaderFXAA.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, pass.Inputs[0]);
+        glUniform1i(glGetUniformLocation(shaderFXAA.Program, "screenTexture"), 0);
+        glUniform2f(glGetUniformLocation(shaderFXAA.Program, "inverseScreenSize"), 1.0f / pass.Width, 1.0f / pass.Height);
+        RenderQuad();
+    });
+    renderTargets.PrintStats();
 
-    shaderShadow.Use();
+    // The frame is described as a render graph, these are the framebuffers its passes write
+    RenderGraph frameGraph;
+    frameGraph.AddTarget("shadowMap", shadowCascades.FBO, shadowCascades.Resolution, shadowCascades.Resolution); // Cleared per cascade
+    frameGraph.AddTarget("pointShadows", pointShadows.FBO, pointShadows.AtlasSize, pointShadows.AtlasSize); // Cleared per tile
+    frameGraph.AddTarget("hdr", hdrFBO, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    frameGraph.AddTarget("backbuffer", 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glClearColor(0.0f,0.0f,0.0f,1.0f);
 
+    GLint shownTenthsMB = -1;
 
     // Game loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && benchmark.Running() && !inputRecorder->Finished())
     {
-        // Set frame time
-        GLfloat currentFrame = glfwGetTime();
+        // Check and call events, live or replayed
+        inputRecorder->PollEvents();
+
+        // Set frame time, on the recorder's clock
+        GLfloat currentFrame = inputRecorder->Time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-
-        // Check and call events
-        glfwPollEvents();
+        textureStreamer->Update();
 
         Camera precedentCamera=camera.cameraPhoto();
         if(!checkTeleports(lightPositions))
             Do_Movement();
+        benchmark.PlaceCamera(camera);
 
-        glViewport(0, 0, SCR_WIDTH*2, SCR_HEIGHT*2);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         if(enableCollision && (detectCubeCollision()|| detectModelCollision() ))
         {
             camera=precedentCamera;
@@ -418,182 +519,219 @@ int main()
         }
 
 
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glm::mat4 projection = glm::perspective(camera.Zoom, (GLfloat)SCR_WIDTH / (GLfloat)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
+        // Per frame state shared by the passes
+        // Only rasterization uses the jittered projection, the CPU side would see a new matrix every frame
+        cameraCullProjection = camera.GetProjectionMatrix((GLfloat)SCR_WIDTH / (GLfloat)SCR_HEIGHT, 0.1f, 100.0f);
+        if (antiAliasing == AA_TAA)
+            cameraProjection = temporalAA.BeginFrame(camera, 0.1f, 100.0f);
+        else
+        {
+            cameraProjection = cameraCullProjection;
+            temporalAA.Reset();
+        }
+        cameraView = camera.GetViewMatrix();
+        textureResidency->BeginFrame(cameraView, cameraCullProjection, SCR_HEIGHT);
         glm::mat4 model;
         shader.Use();
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glActiveTexture(GL_TEXTURE0);
-        // - set lighting uniforms
-        for (GLuint i = 0; i < lightPositions.size(); i++)
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(cameraProjection));
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(cameraView));
+        // - sort the lights into the clusters of this frame's view
+        clusterPositions = lightPositions;
+        clusterColors = lightColors;
+        clusterRadii = lightRadii;
+        if (manyLights)
         {
-            glUniform3fv(glGetUniformLocation(shader.Program, ("lights[" + std::to_string(i) + "].Position").c_str()), 1, &lightPositions[i][0]);
-            glUniform3fv(glGetUniformLocation(shader.Program, ("lights[" + std::to_string(i) + "].Color").c_str()), 1, &lightColors[i][0]);
+            clusterPositions.insert(clusterPositions.end(), smallLightPositions.begin(), smallLightPositions.end());
+            clusterColors.insert(clusterColors.end(), smallLightColors.begin(), smallLightColors.end());
+            clusterRadii.insert(clusterRadii.end(), smallLightRadii.begin(), smallLightRadii.end());
         }
+        clusteredLights.Update(clusterPositions, clusterColors, clusterRadii, cameraView, cameraCullProjection);
+        clusteredLights.SetUniforms(shader, 3);
         glUniform3fv(glGetUniformLocation(shader.Program, "viewPos"), 1, &camera.Position[0]);
 
         /********************************ORIGINALE**************************/
         // Change light position over time
-        lightPos.z = cos(glfwGetTime()) * 2.0f;
+        lightPos.z = cos(inputRecorder->Time()) * 2.0f;
+
+        // The light shines from lightPos towards the origin, fit the cascades around what the camera sees of it.
+        // The shadow only picks up the new light direction on the cache's update frames, in between the static casters stay cached.
+        if (shadowCache.BeginFrame())
+            shadowLightDirection = -lightPos;
+        shadowCascades.Update(cameraView, camera.Zoom, (GLfloat)SCR_WIDTH / (GLfloat)SCR_HEIGHT, 0.1f, SHADOW_DISTANCE, shadowLightDirection);
+
+        // 1. Render depth of scene to texture (from light's perspective), culled by the graph while shadows are disabled.
+        // The elevator only goes into the cascades its bounds reach.
+        PointShadowCaster elevatorBounds = CubeCaster(ElevatorModel(), GL_TRUE);
+        std::vector<glm::vec4> dynamicBounds(1, glm::vec4(elevatorBounds.Center, elevatorBounds.Radius));
+        frameGraph.AddPass("shadow depth", {}, "shadowMap", [&]() {
+            shadowCascades.Render(shadowCache, simpleDepthShader,
+                [](Shader& depthShader) { RenderScene(depthShader); },
+                dynamicBounds,
+                [](Shader& depthShader) { RenderElevator(depthShader); });
+        });
+
+        // 1b. Point light shadows: the static cubes and the moving elevator platform, culled per cube face.
+        // Resize the lights' atlas tiles first, lights close to the camera get the most texels.
+        pointShadows.Allocate(camera.Position, camera.Zoom, SCR_HEIGHT);
+        std::vector<PointShadowCaster> pointCasters;
+        for (GLuint i = 0; i < SceneCubeModels().size(); i++)
+            pointCasters.push_back(CubeCaster(SceneCubeModels()[i], GL_FALSE));
+        pointCasters.push_back(CubeCaster(ElevatorModel(), GL_TRUE));
+        frameGraph.AddPass("point shadow depth", {}, "pointShadows", [&]() {
+            pointShadows.Render(pointCasters);
+        });
 
         // 2. Render scene as normal
-        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-        shaderShadow.Use();
-
-        RenderModels(model_shader);
-
-        // 1. Render depth of scene to texture (from light's perspective)
-        glm::mat4 lightProjection, lightView;
-        glm::mat4 lightSpaceMatrix;
-        GLfloat near_plane = 1.0f, far_plane = 7.5f;
-        lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-        lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(1.0));
-        lightSpaceMatrix = lightProjection * lightView;
-
-        // - now render scene from light's point of view
-        simpleDepthShader.Use();
-        glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.Program, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        RenderScene(simpleDepthShader);
-        //RenderModels(simpleDepthShader);
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-
-
-        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-
-        shaderShadow.Use();
-        projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        view = camera.GetViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        // Set light uniforms
-        glUniform3fv(glGetUniformLocation(shaderShadow.Program, "lightPos"), 1, &lightPos[0]);
-        glUniform3fv(glGetUniformLocation(shaderShadow.Program, "viewPos"), 1, &camera.Position[0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
-        // Enable/Disable shadows by pressing 'SPACE'
-        glUniform1i(glGetUniformLocation(shaderShadow.Program, "shadows"), shadows);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-
-        // ******************* 1st Room cube ************ //
-        model=glm::mat4();
-        model = glm::scale(model, glm::vec3(10.0,6.9,10));
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
-        RenderCube();
-        glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 0); // And of course disable it
-        // ******************* end 1st Room cube ************ //
-
-
-        // ******************* 2nd Room cube ************ //
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(10.3f, 1.5, 0.f));
-        model = glm::scale(model, glm::vec3(10.0,3.9,10));
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D,floorTexture);
-        RenderCube();
-        glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 0); // And of course disable it
-        // ******************* end 2nd Room cube ************ //
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D,woodTexture);
-        RenderScene(shaderShadow);
-        RenderFloor1(floor1_shader);
-
-
-        // ******************* Sky cube************ //
+        std::vector<std::string> opaqueReads;
+        if (shadows)
+        {
+            opaqueReads.push_back("shadowMap");
+            opaqueReads.push_back("pointShadows");
+        }
+        frameGraph.AddPass("opaque", opaqueReads, "hdr", [&]() {
+            RenderModels(model_shader);
+
+            shaderShadow.Use();
+            glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "projection"), 1, GL_FALSE, glm::value_ptr(cameraProjection));
+            glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "view"), 1, GL_FALSE, glm::value_ptr(cameraView));
+            // Set light uniforms
+            glUniform3fv(glGetUniformLocation(shaderShadow.Program, "lightPos"), 1, &lightPos[0]);
+            glUniform3fv(glGetUniformLocation(shaderShadow.Program, "viewPos"), 1, &camera.Position[0]);
+            // Enable/Disable shadows by pressing 'SPACE'
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "shadows"), shadows);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            shadowCascades.SetUniforms(shaderShadow, 1);
+            pointShadows.SetUniforms(shaderShadow, 2);
+            clusteredLights.SetUniforms(shaderShadow, 3);
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "pointShadowCount"), lightPositions.size());
+
+            // ******************* 1st Room cube ************ //
+            model=glm::mat4();
+            model = glm::scale(model, glm::vec3(10.0,6.9,10));
+            glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+            RenderCube();
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 0); // And of course disable it
+            // ******************* end 1st Room cube ************ //
 
-        shaderCube.Use();
-        projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        view = camera.GetViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
 
-        // Room cube
-        model =glm::mat4();
-        model = glm::scale(model, glm::vec3(100.0,100.9,100));
-        glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            // ******************* 2nd Room cube ************ //
+            model = glm::mat4();
+            model = glm::translate(model, glm::vec3(10.3f, 1.5, 0.f));
+            model = glm::scale(model, glm::vec3(10.0,3.9,10));
+            glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D,floorTexture);
+            RenderCube();
+            glUniform1i(glGetUniformLocation(shaderShadow.Program, "reverse_normals"), 0); // And of course disable it
+            // ******************* end 2nd Room cube ************ //
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D,woodTexture);
+            RenderScene(shaderShadow);
+            RenderFloor1(floor1_shader);
 
-        RenderCube();
-        // ******************* end Sky cube************ //
 
+            // ******************* Sky cube************ //
 
-        // Set light uniforms
-        lightProjection = glm::perspective(45.0f, (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT, 1.0f, 2.0f);
-        lightView = glm::lookAt(scndlightPos, glm::vec3(0.0f), glm::vec3(1.0));
-        lightSpaceMatrix = lightProjection * lightView;
-        glUniform3fv(glGetUniformLocation(grass_shader.Program, "lightPos"), 1, &scndlightPos[0]);
-        glUniformMatrix4fv(glGetUniformLocation(grass_shader.Program, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+            shaderCube.Use();
+            glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "projection"), 1, GL_FALSE, glm::value_ptr(cameraProjection));
+            glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "view"), 1, GL_FALSE, glm::value_ptr(cameraView));
 
+            // Room cube
+            model =glm::mat4();
+            model = glm::scale(model, glm::vec3(100.0,100.9,100));
+            glUniformMatrix4fv(glGetUniformLocation(shaderCube.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
 
-        //Draw the moon
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(2.0f, 20.0f, 2.0f)); // Translate it down a bit so it's at the center of the scene
-        model = glm::scale(model, glm::vec3(0.01f, 0.01f, 0.01f));	// It's a bit too big for our scene, so scale it down
-        glUniformMatrix4fv(glGetUniformLocation(shaderShadow.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        // moon->Draw(shader);
+            RenderCube();
+            // ******************* end Sky cube************ //
 
+            //RenderFlame(flame_shader);
 
-        RenderGrass(grass_shader);
-        //RenderFlame(flame_shader);
+            // - finally show all the light sources as bright cubes
+            shaderLight.Use();
+            glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "projection"), 1, GL_FALSE, glm::value_ptr(cameraProjection));
+            glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "view"), 1, GL_FALSE, glm::value_ptr(cameraView));
 
-        // - finally show all the light sources as bright cubes
-        shaderLight.Use();
-        glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            for (GLuint i = 0; i < lightPositions.size(); i++)
+            {
+                model = glm::mat4();
+                model = glm::translate(model, glm::vec3(lightPositions[i]));
+                model = glm::scale(model, glm::vec3(0.5f));
+                glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+                glUniform3fv(glGetUniformLocation(shaderLight.Program, "lightColor"), 1, &lightColors[i][0]);
+                RenderCube();
+            }
+        });
 
-        for (GLuint i = 0; i < lightPositions.size(); i++)
+        // 3. Transparent geometry goes last, after every opaque object
+        frameGraph.AddPass("transparent", {}, "hdr", [&]() {
+            if (oitTransparency)
+            {
+                // The grass field is drawn as one unsorted instanced batch into the OIT targets and resolved over the HDR color
+                grass_oit_shader.Use();
+                glUniform3fv(glGetUniformLocation(grass_oit_shader.Program, "lightPos"), 1, &scndlightPos[0]);
+                glUniform3fv(glGetUniformLocation(grass_oit_shader.Program, "viewPos"), 1, &camera.Position[0]);
+                oit.BeginTransparent();
+                RenderGrass(grass_oit_shader);
+                oit.EndTransparent();
+
+                glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+                oit.Composite(oitCompositeShader);
+            }
+            else
+            {
+                grass_shader.Use();
+                glUniform3fv(glGetUniformLocation(grass_shader.Program, "lightPos"), 1, &scndlightPos[0]);
+                RenderGrass(grass_shader);
+            }
+        });
+
+        // 4. Bloom and tonemapping
+        frameGraph.AddPass("post-process", { "hdr" }, "backbuffer", [&]() {
+            postProcess.SetEnabled("bloom", bloom || autoExposureEnabled);
+            postProcess.Import("taa", temporalAA.OutputTexture(), SCR_WIDTH, SCR_HEIGHT);
+            postProcess.SetEnabled("velocity", antiAliasing == AA_TAA);
+            postProcess.SetEnabled("taa", antiAliasing == AA_TAA);
+            postProcess.SetEnabled("tonemap", antiAliasing != AA_FXAA);
+            postProcess.SetEnabled("tonemap-ldr", antiAliasing == AA_FXAA);
+            postProcess.SetEnabled("fxaa", antiAliasing == AA_FXAA);
+            postProcess.Execute();
+        });
+
+        frameGraph.Execute("backbuffer");
+        textureResidency->Update();
+        // Texture memory against its budget, in the title as it changes
+        GLint residentTenthsMB = (GLint)((textureResidency->ResidentBytes + textureResidency->ReservedBytes) * 10 / (1 << 20));
+        if (residentTenthsMB != shownTenthsMB)
         {
-            model = glm::mat4();
-            model = glm::translate(model, glm::vec3(lightPositions[i]));
-            model = glm::scale(model, glm::vec3(0.5f));
-            glUniformMatrix4fv(glGetUniformLocation(shaderLight.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3fv(glGetUniformLocation(shaderLight.Program, "lightColor"), 1, &lightColors[i][0]);
-            RenderCube();
+            std::string title = "LearnOpenGL - textures " + std::to_string(residentTenthsMB / 10) + "." + std::to_string(residentTenthsMB % 10)
+                              + " / " + std::to_string(TEXTURE_BUDGET >> 20) + " MB";
+            glfwSetWindowTitle(window, title.c_str());
+            shownTenthsMB = residentTenthsMB;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2. Blur bright fragments w/ two-pass Gaussian Blur
-        GLboolean horizontal = true, first_iteration = true;
-        GLuint amount = 10;
-        shaderBlur.Use();
-        for (GLuint i = 0; i < amount; i++)
+        if (printTimings)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            glUniform1i(glGetUniformLocation(shaderBlur.Program, "horizontal"), horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-            RenderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+            frameGraph.PrintTimings();
+            shadowCache.PrintStats("sun");
+            pointShadows.PrintStats();
+            clusteredLights.PrintStats();
+            textureStreamer->PrintStats();
+            textureResidency->PrintStats();
+            if (batchModels)
+                staticModels->PrintStats();
+            if (autoExposureEnabled)
+                autoExposure.PrintStats();
+            printTimings = false;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        shaderBloomFinal.Use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        glUniform1i(glGetUniformLocation(shaderBloomFinal.Program, "bloom"), bloom);
-        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "exposure"), exposure);
-        RenderQuad();
 
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(&frameGraph);
     }
+    benchmark.Report(&frameGraph);
 
     //    delete monster;
     delete floor1;
@@ -601,6 +739,10 @@ int main()
     delete moon;
     delete fence;
     delete tree;
+    delete staticModels;
+    delete textureResidency;
+    delete textureStreamer;
+    delete inputRecorder;
 
     glfwTerminate();
     return 0;
@@ -1014,7 +1156,7 @@ void initGrass(){
     // Generate a large list of semi-random model transformation matrices
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[NUM_INSTANCES];
-    srand(glfwGetTime()); // initialize random seed
+    srand(inputRecorder->Seed()); // initialize random seed
     for(GLuint i = 0; i < NUM_INSTANCES; i++)
     {
         glm::mat4 model;
@@ -1062,8 +1204,8 @@ void RenderGrass(Shader& shader){
     shader.Use();
 
     glm::mat4 model;
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = cameraView;
+    glm::mat4 projection = cameraProjection;
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
@@ -1128,8 +1270,8 @@ void RenderFlame(Shader& shader){
 
     shader.Use();
     glm::mat4 model;
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = cameraView;
+    glm::mat4 projection = cameraProjection;
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
@@ -1153,8 +1295,8 @@ void RenderFloor1(Shader &shader){
 
     shader.Use();
     glm::mat4 model;
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH/(float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = cameraView;
+    glm::mat4 projection = cameraProjection;
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
@@ -1173,74 +1315,89 @@ void RenderModels(Shader &shader){
     // Draw objects
     shader.Use();
 
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH/(float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = cameraView;
+    glm::mat4 projection = cameraProjection;
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-    // Draw the loaded model
-    glm::mat4 model;
-    model = glm::translate(model, glm::vec3(2.0f, FLOOR1_Y+FLOOR_OFFSET, 2.0f)); // Translate it down a bit so it's at the center of the scene
-    //model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	// It's a bit too big for our scene, so scale it down
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    floor1->Draw(shader);
+    // The static models, merged into one draw call or one by one
+    if (batchModels)
+        staticModels->Draw(view, projection, cameraCullProjection);
+    else
+    {
+        std::vector<std::pair<Model*, glm::mat4> > instances = StaticModelInstances();
+        for (GLuint i = 0; i < instances.size(); i++)
+        {
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(instances[i].second));
+            instances[i].first->Draw(shader);
+            instances[i].first->RequestTextures(instances[i].second);
+        }
+    }
 
-    /*--------------------------DRAWING OBJ------------------*/
+    /******************* Elevator base *******************/
+    shader.Use(); // The batch has its own shader
+    RenderElevator(shader);
+    GLfloat diffW = (cos(inputRecorder->Time())*4  + FLOOR1_Y) + FLOOR1_Y + 0.6;
 
-    //    // Draw the loaded model
-    //    model = glm::mat4();
-    //    model = glm::translate(model, glm::vec3(2.0f, -0.50f, 2.0f)); // Translate it down a bit so it's at the center of the scene
-    //    model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	// It's a bit too big for our scene, so scale it down
-    //    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    //    monster->Draw(shader);
+    glm::mat4 model = glm::rotate(WellModel(),diffW,glm::vec3(0,0,1));
+    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    wheel->Draw(shader);
+    wheel->RequestTextures(model);
+    /******************* draw Elevator base **************/
+}
 
-    /*--------------------------DRAWING OBJ------------------*/
+// The models that never move and where they are: the house, the fences, the trees and the well
+std::vector<std::pair<Model*, glm::mat4> > StaticModelInstances()
+{
+    std::vector<std::pair<Model*, glm::mat4> > instances;
+    glm::mat4 model;
+    model = glm::translate(model, glm::vec3(2.0f, FLOOR1_Y+FLOOR_OFFSET, 2.0f)); // Translate it down a bit so it's at the center of the scene
+    instances.push_back(std::make_pair(floor1, model));
 
-    // Draw the loaded fences
-    for (int i = 0; i < fences.size(); ++i) {
-        model = glm::mat4();
-        model = glm::translate(model, fences[i]);
-        //model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        fence->Draw(shader);
-    }
+    for (GLuint i = 0; i < fences.size(); ++i)
+        instances.push_back(std::make_pair(fence, glm::translate(glm::mat4(), fences[i])));
 
-    /*********************DRAW TREES************/
     model = glm::mat4();
-    model = glm::translate(model, glm::vec3(10.0f, FLOOR1_Y, 2.0f)); // Translate it down a bit so it's at the center of the scene
+    model = glm::translate(model, glm::vec3(10.0f, FLOOR1_Y, 2.0f));
     model = glm::scale(model, glm::vec3(0.7f, 0.7f, 0.7f));	// It's a bit too big for our scene, so scale it down
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    tree->Draw(shader);
-
+    instances.push_back(std::make_pair(tree, model));
     model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-10.0f, FLOOR1_Y, -5.0f)); // Translate it down a bit so it's at the center of the scene
-    model = glm::scale(model, glm::vec3(0.7f, 0.7f, 0.7f));	// It's a bit too big for our scene, so scale it down
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    tree->Draw(shader);
-    /********************* END DRAW TREES************/
+    model = glm::translate(model, glm::vec3(-10.0f, FLOOR1_Y, -5.0f));
+    model = glm::scale(model, glm::vec3(0.7f, 0.7f, 0.7f));
+    instances.push_back(std::make_pair(tree, model));
 
-    /******************* Elevator base *******************/
-    model = glm::mat4();
-    GLfloat diff = (cos(glfwGetTime())*4  + FLOOR1_Y) + FLOOR1_Y + 0.6;
-    GLfloat diffW = diff;
+    instances.push_back(std::make_pair(well, WellModel()));
+    return instances;
+}
+
+// The well of the elevator, its wheel turns around the well's z axis
+glm::mat4 WellModel()
+{
+    glm::mat4 model;
+    model = glm::translate(model,glm::vec3(-1.1, FLOOR1_Y + 1,-7));
+    model = glm::rotate(model,1.56f,glm::vec3(0,1,0));
+    model = glm::scale(model,glm::vec3(0.3,0.3,0.5));
+    return model;
+}
+
+// The elevator platform, the only shadow caster that moves
+glm::mat4 ElevatorModel()
+{
+    glm::mat4 model;
+    GLfloat diff = (cos(inputRecorder->Time())*4  + FLOOR1_Y) + FLOOR1_Y + 0.6;
     diff = diff <= 8 ? diff : 8;
     model = glm::translate(model,glm::vec3(0, diff,-5.2));
     model = glm::scale(model,glm::vec3(3,0.2,3));
+    return model;
+}
+
+void RenderElevator(Shader &shader)
+{
+    glm::mat4 model = ElevatorModel();
     glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, cubeTexture);
     RenderCube();
-
-    model = glm::mat4();
-    model = glm::translate(model,glm::vec3(-1.1, FLOOR1_Y + 1,-7));
-    model = glm::rotate(model,1.56f,glm::vec3(0,1,0));
-    model = glm::scale(model,glm::vec3(0.3,0.3,0.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    well->Draw(shader);
-    model = glm::rotate(model,diffW,glm::vec3(0,0,1));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    wheel->Draw(shader);
-    /******************* draw Elevator base **************/
 }
 
 void RenderScene(Shader &shader)
@@ -1253,21 +1410,47 @@ void RenderScene(Shader &shader)
     glBindVertexArray(0);
 
     // Cubes
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
-    model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-    model = glm::scale(model, glm::vec3(0.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
+    for (GLuint i = 0; i < SceneCubeModels().size(); i++)
+    {
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(SceneCubeModels()[i]));
+        RenderCube();
+    }
+}
+
+// Model matrices of the cubes in RenderScene(), also used for their point light shadow casters
+const std::vector<glm::mat4>& SceneCubeModels()
+{
+    static std::vector<glm::mat4> models;
+    if (models.empty())
+    {
+        glm::mat4 model;
+        model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
+        model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+        model = glm::scale(model, glm::vec3(0.5));
+        models.push_back(model);
+    }
+    return models;
+}
 
+// A cube drawn with RenderCube() as point light shadow caster, bounded by the sphere around its (scaled) corners
+PointShadowCaster CubeCaster(const glm::mat4& model, GLboolean dynamic)
+{
+    PointShadowCaster caster;
+    GLfloat scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    caster.Center = glm::vec3(model[3]);
+    caster.Radius = 0.5f * std::sqrt(3.0f) * scale;
+    caster.Dynamic = dynamic;
+    caster.Draw = [model](Shader& shader, GLsizei instances) {
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        RenderCube(instances);
+    };
+    return caster;
 }
 
 
@@ -1302,10 +1485,10 @@ void RenderQuad()
     glBindVertexArray(0);
 }
 
-// RenderCube() Renders a 1x1 3D cube in NDC.
+// RenderCube() Renders a 1x1 3D cube in NDC, instances > 1 for instanced (gl_InstanceID routed) shadow rendering.
 GLuint cubeVAO = 0;
 GLuint cubeVBO = 0;
-void RenderCube()
+void RenderCube(GLsizei instances)
 {
     // Initialize (if necessary)
     if (cubeVAO == 0)
@@ -1328,33 +1511,22 @@ void RenderCube()
     }
     // Render Cube
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instances);
     glBindVertexArray(0);
 }
 
 // This function loads a texture from file. Note: texture loading functions like these are usually
 // managed by a 'Resource Manager' that manages all resources (like textures, models, audio).
 // For learning purposes we'll just define it as a utility function.
-GLuint loadTexture(string path, GLboolean alpha)
+// alphaCutoff is the alpha test threshold of textures drawn with discard, their mips keep the same coverage.
+GLuint loadTexture(string path, GLboolean alpha, GLfloat alphaCutoff)
 {
-    //Generate texture ID and load texture data
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    int width,height;
-    const char* p = path.c_str();
-    unsigned char* image = SOIL_load_image(p, &width, &height, 0, alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
-    // Assign texture to ID
+    // Decoded and uploaded in the background, coarsest mips first
+    GLuint textureID = textureStreamer->Load(path, false, alpha, alphaCutoff);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, alpha ? GL_RGBA : GL_RGB, width, height, 0, alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Parameters
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT );	// Use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes value from next repeat
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glBindTexture(GL_TEXTURE_2D, 0);
-    SOIL_free_image_data(image);
     return textureID;
 }
 
@@ -1378,6 +1550,45 @@ void Do_Movement()
         shadows = !shadows;
         keysPressed[GLFW_KEY_SPACE] = true;
     }
+    if (keys[GLFW_KEY_O] && !keysPressed[GLFW_KEY_O])
+    {
+        oitTransparency = !oitTransparency;
+        keysPressed[GLFW_KEY_O] = true;
+    }
+    if (keys[GLFW_KEY_T] && !keysPressed[GLFW_KEY_T])
+    {
+        printTimings = true;
+        keysPressed[GLFW_KEY_T] = true;
+    }
+    if (keys[GLFW_KEY_L] && !keysPressed[GLFW_KEY_L])
+    {
+        manyLights = !manyLights;
+        keysPressed[GLFW_KEY_L] = true;
+    }
+    if (keys[GLFW_KEY_M] && !keysPressed[GLFW_KEY_M])
+    {
+        batchModels = !batchModels;
+        std::cout << "Static models " << (batchModels ? "batched" : "drawn one by one") << std::endl;
+        keysPressed[GLFW_KEY_M] = true;
+    }
+    if (keys[GLFW_KEY_F] && !keysPressed[GLFW_KEY_F])
+    {
+        antiAliasing = (antiAliasing + 1) % 3;
+        const char* modes[] = { "none", "FXAA", "TAA" };
+        std::cout << "Anti-aliasing: " << modes[antiAliasing] << std::endl;
+        keysPressed[GLFW_KEY_F] = true;
+    }
+    if (keys[GLFW_KEY_X] && !keysPressed[GLFW_KEY_X])
+    {
+        autoExposureEnabled = !autoExposureEnabled;
+        keysPressed[GLFW_KEY_X] = true;
+    }
+    // Change the exposure
+    GLfloat& exposureSetting = autoExposureEnabled ? exposureCompensation : exposure;
+    if (keys[GLFW_KEY_Q])
+        exposureSetting -= 0.5 * deltaTime;
+    else if (keys[GLFW_KEY_E])
+        exposureSetting += 0.5 * deltaTime;
     if (keys[GLFW_KEY_B])
         std::cout<<camera.Position[0]<<"  "<<camera.Position[1]<<"  "<<camera.Position[2]<<"  "<<endl;
 
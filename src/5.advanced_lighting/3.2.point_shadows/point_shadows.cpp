@@ -7,6 +7,7 @@
 // GL includes
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/point_shadows.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -16,6 +17,9 @@
 // Other Libs
 #include <SOIL.h>
 
+#include <vector>
+#include <cmath>
+
 // Properties
 const GLuint SCR_WIDTH = 800, SCR_HEIGHT = 600;
 
@@ -24,9 +28,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void Do_Movement();
-GLuint loadTexture(GLchar* path);
+GLuint loadTexture(const GLchar* path);
 void RenderScene(Shader &shader);
-void RenderCube();
+const std::vector<glm::mat4>& CubeModels();
+void RenderCube(GLsizei instances = 1);
 void RenderQuad();
 
 // Camera
@@ -38,6 +43,9 @@ GLfloat lastFrame = 0.0f;
 
 // Options
 GLboolean shadows = true;
+GLboolean moveLight = false; // Change with 'M'
+GLboolean instancedShadows = true; // Change with 'L'
+GLboolean printStats = false; // Print the shadow rendering work with 'T'
 
 // Global variables
 GLuint woodTexture;
@@ -77,43 +85,52 @@ int main()
     glEnable(GL_CULL_FACE);
 
     // Setup and compile our shaders
-    Shader shader("point_shadows.vs", "point_shadows.frag");
-    Shader simpleDepthShader("point_shadows_depth.vs", "point_shadows_depth.frag", "point_shadows_depth.gs");
+    Shader shader("shaders/point_shadows.vs", "shaders/point_shadows.frag");
 
     // Set texture samples
     shader.Use();
     glUniform1i(glGetUniformLocation(shader.Program, "diffuseTexture"), 0);
-    glUniform1i(glGetUniformLocation(shader.Program, "depthMap"), 1);
 
     // Light source
     glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
+    GLfloat lightTime = 0.0f;
 
     // Load textures
-    woodTexture = loadTexture("../../../resources/textures/wood.png");
-
-    // Configure depth map FBO
-    const GLuint SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-    GLuint depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
-    // Create depth cubemap texture
-    GLuint depthCubemap;
-    glGenTextures(1, &depthCubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-    for (GLuint i = 0; i < 6; ++i)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    // Attach cubemap as depth map FBO's color buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubemap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    woodTexture = loadTexture("resources/textures/wood.png");
+
+    // Point light shadow atlas, the light's cube faces get up to 1024x1024 texels each
+    const GLfloat far = 25.0f;
+    PointShadowAtlas pointShadows(4096, 1, 64, 1024);
+    pointShadows.SetLightCount(1);
+
+    // Everything in the scene casts shadows and nothing moves, so the casters are set up once
+    std::vector<PointShadowCaster> casters;
+    PointShadowCaster room;
+    room.Center = glm::vec3(0.0f);
+    room.Radius = 0.5f * std::sqrt(3.0f) * 10.0f;
+    room.Dynamic = GL_FALSE;
+    room.Draw = [](Shader& depthShader, GLsizei instances) {
+        glm::mat4 model;
+        model = glm::scale(model, glm::vec3(10.0));
+        glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glDisable(GL_CULL_FACE);
+        RenderCube(instances);
+        glEnable(GL_CULL_FACE);
+    };
+    casters.push_back(room);
+    for (GLuint i = 0; i < CubeModels().size(); i++)
+    {
+        glm::mat4 model = CubeModels()[i];
+        PointShadowCaster cube;
+        cube.Center = glm::vec3(model[3]);
+        cube.Radius = 0.5f * std::sqrt(3.0f) * glm::length(glm::vec3(model[0]));
+        cube.Dynamic = GL_FALSE;
+        cube.Draw = [model](Shader& depthShader, GLsizei instances) {
+            glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            RenderCube(instances);
+        };
+        casters.push_back(cube);
+    }
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
@@ -129,33 +146,17 @@ int main()
         glfwPollEvents();
         Do_Movement();
 
-        // Move light position over time
-        //lightPos.z = sin(glfwGetTime() * 0.5) * 3.0;
-
-        // 0. Create depth cubemap transformation matrices
-        GLfloat aspect = (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT;
-        GLfloat near = 1.0f;
-        GLfloat far = 25.0f;
-        glm::mat4 shadowProj = glm::perspective(90.0f, aspect, near, far);
-        std::vector<glm::mat4> shadowTransforms;
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 1.0,  0.0,  0.0), glm::vec3(0.0, -1.0, 0.0)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0,  0.0,  0.0), glm::vec3(0.0, -1.0, 0.0)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0,  1.0,  0.0), glm::vec3(0.0, 0.0, 1.0)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0, -1.0,  0.0), glm::vec3(0.0, 0.0, -1.0)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0,  0.0,  1.0), glm::vec3(0.0, -1.0, 0.0)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0,  0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
-
-        // 1. Render scene to depth cubemap
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-            glClear(GL_DEPTH_BUFFER_BIT);
-            simpleDepthShader.Use();
-            for (GLuint i = 0; i < 6; ++i)
-                glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.Program, ("shadowTransforms[" + std::to_string(i) + "]").c_str()), 1, GL_FALSE, glm::value_ptr(shadowTransforms[i]));
-            glUniform1f(glGetUniformLocation(simpleDepthShader.Program, "far_plane"), far);
-            glUniform3fv(glGetUniformLocation(simpleDepthShader.Program, "lightPos"), 1, &lightPos[0]);
-            RenderScene(simpleDepthShader);
-         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // Move light position over time, toggle with 'M'
+        if (moveLight)
+            lightTime += deltaTime;
+        lightPos.z = sin(lightTime * 0.5) * 3.0;
+
+        // 1. Render the faces of the shadow cube that changed, nothing while the light stands still
+        pointShadows.InstancedRendering = instancedShadows;
+        pointShadows.SetLight(0, lightPos, far);
+        pointShadows.Allocate(camera.Position, camera.Zoom, SCR_HEIGHT);
+        pointShadows.Render(casters);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // 2. Render scene as normal 
         glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
@@ -173,10 +174,15 @@ int main()
         glUniform1f(glGetUniformLocation(shader.Program, "far_plane"), far);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, woodTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
+        pointShadows.SetUniforms(shader, 1);
         RenderScene(shader);
 
+        if (printStats)
+        {
+            pointShadows.PrintStats();
+            printStats = false;
+        }
+
         // Swap the buffers
         glfwSwapBuffers(window);
     }
@@ -197,36 +203,46 @@ void RenderScene(Shader &shader)
     glUniform1i(glGetUniformLocation(shader.Program, "reverse_normals"), 0); // And of course disable it
     glEnable(GL_CULL_FACE);
     // Cubes
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
-    model = glm::scale(model, glm::vec3(1.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
-    model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-    model = glm::scale(model, glm::vec3(1.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
+    for (GLuint i = 0; i < CubeModels().size(); i++)
+    {
+        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(CubeModels()[i]));
+        RenderCube();
+    }
+}
+
+// Model matrices of the cubes in the room, shared by the scene and its shadow casters
+const std::vector<glm::mat4>& CubeModels()
+{
+    static std::vector<glm::mat4> models;
+    if (models.empty())
+    {
+        glm::mat4 model;
+        model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
+        model = glm::scale(model, glm::vec3(1.5));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
+        models.push_back(model);
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
+        model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+        model = glm::scale(model, glm::vec3(1.5));
+        models.push_back(model);
+    }
+    return models;
 }
 
 
 // RenderCube() Renders a 1x1 3D cube in NDC.
 GLuint cubeVAO = 0;
 GLuint cubeVBO = 0;
-void RenderCube()
+void RenderCube(GLsizei instances)
 {
     // Initialize (if necessary)
     if (cubeVAO == 0)
@@ -293,14 +309,14 @@ void RenderCube()
     }
     // Render Cube
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instances);
     glBindVertexArray(0);
 }
 
 // This function loads a texture from file. Note: texture loading functions like these are usually 
 // managed by a 'Resource Manager' that manages all resources (like textures, models, audio). 
 // For learning purposes we'll just define it as a utility function.
-GLuint loadTexture(GLchar* path, GLboolean alpha)
+GLuint loadTexture(const GLchar* path)
 {
     // Generate texture ID and load texture data 
     GLuint textureID;
@@ -343,6 +359,21 @@ void Do_Movement()
         shadows = !shadows;
         keysPressed[GLFW_KEY_SPACE] = true;
     }
+    if (keys[GLFW_KEY_M] && !keysPressed[GLFW_KEY_M])
+    {
+        moveLight = !moveLight;
+        keysPressed[GLFW_KEY_M] = true;
+    }
+    if (keys[GLFW_KEY_L] && !keysPressed[GLFW_KEY_L])
+    {
+        instancedShadows = !instancedShadows;
+        keysPressed[GLFW_KEY_L] = true;
+    }
+    if (keys[GLFW_KEY_T] && !keysPressed[GLFW_KEY_T])
+    {
+        printStats = true;
+        keysPressed[GLFW_KEY_T] = true;
+    }
 }
 
 GLfloat lastX = 400, lastY = 300;
@@ -6,8 +6,13 @@
 #include <GLFW/glfw3.h>
 
 // GL includes
+#include <learnopengl/benchmark.h> // First, so the GL calls of the other headers are counted in benchmark builds
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/input_recorder.h>
+#include <learnopengl/bloom.h>
+#include <learnopengl/auto_exposure.h>
+#include <learnopengl/clustered_lights.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -40,9 +45,11 @@ GLfloat lastFrame = 0.0f;
 // Options
 GLboolean bloom = true; // Change with 'Space'
 GLfloat exposure = 1.0f; // Change with Q and E
+GLfloat exposureCompensation = 0.0f; // Stops added to the auto exposure, change with Q and E while it is on
+GLboolean autoExposureEnabled = true; // Change with 'X'
 
 // The MAIN function, from here we start our application and run our Game loop
-int main()
+int main(int argc, char* argv[])
 {
     // Init GLFW
     glfwInit();
@@ -53,6 +60,12 @@ int main()
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+    // Built as a frame time benchmark the window is hidden and the camera follows a path, see FrameBenchmark
+    FrameBenchmark benchmark("bloom", argc, argv);
+    benchmark.WindowHints();
+    // Live, recorded or replayed input and clock, see InputRecorder
+    InputRecorder input(argc, argv);
+    benchmark.Attach(input);
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH/2, SCR_HEIGHT/2, "LearnOpenGL", nullptr, nullptr); // Windowed
     glfwMakeContextCurrent(window);
 
@@ -60,6 +73,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    input.Attach(window);
 
     // Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -67,6 +81,7 @@ int main()
     // Initialize GLEW to setup the OpenGL Function pointers
     glewExperimental = GL_TRUE;
     glewInit();
+    benchmark.Start(window);
 
     // Define the viewport dimensions
     glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
@@ -77,7 +92,6 @@ int main()
     // Setup and compile our shaders
     Shader shaderBloom("shaders/bloom.vs", "shaders/bloom.frag");
     Shader shaderLight("shaders/bloom.vs", "shaders/light_box.frag");
-    Shader shaderBlur("shaders/blur.vs", "shaders/blur.frag");
     Shader shaderBloomFinal("shaders/bloom_final.vs", "shaders/bloom_final.frag");
 
     // Set samplers
@@ -98,6 +112,12 @@ int main()
     lightColors.push_back(glm::vec3(1.5f, 0.0f, 0.0f));
     lightColors.push_back(glm::vec3(0.0f, 0.0f, 1.5f));
     lightColors.push_back(glm::vec3(0.0f, 1.5f, 0.0f));
+    // - Radii, where the light falls off below what is still visible
+    std::vector<GLfloat> lightRadii;
+    for (GLuint i = 0; i < lightColors.size(); i++)
+        lightRadii.push_back(ClusteredLights::LightRadius(lightColors[i]));
+    // The lights are sorted into view frustum clusters every frame, see shaders/bloom.frag
+    ClusteredLights clusteredLights(SCR_WIDTH, SCR_HEIGHT, 0.1f, 100.0f);
 
     // Load textures
     GLuint woodTexture      = loadTexture("resources/textures/wood.png");
@@ -107,67 +127,47 @@ int main()
     GLuint hdrFBO;
     glGenFramebuffers(1, &hdrFBO);
     glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // - Create 2 floating point color buffers (1 for normal rendering, other for brightness treshold values)
-    GLuint colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (GLuint i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // We clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
+    // - Create the floating point color buffer, the bloom chain thresholds it itself so no separate brightness buffer is needed
+    GLuint colorBuffer;
+    glGenTextures(1, &colorBuffer);
+    glBindTexture(GL_TEXTURE_2D, colorBuffer);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // We clamp to the edge as the bloom filters would otherwise sample repeated texture values!
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // attach texture to framebuffer
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
     // - Create and attach depth buffer (renderbuffer)
     GLuint rboDepth;
     glGenRenderbuffers(1, &rboDepth);
     glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // - Tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
     // - Finally check if framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // Ping pong framebuffer for blurring
-    GLuint pingpongFBO[2];
-    GLuint pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (GLuint i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // We clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // Also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
+    // Downsample/upsample chain for the bloom (1/2 ... 1/64 of the HDR resolution)
+    BloomRenderer bloomRenderer(SCR_WIDTH, SCR_HEIGHT);
+    // Exposure adapted to the luminance the bloom chain measures
+    AutoExposure autoExposure;
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
     // Game loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && benchmark.Running() && !input.Finished())
     {
-        // Set frame time
-        GLfloat currentFrame = glfwGetTime();
+        // Check and call events, live or replayed
+        input.PollEvents();
+
+        // Set frame time, on the recorder's clock
+        GLfloat currentFrame = input.Time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-
-        // Check and call events
-        glfwPollEvents();
         Do_Movement();
+        benchmark.PlaceCamera(camera);
 
         // 1. Render scene into floating point framebuffer
         glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
@@ -181,11 +181,8 @@ int main()
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, woodTexture);
             // - set lighting uniforms
-            for (GLuint i = 0; i < lightPositions.size(); i++)
-            {
-                glUniform3fv(glGetUniformLocation(shaderBloom.Program, ("lights[" + std::to_string(i) + "].Position").c_str()), 1, &lightPositions[i][0]);
-                glUniform3fv(glGetUniformLocation(shaderBloom.Program, ("lights[" + std::to_string(i) + "].Color").c_str()), 1, &lightColors[i][0]);
-            }
+            clusteredLights.Update(lightPositions, lightColors, lightRadii, view, projection);
+            clusteredLights.SetUniforms(shaderBloom, 1);
             glUniform3fv(glGetUniformLocation(shaderBloom.Program, "viewPos"), 1, &camera.Position[0]);
             // - create one large cube that acts as the floor
 //            model = glm::mat4();
@@ -242,37 +239,35 @@ int main()
             }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 2. Blur bright fragments w/ two-pass Gaussian Blur
-        GLboolean horizontal = true, first_iteration = true;
-        GLuint amount = 10;
-        shaderBlur.Use();
-        for (GLuint i = 0; i < amount; i++)
+        // 2. Threshold and blur bright fragments through the downsample/upsample chain, which also measures the
+        // scene luminance for the auto exposure
+        if (bloom || autoExposureEnabled)
+            bloomRenderer.Render(colorBuffer, SCR_WIDTH, SCR_HEIGHT);
+        if (autoExposureEnabled)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            glUniform1i(glGetUniformLocation(shaderBlur.Program, "horizontal"), horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-            RenderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+            autoExposure.Compensation = exposureCompensation;
+            autoExposure.Update(bloomRenderer.LuminanceTexture(), SCR_WIDTH / 2, SCR_HEIGHT / 2, deltaTime);
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // 2. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderBloomFinal.Use();
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
+        glBindTexture(GL_TEXTURE_2D, colorBuffer);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
+        glBindTexture(GL_TEXTURE_2D, bloomRenderer.BloomTexture());
         glUniform1i(glGetUniformLocation(shaderBloomFinal.Program, "bloom"), bloom);
-        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "exposure"), exposure);
+        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "exposure"), autoExposureEnabled ? autoExposure.Exposure : exposure);
+        glUniform1f(glGetUniformLocation(shaderBloomFinal.Program, "bloomIntensity"), bloomRenderer.CompositeWeight());
         RenderQuad();
 
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame();
     }
+    benchmark.Report();
 
     glfwTerminate();
     return 0;
@@ -431,11 +426,18 @@ void Do_Movement()
         keysPressed[GLFW_KEY_SPACE] = true;
     }
 
-    // Change parallax height scale
+    if (keys[GLFW_KEY_X] && !keysPressed[GLFW_KEY_X])
+    {
+        autoExposureEnabled = !autoExposureEnabled;
+        keysPressed[GLFW_KEY_X] = true;
+    }
+
+    // Change the exposure
+    GLfloat& exposureSetting = autoExposureEnabled ? exposureCompensation : exposure;
     if (keys[GLFW_KEY_Q])
-        exposure -= 0.5 * deltaTime;
+        exposureSetting -= 0.5 * deltaTime;
     else if (keys[GLFW_KEY_E])
-        exposure += 0.5 * deltaTime;
+        exposureSetting += 0.5 * deltaTime;
 }
 
 GLfloat lastX = 400, lastY = 300;
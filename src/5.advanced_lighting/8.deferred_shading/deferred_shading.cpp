@@ -1,5 +1,10 @@
 // Std. Includes
 #include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
 
 // GLEW
 #include <GL/glew.h>
@@ -10,6 +15,10 @@
 // GL includes
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/gbuffer.h>
+#include <learnopengl/tiled_lights.h>
+#include <learnopengl/screen_quad.h>
 
 // GLM Mathemtics
 #include <glm/glm.hpp>
@@ -20,24 +29,31 @@
 #include <SOIL.h>
 
 // Properties
-GLuint screenWidth = 800, screenHeight = 600;
+const GLuint SCR_WIDTH = 1280, SCR_HEIGHT = 720;
+const GLuint NR_LIGHTS = 64;
 
 // Function prototypes
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void Do_Movement();
-GLuint loadTexture(GLchar* path);
+GLuint loadTexture(const GLchar* path);
+void RenderCube();
+void RenderSphere();
 
 // Camera
-Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
-bool keys[1024];
-GLfloat lastX = 400, lastY = 300;
-bool firstMouse = true;
+Camera camera(glm::vec3(0.0f, 2.0f, 8.0f));
 
+// Delta
 GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
+// Options
+GLboolean moveLights = true;   // Change with 'M'
+GLboolean showLights = true;   // Draw the lights as small cubes, change with 'V'
+GLboolean tiledLighting = true; // Tiled full-screen lighting or stencil tested light volumes, change with 'K'
+GLboolean printStats = false;  // Print the G-buffer and light stats with 'T'
+
 // The MAIN function, from here we start our application and run our Game loop
 int main()
 {
@@ -49,7 +65,7 @@ int main()
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-    GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "LearnOpenGL", nullptr, nullptr); // Windowed
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", nullptr, nullptr); // Windowed
     glfwMakeContextCurrent(window);
 
     // Set the required callback functions
@@ -65,103 +81,60 @@ int main()
     glewInit();
 
     // Define the viewport dimensions
-    glViewport(0, 0, screenWidth, screenHeight);
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
 
     // Setup some OpenGL options
     glEnable(GL_DEPTH_TEST);
-    // glDepthFunc(GL_ALWAYS); // Set to always pass the depth test (same effect as glDisable(GL_DEPTH_TEST))
+    glEnable(GL_CULL_FACE);
 
     // Setup and compile our shaders
-    Shader shader("depth_testing.vs", "depth_testing.frag");
-
-    #pragma region "object_initialization"
-    // Set the object data (buffers, vertex attributes)
-    GLfloat cubeVertices[] = {
-        // Positions          // Texture Coords
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-    };
-    GLfloat planeVertices[] = {
-        // Positions            // Texture Coords (note we set these higher than 1 that together with GL_REPEAT as texture wrapping mode will cause the floor texture to repeat)
-        5.0f,  -0.5f,  5.0f,  2.0f, 0.0f,
-        -5.0f, -0.5f,  5.0f,  0.0f, 0.0f,
-        -5.0f, -0.5f, -5.0f,  0.0f, 2.0f,
-
-        5.0f,  -0.5f,  5.0f,  2.0f, 0.0f,
-        -5.0f, -0.5f, -5.0f,  0.0f, 2.0f,
-        5.0f,  -0.5f, -5.0f,  2.0f, 2.0f								
-    };
-    // Setup cube VAO
-    GLuint cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glBindVertexArray(cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), &cubeVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glBindVertexArray(0);
-    // Setup plane VAO
-    GLuint planeVAO, planeVBO;
-    glGenVertexArrays(1, &planeVAO);
-    glGenBuffers(1, &planeVBO);
-    glBindVertexArray(planeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), &planeVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glBindVertexArray(0);
+    Shader shaderGeometryPass("shaders/g_buffer.vs", "shaders/g_buffer.frag");
+    Shader shaderStencilPass("shaders/deferred_light_volume.vs", "shaders/shadow_mapping_depth.frag");
+    Shader shaderLightingPass("shaders/deferred_light_volume.vs", "shaders/deferred_light.frag");
+    Shader shaderAmbientPass("shaders/bloom_final.vs", "shaders/deferred_ambient.frag");
+    Shader shaderTiledLighting("shaders/bloom_final.vs", "shaders/deferred_tiled.frag");
+    Shader shaderLightBox("shaders/bloom.vs", "shaders/light_box.frag");
+    Shader shaderFinal("shaders/bloom_final.vs", "shaders/bloom_final.frag");
+
+    // Set samplers, meshes bind their diffuse map to unit 0 and their specular map to unit 1
+    shaderGeometryPass.Use();
+    glUniform1i(glGetUniformLocation(shaderGeometryPass.Program, "texture_diffuse1"), 0);
+    glUniform1i(glGetUniformLocation(shaderGeometryPass.Program, "texture_specular1"), 1);
+    shaderFinal.Use();
+    glUniform1i(glGetUniformLocation(shaderFinal.Program, "scene"), 0);
+    glUniform1i(glGetUniformLocation(shaderFinal.Program, "bloomBlur"), 0);
+    glUniform1i(glGetUniformLocation(shaderFinal.Program, "bloom"), GL_FALSE);
+    glUniform1f(glGetUniformLocation(shaderFinal.Program, "exposure"), 1.0f);
+
+    // Models
+    Model nanosuit("resources/objects/nanosuit/nanosuit.obj");
+    std::vector<glm::vec3> objectPositions;
+    for (GLint x = -1; x <= 1; x++)
+        for (GLint z = -1; z <= 1; z++)
+            objectPositions.push_back(glm::vec3(x * 3.0f, -3.0f, z * 3.0f));
+    GLuint woodTexture = loadTexture("resources/textures/wood.png");
+
+    // Lights: random colors, circling around the center at random heights
+    std::vector<glm::vec3> lightColors;
+    std::vector<GLfloat> lightRadii, lightOrbits, lightPhases, lightHeights;
+    for (GLuint i = 0; i < NR_LIGHTS; i++)
+    {
+        glm::vec3 color((rand() % 100) / 200.0f + 0.5f, (rand() % 100) / 200.0f + 0.5f, (rand() % 100) / 200.0f + 0.5f);
+        lightColors.push_back(color);
+        // Where the quadratic falloff drops below 8% of the light's brightness
+        lightRadii.push_back(std::sqrt(std::max(color.r, std::max(color.g, color.b)) / 0.08f));
+        lightOrbits.push_back(1.0f + (rand() % 100) / 100.0f * 5.0f);
+        lightPhases.push_back((rand() % 100) / 100.0f * 6.2832f);
+        lightHeights.push_back((rand() % 100) / 100.0f * 6.0f - 3.5f);
+    }
+    std::vector<glm::vec3> lightPositions(NR_LIGHTS);
+    GLfloat lightTime = 0.0f;
 
-    // Load textures
-    GLuint cubeTexture = loadTexture("../../../resources/textures/marble.jpg");
-    GLuint floorTexture = loadTexture("../../../resources/textures/metal.png");
-    #pragma endregion
+    GBuffer gBuffer(SCR_WIDTH, SCR_HEIGHT);
+    TiledLights tiledLights(SCR_WIDTH, SCR_HEIGHT);
 
     // Game loop
-    while(!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window))
     {
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
@@ -172,35 +145,133 @@ int main()
         glfwPollEvents();
         Do_Movement();
 
-        // Clear the colorbuffer
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (moveLights)
+            lightTime += deltaTime;
+        for (GLuint i = 0; i < NR_LIGHTS; i++)
+        {
+            GLfloat angle = lightPhases[i] + lightTime * 0.5f / lightOrbits[i];
+            lightPositions[i] = glm::vec3(std::cos(angle) * lightOrbits[i], lightHeights[i], std::sin(angle) * lightOrbits[i]);
+        }
 
-        // Draw objects
-        shader.Use(); 
-        glm::mat4 model;
+        glm::mat4 projection = glm::perspective(camera.Zoom, (GLfloat)SCR_WIDTH / (GLfloat)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(camera.Zoom, (float)screenWidth/(float)screenHeight, 0.1f, 100.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        // Cubes
-        glBindVertexArray(cubeVAO);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);  // We omit the glActiveTexture part since TEXTURE0 is already the default active texture unit. (sampler used in fragment is set to 0 as well as default)		
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        // Floor
-        glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        model = glm::mat4();
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);				
+        glm::mat4 model;
 
+        // 1. Geometry pass: render the surface attributes of the scene into the G-buffer
+        gBuffer.BeginGeometry();
+        shaderGeometryPass.Use();
+        glUniformMatrix4fv(glGetUniformLocation(shaderGeometryPass.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(glGetUniformLocation(shaderGeometryPass.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        for (GLuint i = 0; i < objectPositions.size(); i++)
+        {
+            model = glm::mat4();
+            model = glm::translate(model, objectPositions[i]);
+            model = glm::scale(model, glm::vec3(0.25f));
+            glUniformMatrix4fv(glGetUniformLocation(shaderGeometryPass.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            nanosuit.Draw(shaderGeometryPass);
+        }
+        // - the floor, wood for both the diffuse and the specular map
+        model = glm::mat4();
+        model = glm::translate(model, glm::vec3(0.0f, -3.5f, 0.0f));
+        model = glm::scale(model, glm::vec3(20.0f, 1.0f, 20.0f));
+        glUniformMatrix4fv(glGetUniformLocation(shaderGeometryPass.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, woodTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, woodTexture);
+        glActiveTexture(GL_TEXTURE0);
+        RenderCube();
+
+        // 2. Lighting pass
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        if (tiledLighting)
+        {
+            // Bin the lights into screen tiles against the depth of the geometry pass, then shade every pixel once
+            // with the lights of its tile (ambient included)
+            tiledLights.Update(lightPositions, lightColors, lightRadii, view, projection, gBuffer.DepthTexture, 0.1f, 100.0f);
+            gBuffer.BeginLighting();
+            glDisable(GL_DEPTH_TEST);
+            shaderTiledLighting.Use();
+            gBuffer.BindTextures(shaderTiledLighting, 0);
+            tiledLights.SetUniforms(shaderTiledLighting, 3);
+            glUniformMatrix4fv(glGetUniformLocation(shaderTiledLighting.Program, "inverseProjection"), 1, GL_FALSE, glm::value_ptr(inverseProjection));
+            glUniform3f(glGetUniformLocation(shaderTiledLighting.Program, "ambient"), 0.05f, 0.05f, 0.05f);
+            RenderScreenQuad();
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            // Ambient over the whole screen, then every light over the pixels inside its volume
+            gBuffer.BeginLighting();
+            glDisable(GL_DEPTH_TEST);
+            shaderAmbientPass.Use();
+            gBuffer.BindTextures(shaderAmbientPass, 0);
+            glUniform3f(glGetUniformLocation(shaderAmbientPass.Program, "ambient"), 0.05f, 0.05f, 0.05f);
+            RenderScreenQuad();
+
+            shaderLightingPass.Use();
+            gBuffer.BindTextures(shaderLightingPass, 0);
+            glUniformMatrix4fv(glGetUniformLocation(shaderLightingPass.Program, "inverseProjection"), 1, GL_FALSE, glm::value_ptr(inverseProjection));
+            glUniform2f(glGetUniformLocation(shaderLightingPass.Program, "screenSize"), (GLfloat)SCR_WIDTH, (GLfloat)SCR_HEIGHT);
+            Shader* volumeShaders[] = { &shaderStencilPass, &shaderLightingPass };
+            for (GLuint i = 0; i < 2; i++)
+            {
+                volumeShaders[i]->Use();
+                glUniformMatrix4fv(glGetUniformLocation(volumeShaders[i]->Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+                glUniformMatrix4fv(glGetUniformLocation(volumeShaders[i]->Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            }
+            gBuffer.RenderLightVolumes(shaderStencilPass, shaderLightingPass, NR_LIGHTS, [&](GLuint light, Shader& shader, GLboolean lighting) {
+                // The sphere mesh is slightly smaller than the sphere it approximates, scale it up to cover the whole volume
+                glm::mat4 volume;
+                volume = glm::translate(volume, lightPositions[light]);
+                volume = glm::scale(volume, glm::vec3(lightRadii[light] * 1.05f));
+                glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(volume));
+                if (lighting)
+                {
+                    glm::vec3 viewPosition = glm::vec3(view * glm::vec4(lightPositions[light], 1.0f));
+                    glUniform3fv(glGetUniformLocation(shader.Program, "lightPosition"), 1, &viewPosition[0]);
+                    glUniform3fv(glGetUniformLocation(shader.Program, "lightColor"), 1, &lightColors[light][0]);
+                    glUniform1f(glGetUniformLocation(shader.Program, "lightRadius"), lightRadii[light]);
+                }
+                RenderSphere();
+            });
+        }
+
+        // 3. Forward render the lights on top, depth tested against the G-buffer depth copied with the lighting
+        if (showLights)
+        {
+            shaderLightBox.Use();
+            glUniformMatrix4fv(glGetUniformLocation(shaderLightBox.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(glGetUniformLocation(shaderLightBox.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            for (GLuint i = 0; i < NR_LIGHTS; i++)
+            {
+                model = glm::mat4();
+                model = glm::translate(model, lightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.1f));
+                glUniformMatrix4fv(glGetUniformLocation(shaderLightBox.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+                glUniform3fv(glGetUniformLocation(shaderLightBox.Program, "lightColor"), 1, &lightColors[i][0]);
+                RenderCube();
+            }
+        }
+
+        // 4. Tonemap the accumulated lighting to the screen
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+        glDisable(GL_DEPTH_TEST);
+        shaderFinal.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.LightTexture);
+        RenderScreenQuad();
+        glEnable(GL_DEPTH_TEST);
+
+        if (printStats)
+        {
+            std::cout << "Deferred shading: " << NR_LIGHTS << " light volumes, G-buffer and light buffer "
+                      << gBuffer.MemoryBytes() / (1024.0f * 1024.0f) << " MB (12 bytes per pixel G-buffer)" << std::endl;
+            if (tiledLighting)
+                tiledLights.PrintStats();
+            printStats = false;
+        }
 
         // Swap the buffers
         glfwSwapBuffers(window);
@@ -210,63 +281,215 @@ int main()
     return 0;
 }
 
-// This function loads a texture from file. Note: texture loading functions like these are usually 
-// managed by a 'Resource Manager' that manages all resources (like textures, models, audio). 
+// RenderCube() Renders a 1x1 3D cube in NDC.
+GLuint cubeVAO = 0;
+GLuint cubeVBO = 0;
+void RenderCube()
+{
+    // Initialize (if necessary)
+    if (cubeVAO == 0)
+    {
+        GLfloat vertices[] = {
+            // Back face
+            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, // Bottom-left
+            0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, // top-right
+            0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+            0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,  // top-right
+            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
+            -0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,// top-left
+            // Front face
+            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
+            0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,  // bottom-right
+            0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,  // top-right
+            0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, // top-right
+            -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,  // top-left
+            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
+            // Left face
+            -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
+            -0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-left
+            -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
+            -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-left
+            -0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,  // bottom-right
+            -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
+            // Right face
+            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-left
+            0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-right
+            0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-right
+            0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-right
+            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // top-left
+            0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // bottom-left
+            // Bottom face
+            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
+            0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f, // top-left
+            0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,// bottom-left
+            0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, // bottom-left
+            -0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-right
+            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
+            // Top face
+            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
+            0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
+            0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, // top-right
+            0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
+            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
+            -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f // bottom-left
+        };
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
+        // Fill buffer
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        // Link vertex attributes
+        glBindVertexArray(cubeVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    // Render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
+
+// RenderSphere() Renders a unit sphere (positions only) with counter-clockwise outward facing triangles, used as light volume.
+GLuint sphereVAO = 0;
+GLuint sphereVBO = 0;
+GLuint sphereEBO = 0;
+GLsizei sphereIndexCount = 0;
+void RenderSphere()
+{
+    // Initialize (if necessary)
+    if (sphereVAO == 0)
+    {
+        const GLuint rings = 16, segments = 16;
+        std::vector<GLfloat> vertices;
+        std::vector<GLuint> indices;
+        for (GLuint r = 0; r <= rings; r++)
+        {
+            GLfloat theta = r * 3.14159265f / rings;
+            for (GLuint s = 0; s <= segments; s++)
+            {
+                GLfloat phi = s * 2.0f * 3.14159265f / segments;
+                vertices.push_back(std::sin(theta) * std::cos(phi));
+                vertices.push_back(std::cos(theta));
+                vertices.push_back(std::sin(theta) * std::sin(phi));
+            }
+        }
+        for (GLuint r = 0; r < rings; r++)
+            for (GLuint s = 0; s < segments; s++)
+            {
+                GLuint a = r * (segments + 1) + s, b = a + segments + 1;
+                // a - a + 1 on this ring, b - b + 1 on the ring below
+                indices.push_back(a); indices.push_back(a + 1); indices.push_back(b + 1);
+                indices.push_back(a); indices.push_back(b + 1); indices.push_back(b);
+            }
+        sphereIndexCount = indices.size();
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &sphereVBO);
+        glGenBuffers(1, &sphereEBO);
+        glBindVertexArray(sphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glBindVertexArray(0);
+    }
+    glBindVertexArray(sphereVAO);
+    glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+// This function loads a texture from file. Note: texture loading functions like these are usually
+// managed by a 'Resource Manager' that manages all resources (like textures, models, audio).
 // For learning purposes we'll just define it as a utility function.
-GLuint loadTexture(GLchar* path)
+GLuint loadTexture(const GLchar* path)
 {
-    //Generate texture ID and load texture data 
+    // Generate texture ID and load texture data
     GLuint textureID;
     glGenTextures(1, &textureID);
-    int width,height;
+    int width, height;
     unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB);
     // Assign texture to ID
     glBindTexture(GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);	
+    glGenerateMipmap(GL_TEXTURE_2D);
 
     // Parameters
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glBindTexture(GL_TEXTURE_2D, 0);
     SOIL_free_image_data(image);
     return textureID;
-
 }
 
-#pragma region "User input"
-
+bool keys[1024];
+bool keysPressed[1024];
 // Moves/alters the camera positions based on user input
 void Do_Movement()
 {
     // Camera controls
-    if(keys[GLFW_KEY_W])
+    if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if(keys[GLFW_KEY_S])
+    if (keys[GLFW_KEY_S])
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if(keys[GLFW_KEY_A])
+    if (keys[GLFW_KEY_A])
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if(keys[GLFW_KEY_D])
+    if (keys[GLFW_KEY_D])
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (keys[GLFW_KEY_M] && !keysPressed[GLFW_KEY_M])
+    {
+        moveLights = !moveLights;
+        keysPressed[GLFW_KEY_M] = true;
+    }
+    if (keys[GLFW_KEY_V] && !keysPressed[GLFW_KEY_V])
+    {
+        showLights = !showLights;
+        keysPressed[GLFW_KEY_V] = true;
+    }
+    if (keys[GLFW_KEY_K] && !keysPressed[GLFW_KEY_K])
+    {
+        tiledLighting = !tiledLighting;
+        keysPressed[GLFW_KEY_K] = true;
+    }
+    if (keys[GLFW_KEY_T] && !keysPressed[GLFW_KEY_T])
+    {
+        printStats = true;
+        keysPressed[GLFW_KEY_T] = true;
+    }
 }
 
+GLfloat lastX = 400, lastY = 300;
+bool firstMouse = true;
 // Is called whenever a key is pressed/released via GLFW
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
-    if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
 
-    if(action == GLFW_PRESS)
-        keys[key] = true;
-    else if(action == GLFW_RELEASE)
-        keys[key] = false;	
+    if (key >= 0 && key <= 1024)
+    {
+        if (action == GLFW_PRESS)
+            keys[key] = true;
+        else if (action == GLFW_RELEASE)
+        {
+            keys[key] = false;
+            keysPressed[key] = false;
+        }
+    }
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    if(firstMouse)
+    if (firstMouse)
     {
         lastX = xpos;
         lastY = ypos;
@@ -274,17 +497,15 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     }
 
     GLfloat xoffset = xpos - lastX;
-    GLfloat yoffset = lastY - ypos; 
-    
+    GLfloat yoffset = lastY - ypos;
+
     lastX = xpos;
     lastY = ypos;
 
     camera.ProcessMouseMovement(xoffset, yoffset);
-}	
+}
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(yoffset);
 }
-
-#pragma endregion
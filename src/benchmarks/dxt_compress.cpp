@@ -0,0 +1,179 @@
+// Std. Includes
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// Other Libs
+#include <stb_image_aug.h>
+#include <image_DXT.h>
+
+#include <learnopengl/dxt_compressor.h>
+
+#include "dxt_reference.h"
+
+// Standalone benchmark of the DXT encoder used by the texture baker (external/SOIL/src/image_DXT.c through
+// includes/learnopengl/dxt_compressor.h). Compresses every image of a directory with each quality setting, scalar and
+// SSE2 on one thread and SSE2 on all threads, checks that all of them agree byte for byte (and at normal quality
+// with a frozen copy of the original encoder, see dxt_reference.h) and reports the throughput in MPixels/s and the
+// RGB error of each quality.
+// Usage: dxt_compress [directory] (default resources/textures)
+
+struct Image {
+    std::string Name;
+    GLint Width, Height, Channels;
+    std::vector<unsigned char> Pixels;
+};
+
+std::vector<std::string> ListDirectory(const std::string& directory)
+{
+    std::vector<std::string> files;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA((directory + "/*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+        return files;
+    do
+        files.push_back(entry.cFileName);
+    while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return files;
+    while (dirent* entry = readdir(dir))
+        files.push_back(entry->d_name);
+    closedir(dir);
+#endif
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Images with 2 or 4 channels have alpha and go to DXT5
+GLboolean HasAlpha(const Image& image)
+{
+    return (image.Channels & 1) == 0;
+}
+
+// Compresses all images, returns MPixels/s averaged over enough rounds to take ~0.5 s
+GLdouble TimeCompression(const DXTCompressor& compressor, const std::vector<Image>& images, GLdouble pixels)
+{
+    std::vector<unsigned char> compressed;
+    GLuint rounds = 0;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    GLdouble elapsed = 0.0;
+    while (elapsed < 0.5)
+    {
+        for (GLuint i = 0; i < images.size(); i++)
+            compressor.Compress(&images[i].Pixels[0], images[i].Width, images[i].Height, images[i].Channels, HasAlpha(images[i]), compressed);
+        rounds++;
+        elapsed = std::chrono::duration<GLdouble>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    return pixels * rounds / elapsed / 1e6;
+}
+
+// Root mean square RGB error of the decoded color blocks against the source
+GLdouble ColorError(const Image& image, const std::vector<unsigned char>& compressed)
+{
+    GLint blocksX = (image.Width + 3) / 4, blockBytes = HasAlpha(image) ? 16 : 8;
+    GLint step = image.Channels < 3 ? 0 : 1;
+    GLdouble sum = 0.0;
+    for (GLint y = 0; y < image.Height; y++)
+        for (GLint x = 0; x < image.Width; x++)
+        {
+            const unsigned char* block = &compressed[((y / 4) * blocksX + x / 4) * blockBytes + blockBytes - 8];
+            GLint c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+            GLint code = (block[4 + (y & 3)] >> ((x & 3) * 2)) & 3;
+            const unsigned char* pixel = &image.Pixels[(y * image.Width + x) * image.Channels];
+            GLint shifts[3] = { 11, 5, 0 }, bits[3] = { 5, 6, 5 };
+            for (GLint c = 0; c < 3; c++)
+            {
+                GLint mask = (1 << bits[c]) - 1;
+                GLint e0 = ((c0 >> shifts[c]) & mask) * 255 / mask, e1 = ((c1 >> shifts[c]) & mask) * 255 / mask;
+                GLint palette[4] = { e0, e1, (2 * e0 + e1) / 3, (e0 + 2 * e1) / 3 };
+                GLdouble d = palette[code] - pixel[c * step];
+                sum += d * d;
+            }
+        }
+    return std::sqrt(sum / (image.Width * image.Height * 3.0));
+}
+
+int main(int argc, char* argv[])
+{
+    std::string directory = argc > 1 ? argv[1] : "resources/textures";
+    std::vector<Image> images;
+    GLdouble pixels = 0.0;
+    std::vector<std::string> files = ListDirectory(directory);
+    for (GLuint i = 0; i < files.size(); i++)
+    {
+        Image image;
+        unsigned char* data = stbi_load((directory + "/" + files[i]).c_str(), &image.Width, &image.Height, &image.Channels, 0);
+        if (!data)
+            continue;
+        image.Name = files[i];
+        image.Pixels.assign(data, data + image.Width * image.Height * image.Channels);
+        stbi_image_free(data);
+        pixels += image.Width * image.Height;
+        images.push_back(image);
+    }
+    if (images.empty())
+    {
+        std::cout << "ERROR::BENCHMARK:: No images in " << directory << std::endl;
+        return 1;
+    }
+    GLuint hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::cout << images.size() << " images, " << pixels / 1e6 << " MPixels, up to " << hardwareThreads << " threads" << std::endl;
+
+    const GLchar* names[] = { "fast", "normal", "high" };
+    for (GLint quality = DXT_QUALITY_FAST; quality <= DXT_QUALITY_HIGH; quality++)
+    {
+        // Scalar single threaded is the reference, SIMD and threaded output has to match it
+        GLdouble error = 0.0;
+        for (GLuint i = 0; i < images.size(); i++)
+        {
+            const Image& image = images[i];
+            std::vector<unsigned char> reference, compressed;
+            enable_DXT_SIMD(0);
+            DXTCompressor(quality, 1).Compress(&image.Pixels[0], image.Width, image.Height, image.Channels, HasAlpha(image), reference);
+            enable_DXT_SIMD(1);
+            DXTCompressor(quality, std::max(hardwareThreads, 4u)).Compress(&image.Pixels[0], image.Width, image.Height, image.Channels, HasAlpha(image), compressed);
+            if (compressed != reference)
+            {
+                std::cout << "ERROR::BENCHMARK:: SIMD/threaded output differs for " << image.Name << " at quality " << names[quality] << std::endl;
+                return 1;
+            }
+            if (quality == DXT_QUALITY_NORMAL)
+            {
+                // Has to stay what the encoder produced before the rework, so existing DDS files don't change
+                GLint size = 0;
+                unsigned char* original = HasAlpha(image) ? reference_convert_image_to_DXT5(&image.Pixels[0], image.Width, image.Height, image.Channels, &size)
+                                                          : reference_convert_image_to_DXT1(&image.Pixels[0], image.Width, image.Height, image.Channels, &size);
+                bool same = size == (GLint)reference.size() && memcmp(original, &reference[0], size) == 0;
+                free(original);
+                if (!same)
+                {
+                    std::cout << "ERROR::BENCHMARK:: Output differs from the original encoder for " << image.Name << std::endl;
+                    return 1;
+                }
+            }
+            error += ColorError(image, reference) * image.Width * image.Height;
+        }
+
+        std::cout << "Quality " << names[quality] << ", RGB RMSE " << error / pixels << std::endl;
+        enable_DXT_SIMD(0);
+        std::cout << "  scalar, 1 thread:  " << TimeCompression(DXTCompressor(quality, 1), images, pixels) << " MPixels/s" << std::endl;
+        enable_DXT_SIMD(1);
+        std::cout << "  SSE2,   1 thread:  " << TimeCompression(DXTCompressor(quality, 1), images, pixels) << " MPixels/s" << std::endl;
+        std::cout << "  SSE2, " << hardwareThreads << " threads: " << TimeCompression(DXTCompressor(quality, hardwareThreads), images, pixels) << " MPixels/s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+// Std. Includes
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// GL Includes
+#include <GL/glew.h>
+
+// Other Libs
+#include <stb_image_aug.h>
+
+// Standalone benchmark of the image decoder behind SOIL_load_image (external/SOIL/src/stb_image_aug.c). Decodes
+// every JPEG and PNG under a directory from memory with the scalar and the SSE2 JPEG IDCT, YCbCr->RGB conversion and
+// PNG unfiltering, checks that both give the same pixels for every channel count a loader can ask for and reports
+// the throughput per format in MPixels/s.
+// Usage: image_decode [directory] (default resources)
+
+struct EncodedImage {
+    std::string Path;
+    std::vector<unsigned char> Data;
+    GLint Width, Height;
+};
+
+std::string Extension(const std::string& path)
+{
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+// Every file below directory
+void ListFiles(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA((directory + "/*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        std::string name = entry.cFileName;
+        if (name == "." || name == "..")
+            continue;
+        if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            ListFiles(directory + "/" + name, files);
+        else
+            files.push_back(directory + "/" + name);
+    }
+    while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent* entry = readdir(dir))
+    {
+        std::string name = entry->d_name, path = directory + "/" + name;
+        struct stat info;
+        if (name == "." || name == ".." || stat(path.c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+            ListFiles(path, files);
+        else
+            files.push_back(path);
+    }
+    closedir(dir);
+#endif
+}
+
+bool ReadFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    bool read = !data.empty() && fread(&data[0], 1, data.size(), file) == data.size();
+    fclose(file);
+    return read;
+}
+
+// Decodes all images, returns MPixels/s averaged over enough rounds to take ~0.5 s
+GLdouble TimeDecoding(const std::vector<EncodedImage>& images, GLdouble pixels)
+{
+    GLuint rounds = 0;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    GLdouble elapsed = 0.0;
+    while (elapsed < 0.5)
+    {
+        for (GLuint i = 0; i < images.size(); i++)
+        {
+            int width, height, channels;
+            stbi_image_free(stbi_load_from_memory(&images[i].Data[0], images[i].Data.size(), &width, &height, &channels, 0));
+        }
+        rounds++;
+        elapsed = std::chrono::duration<GLdouble>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    return pixels * rounds / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string directory = argc > 1 ? argv[1] : "resources";
+    std::vector<std::string> files;
+    ListFiles(directory, files);
+    std::sort(files.begin(), files.end());
+    if (!stbi_enable_SIMD(1))
+        std::cout << "No SSE2 in this build, comparing the scalar decoder with itself" << std::endl;
+
+    const GLchar* formats[] = { "jpg", "png" };
+    for (GLuint format = 0; format < 2; format++)
+    {
+        std::vector<EncodedImage> images;
+        GLdouble pixels = 0.0;
+        for (GLuint i = 0; i < files.size(); i++)
+        {
+            std::string extension = Extension(files[i]);
+            if (extension != formats[format] && !(format == 0 && extension == "jpeg"))
+                continue;
+            EncodedImage image;
+            image.Path = files[i];
+            if (!ReadFile(files[i], image.Data))
+                continue;
+            // The scalar decoder is the reference, for every channel count SOIL can ask for
+            bool decoded = true;
+            for (int channels = 0; channels <= 4 && decoded; channels++)
+            {
+                int width, height, sourceChannels, simdWidth, simdHeight, simdChannels;
+                stbi_enable_SIMD(0);
+                unsigned char* reference = stbi_load_from_memory(&image.Data[0], image.Data.size(), &width, &height, &sourceChannels, channels);
+                stbi_enable_SIMD(1);
+                unsigned char* simd = stbi_load_from_memory(&image.Data[0], image.Data.size(), &simdWidth, &simdHeight, &simdChannels, channels);
+                decoded = reference != NULL;
+                if (decoded && (!simd || simdWidth != width || simdHeight != height
+                                || memcmp(reference, simd, width * height * (channels ? channels : sourceChannels)) != 0))
+                {
+                    std::cout << "ERROR::BENCHMARK:: SIMD output differs for " << image.Path << " with " << channels << " channels" << std::endl;
+                    return 1;
+                }
+                image.Width = width;
+                image.Height = height;
+                stbi_image_free(reference);
+                stbi_image_free(simd);
+            }
+            if (!decoded)
+            {
+                std::cout << "Skipping " << image.Path << ": " << stbi_failure_reason() << std::endl;
+                continue;
+            }
+            pixels += image.Width * image.Height;
+            images.push_back(image);
+        }
+        if (images.empty())
+            continue;
+
+        std::cout << formats[format] << ": " << images.size() << " images, " << pixels / 1e6 << " MPixels, output identical" << std::endl;
+        stbi_enable_SIMD(0);
+        GLdouble scalar = TimeDecoding(images, pixels);
+        stbi_enable_SIMD(1);
+        GLdouble simd = TimeDecoding(images, pixels);
+        std::cout << "  scalar: " << scalar << " MPixels/s" << std::endl;
+        std::cout << "  SSE2:   " << simd << " MPixels/s (" << simd / scalar << "x)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Std. Includes
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// GLM Mathemtics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/tile_binning.h>
+
+// Standalone benchmark of the CPU tile binning of the tiled deferred path (includes/learnopengl/tile_binning.h).
+// Needs no window or GL context: the depth bounds of the tiles are synthesized (a floor plane receding into the
+// distance plus some closer objects) and the lights are scattered through the view frustum.
+// Usage: tile_binning [width height] (default 1280 720)
+
+const GLfloat NEAR_PLANE = 0.1f, FAR_PLANE = 100.0f;
+
+GLfloat Random(GLfloat min, GLfloat max)
+{
+    return min + (rand() / (GLfloat)RAND_MAX) * (max - min);
+}
+
+// Milliseconds per Bin() averaged over enough iterations to take ~0.2 s
+GLdouble TimeBinning(TileBinner& binner, const std::vector<glm::vec4>& lights, const std::vector<GLfloat>& depthBounds)
+{
+    binner.Bin(lights, &depthBounds[0]); // Warm up the scratch buffers
+    GLuint iterations = 0;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    GLdouble elapsed = 0.0;
+    while (elapsed < 200.0)
+    {
+        binner.Bin(lights, &depthBounds[0]);
+        iterations++;
+        elapsed = std::chrono::duration<GLdouble, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    return elapsed / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    GLuint width = argc > 2 ? atoi(argv[1]) : 1280;
+    GLuint height = argc > 2 ? atoi(argv[2]) : 720;
+    srand(1);
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)width / (GLfloat)height, NEAR_PLANE, FAR_PLANE);
+    TileBinner binner(width, height);
+    binner.SetProjection(projection);
+
+    // Synthetic depth bounds: the top third of the screen is sky, below it the depth grows towards the horizon,
+    // with every fifth tile column holding something close by
+    std::vector<GLfloat> depthBounds(binner.TilesX * binner.TilesY * 2);
+    for (GLuint y = 0; y < binner.TilesY; y++)
+        for (GLuint x = 0; x < binner.TilesX; x++)
+        {
+            GLuint tile = y * binner.TilesX + x;
+            GLfloat horizon = (GLfloat)y / binner.TilesY;
+            if (horizon > 0.66f)
+            {
+                depthBounds[tile * 2] = FAR_PLANE;
+                depthBounds[tile * 2 + 1] = 0.0f;
+                continue;
+            }
+            GLfloat distance = 2.0f / (0.7f - horizon);
+            depthBounds[tile * 2] = x % 5 == 0 ? distance * 0.3f : distance * 0.95f;
+            depthBounds[tile * 2 + 1] = distance * 1.05f;
+        }
+
+    std::cout << width << "x" << height << ", " << binner.TilesX << "x" << binner.TilesY << " tiles of " << binner.TileSize
+              << " pixels, up to " << binner.ThreadCount << " threads" << std::endl;
+    GLuint lightCounts[] = { 64, 256, 1024, 4096, 16384 };
+    for (GLuint c = 0; c < 5; c++)
+    {
+        // Lights inside the view frustum (view space), radius 1 to 4
+        std::vector<glm::vec4> lights(lightCounts[c]);
+        for (GLuint i = 0; i < lights.size(); i++)
+        {
+            GLfloat depth = Random(1.0f, 40.0f);
+            GLfloat halfHeight = depth * std::tan(glm::radians(22.5f)), halfWidth = halfHeight * width / height;
+            lights[i] = glm::vec4(Random(-halfWidth, halfWidth), Random(-halfHeight, halfHeight), -depth, Random(1.0f, 4.0f));
+        }
+
+        // The scalar and SIMD kernels, single and multithreaded, have to produce the same lists
+        binner.ThreadCount = 1;
+        binner.UseSIMD = GL_FALSE;
+        binner.Bin(lights, &depthBounds[0]);
+        std::vector<GLuint> scalarGrid = binner.Grid;
+        std::vector<GLushort> scalarIndices = binner.Indices;
+        for (GLuint threads = 1; threads <= 4; threads *= 4)
+        {
+            binner.ThreadCount = threads;
+            binner.UseSIMD = GL_TRUE;
+            binner.Bin(lights, &depthBounds[0]);
+            if (binner.Grid != scalarGrid || binner.Indices != scalarIndices)
+            {
+                std::cout << "ERROR::BENCHMARK:: Scalar and SIMD binning differ for " << lights.size() << " lights on " << threads << " threads" << std::endl;
+                return 1;
+            }
+        }
+        binner.ThreadCount = 1;
+
+        std::cout << lights.size() << " lights, " << binner.IndexCount() / (GLfloat)(binner.TilesX * binner.TilesY)
+                  << " per tile on average, " << binner.MaxTileLights << " at most" << std::endl;
+        binner.UseSIMD = GL_FALSE;
+        std::cout << "  scalar, 1 thread:  " << TimeBinning(binner, lights, depthBounds) << " ms" << std::endl;
+        binner.UseSIMD = GL_TRUE;
+        std::cout << "  SIMD,   1 thread:  " << TimeBinning(binner, lights, depthBounds) << " ms" << std::endl;
+        binner.ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        std::cout << "  SIMD, " << binner.ThreadCount << " threads: " << TimeBinning(binner, lights, depthBounds) << " ms" << std::endl;
+    }
+    return 0;
+}